@@ -8,6 +8,8 @@ import { IGateDeviceService } from './gate-device.interface';
 
 export interface McuCallResult {
     ok: true;
+    // Set when the device deferred the open to the end of its cooldown (estimated, ms)
+    scheduledAt?: number;
 }
 
 export interface McuCallMetadata {
@@ -0,0 +1,129 @@
+/**
+ * Compact binary framing for gate commands and ACKs (see docs/mqtt-protocol.md).
+ * Byte 0 is the version, byte 1 the command/status code and bytes 2..17 the
+ * requestId UUID in every version. An ACK may end with optional trailer fields
+ * (tag byte + unsigned varint); unknown tags are skipped.
+ */
+
+export const BINARY_PROTOCOL_VERSION = 0x01;
+
+const UUID_LENGTH = 16;
+const ACK_LENGTH = 2 + UUID_LENGTH;
+
+const COMMAND_CODES: Record<string, number> = {
+    open: 0x01,
+};
+
+// ACK status byte: 0 = ok, otherwise index + 1; 0xff = error code not in the table
+const ACK_ERROR_CODES = [
+    'BAD_PAYLOAD',
+    'UNKNOWN_COMMAND',
+    'COOLDOWN',
+    'RELAY_FAIL',
+];
+const ACK_STATUS_OK = 0x00;
+const ACK_STATUS_OTHER = 0xff;
+
+const ACK_TAG_RETRY_AFTER_MS = 0x01;
+const ACK_TAG_SCHEDULED_AT = 0x02;
+
+function uuidToBytes(uuid: string): Buffer {
+    const hex = uuid.replace(/-/g, '');
+    if (!/^[0-9a-fA-F]{32}$/.test(hex)) {
+        throw new Error(`requestId is not a UUID: ${uuid}`);
+    }
+    return Buffer.from(hex, 'hex');
+}
+
+function bytesToUuid(bytes: Buffer): string {
+    const hex = bytes.toString('hex');
+    return `${hex.slice(0, 8)}-${hex.slice(8, 12)}-${hex.slice(12, 16)}-${hex.slice(16, 20)}-${hex.slice(20)}`;
+}
+
+// Unsigned LEB128 (values up to 2^53, enough for millisecond timestamps)
+function encodeVarint(value: number): Buffer {
+    const bytes: number[] = [];
+    let remaining = value;
+    while (remaining >= 0x80) {
+        bytes.push((remaining % 0x80) | 0x80);
+        remaining = Math.floor(remaining / 0x80);
+    }
+    bytes.push(remaining);
+    return Buffer.from(bytes);
+}
+
+function decodeVarint(
+    frame: Buffer,
+    offset: number,
+): { value: number; next: number } {
+    let value = 0;
+    let scale = 1;
+    for (let i = offset; i < frame.length; i++) {
+        value += (frame[i] & 0x7f) * scale;
+        if ((frame[i] & 0x80) === 0) {
+            return { value, next: i + 1 };
+        }
+        scale *= 0x80;
+    }
+    throw new Error('Truncated varint in binary ACK');
+}
+
+export function encodeBinaryCommand(command: {
+    requestId: string;
+    command: string;
+    userId: string;
+    issuedAt: number;
+}): Buffer {
+    const code = COMMAND_CODES[command.command];
+    if (code === undefined) {
+        throw new Error(`No binary code for command: ${command.command}`);
+    }
+    const userId = Buffer.from(command.userId, 'utf8');
+    return Buffer.concat([
+        Buffer.from([BINARY_PROTOCOL_VERSION, code]),
+        uuidToBytes(command.requestId),
+        encodeVarint(command.issuedAt),
+        encodeVarint(userId.length),
+        userId,
+    ]);
+}
+
+export function decodeBinaryAck(frame: Buffer): {
+    requestId: string;
+    ok: boolean;
+    errorCode?: string;
+    retryAfterMs?: number;
+    scheduledAt?: number;
+} {
+    if (frame.length < ACK_LENGTH) {
+        throw new Error(`Binary ACK too short: ${frame.length} bytes`);
+    }
+    if (frame[0] !== BINARY_PROTOCOL_VERSION) {
+        throw new Error(`Unsupported binary ACK version: ${frame[0]}`);
+    }
+    const status = frame[1];
+    const requestId = bytesToUuid(frame.subarray(2, ACK_LENGTH));
+
+    let retryAfterMs: number | undefined;
+    let scheduledAt: number | undefined;
+    let offset = ACK_LENGTH;
+    while (offset < frame.length) {
+        const tag = frame[offset];
+        const field = decodeVarint(frame, offset + 1);
+        if (tag === ACK_TAG_RETRY_AFTER_MS) {
+            retryAfterMs = field.value;
+        } else if (tag === ACK_TAG_SCHEDULED_AT) {
+            scheduledAt = field.value;
+        }
+        offset = field.next;
+    }
+
+    if (status === ACK_STATUS_OK) {
+        return { requestId, ok: true, scheduledAt };
+    }
+    const errorCode =
+        status === ACK_STATUS_OTHER
+            ? 'UNKNOWN_ERROR'
+            : (ACK_ERROR_CODES[status - 1] ?? 'UNKNOWN_ERROR');
+    return { requestId, ok: false, errorCode, retryAfterMs };
+}
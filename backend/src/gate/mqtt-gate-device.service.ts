@@ -16,6 +16,7 @@ import { DeviceStatus } from './schemas/device-status.schema';
 import {
     DeviceDiagnosticLog,
 } from './schemas/device-diagnostic-log.schema';
+import { decodeBinaryAck, encodeBinaryCommand } from './mqtt-binary-codec';
 
 interface MqttCommandMessage {
     requestId: string;
@@ -28,6 +29,21 @@ interface MqttAckMessage {
     requestId: string;
     ok: boolean;
     errorCode?: string;
+    retryAfterMs?: number;
+    scheduledAt?: number;
+}
+
+/**
+ * The device answered with an error ACK (as opposed to a transport failure).
+ */
+class McuRejectedException extends BadGatewayException {
+    constructor(
+        message: string,
+        readonly errorCode?: string,
+        readonly retryAfterMs?: number,
+    ) {
+        super(message);
+    }
 }
 
 interface PendingRequest {
@@ -54,6 +70,9 @@ export class MqttGateDeviceService
     private readonly ackTopic: string;
     private readonly statusTopic: string;
     private readonly diagnosticsTopic: string;
+    private readonly binaryEncoding: boolean;
+    private readonly cmdBinTopic: string;
+    private readonly ackBinTopic: string;
     private readonly pendingRequests = new Map<string, PendingRequest>();
     private isConnected = false;
     private connectionPromise: Promise<void> | null = null;
@@ -91,6 +110,12 @@ export class MqttGateDeviceService
         this.diagnosticsTopic =
             this.configService.get<string>('MQTT_DIAGNOSTICS_TOPIC') ||
             'pgr/mitspe6/gate/diagnostics';
+        // 'binary' sends commands on <cmd>/bin; the device answers on <ack>/bin
+        this.binaryEncoding =
+            this.configService.get<string>('MQTT_CMD_ENCODING', 'json') ===
+            'binary';
+        this.cmdBinTopic = `${this.cmdTopic}/bin`;
+        this.ackBinTopic = `${this.ackTopic}/bin`;
     }
 
     async onModuleInit() {
@@ -119,6 +144,8 @@ export class MqttGateDeviceService
                     username: this.mqttUsername,
                     password: this.mqttPassword,
                     clientId: `pgr-server-${Date.now()}`,
+                    // MQTT 5 for per-message expiry on commands
+                    protocolVersion: 5,
                     reconnectPeriod: 5000,
                     connectTimeout: 10000,
                     rejectUnauthorized: false, // Accept self-signed certificates for MQTT TLS
@@ -131,6 +158,7 @@ export class MqttGateDeviceService
 
                     const topics = {
                         [this.ackTopic]: { qos: 1 },
+                        [this.ackBinTopic]: { qos: 1 },
                         [this.statusTopic]: { qos: 1 },
                         [this.diagnosticsTopic]: { qos: 1 },
                     };
@@ -153,16 +181,19 @@ export class MqttGateDeviceService
                             return;
                         }
                         this.logger.log(
-                            `Subscribed to topics: ${this.ackTopic}, ${this.statusTopic}, ${this.diagnosticsTopic}`,
+                            `Subscribed to topics: ${this.ackTopic}, ${this.ackBinTopic}, ${this.statusTopic}, ${this.diagnosticsTopic}`,
                         );
                         resolve();
                     });
                 });
 
                 // eslint-disable-next-line @typescript-eslint/no-unsafe-call, @typescript-eslint/no-unsafe-member-access
-                this.client.on('message', (topic: string, message: Buffer) => {
-                    this.handleMessage(topic, message);
-                });
+                this.client.on(
+                    'message',
+                    (topic: string, message: Buffer, packet: { retain?: boolean }) => {
+                        this.handleMessage(topic, message, packet?.retain === true);
+                    },
+                );
 
                 // eslint-disable-next-line @typescript-eslint/no-unsafe-call, @typescript-eslint/no-unsafe-member-access
                 this.client.on('error', (error: Error) => {
@@ -227,15 +258,20 @@ export class MqttGateDeviceService
         }
     }
 
-    private handleMessage(topic: string, message: Buffer): void {
+    private handleMessage(topic: string, message: Buffer, retained = false): void {
         try {
+            if (topic === this.ackBinTopic) {
+                this.handleAckMessage(decodeBinaryAck(message));
+                return;
+            }
+
             // eslint-disable-next-line @typescript-eslint/no-unsafe-assignment
             const payload = JSON.parse(message.toString());
 
             if (topic === this.ackTopic) {
                 this.handleAckMessage(payload as MqttAckMessage);
             } else if (topic === this.statusTopic) {
-                this.handleStatusMessage(payload).catch((error) => {
+                this.handleStatusMessage(payload, retained).catch((error) => {
                     this.logger.error(
                         `Unhandled error in handleStatusMessage: ${error}`,
                     );
@@ -268,22 +304,48 @@ export class MqttGateDeviceService
 
         if (ack.ok) {
             const duration = Date.now() - pending.startTime;
+            const deferred = ack.scheduledAt
+                ? `, deferred until ${new Date(ack.scheduledAt).toISOString()}`
+                : '';
             this.logger.log(
-                `Received ACK for requestId ${ack.requestId} (duration: ${duration}ms)`,
+                `Received ACK for requestId ${ack.requestId} (duration: ${duration}ms${deferred})`,
+            );
+            pending.resolve(
+                ack.scheduledAt
+                    ? { ok: true, scheduledAt: ack.scheduledAt }
+                    : { ok: true },
             );
-            pending.resolve({ ok: true });
         } else {
-            const errorMsg = ack.errorCode
+            let errorMsg = ack.errorCode
                 ? `MCU error: ${ack.errorCode}`
                 : 'MCU returned error';
+            if (ack.retryAfterMs) {
+                errorMsg += ` (retry after ${ack.retryAfterMs}ms)`;
+            }
             this.logger.warn(
                 `Received error ACK for requestId ${ack.requestId}: ${errorMsg}`,
             );
-            pending.reject(new BadGatewayException(errorMsg));
+            pending.reject(
+                new McuRejectedException(
+                    errorMsg,
+                    ack.errorCode,
+                    ack.retryAfterMs,
+                ),
+            );
         }
     }
 
-    private async handleStatusMessage(status: unknown): Promise<void> {
+    /**
+     * Presence: the device publishes a retained birth status on connect and the
+     * broker publishes its Last Will (online:false) when the link drops. A
+     * retained message is delivered on (re)subscribe and may be old (a birth
+     * replayed after the Will fired), so it does not count as the device being
+     * seen and only fills in presence for a device we have no record of.
+     */
+    private async handleStatusMessage(
+        status: unknown,
+        retained = false,
+    ): Promise<void> {
         try {
             this.logger.debug(`Received status message: ${JSON.stringify(status)}`);
 
@@ -293,6 +355,9 @@ export class MqttGateDeviceService
                 updatedAt?: number;
                 rssi?: number;
                 fwVersion?: string;
+                errors?: number;
+                outboxDepth?: number;
+                outboxAgeMs?: number;
                 [key: string]: unknown;
             };
 
@@ -309,18 +374,51 @@ export class MqttGateDeviceService
                 return;
             }
 
+            // The device sends only changed fields (and bare heartbeats), so
+            // merge into the stored status; every live message refreshes
+            // presence and lastSeenAt.
+            const presence: Record<string, unknown> = {
+                online: statusPayload.online,
+                updatedAt: statusPayload.updatedAt,
+            };
+            const update: Record<string, unknown> = {
+                deviceId: statusPayload.deviceId,
+            };
+            if (!retained) {
+                Object.assign(update, presence);
+                update.lastSeenAt = new Date();
+            }
+            if (typeof statusPayload.rssi === 'number') {
+                update.rssi = statusPayload.rssi;
+            }
+            if (typeof statusPayload.fwVersion === 'string') {
+                update.fwVersion = statusPayload.fwVersion;
+            }
+            if (typeof statusPayload.errors === 'number') {
+                update.errors = statusPayload.errors;
+            }
+            if (typeof statusPayload.outboxDepth === 'number') {
+                update.outboxDepth = statusPayload.outboxDepth;
+            }
+            if (typeof statusPayload.outboxAgeMs === 'number') {
+                update.outboxAgeMs = statusPayload.outboxAgeMs;
+            }
+            for (const [key, value] of Object.entries(statusPayload)) {
+                if (retained && key in presence) {
+                    continue;
+                }
+                update[`raw.${key}`] = value;
+            }
+
             // Upsert device status
             await this.deviceStatusModel.findOneAndUpdate(
                 { deviceId: statusPayload.deviceId },
-                {
-                    deviceId: statusPayload.deviceId,
-                    online: statusPayload.online,
-                    updatedAt: statusPayload.updatedAt,
-                    lastSeenAt: new Date(),
-                    rssi: statusPayload.rssi,
-                    fwVersion: statusPayload.fwVersion,
-                    raw: statusPayload,
-                },
+                retained
+                    ? {
+                          $set: update,
+                          $setOnInsert: { ...presence, lastSeenAt: new Date(0) },
+                      }
+                    : { $set: update },
                 { upsert: true, new: true },
             );
 
@@ -468,6 +566,14 @@ export class MqttGateDeviceService
                     throw error;
                 }
 
+                if (
+                    error instanceof McuRejectedException &&
+                    error.errorCode === 'COOLDOWN'
+                ) {
+                    // An immediate retry would land in the same cooldown
+                    throw error;
+                }
+
                 // For other errors, continue to retry if attempts remain
                 if (attempt < this.retryCount) {
                     this.logger.warn(
@@ -525,11 +631,28 @@ export class MqttGateDeviceService
 
             this.pendingRequests.set(requestId, pending);
 
+            const topic = this.binaryEncoding ? this.cmdBinTopic : this.cmdTopic;
+            const payload = this.binaryEncoding
+                ? encodeBinaryCommand(command)
+                : JSON.stringify(command);
+
+            // The device keeps a persistent session, so the broker queues commands
+            // while it is offline. Expire them with this attempt: a command that
+            // arrives after we gave up must not open the gate.
             // eslint-disable-next-line @typescript-eslint/no-unsafe-call, @typescript-eslint/no-unsafe-member-access
             this.client.publish(
-                this.cmdTopic,
-                JSON.stringify(command),
-                { qos: 1, retain: false },
+                topic,
+                payload,
+                {
+                    qos: 1,
+                    retain: false,
+                    properties: {
+                        messageExpiryInterval: Math.max(
+                            1,
+                            Math.ceil(this.timeoutMs / 1000),
+                        ),
+                    },
+                },
                 (error?: Error) => {
                     if (error) {
                         clearTimeout(timeout);
@@ -551,7 +674,7 @@ export class MqttGateDeviceService
                     }
 
                     this.logger.log(
-                        `Published command '${command.command}' for requestId ${requestId} to topic ${this.cmdTopic}`,
+                        `Published command '${command.command}' for requestId ${requestId} to topic ${topic}`,
                     );
                 },
             );
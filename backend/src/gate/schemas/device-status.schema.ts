@@ -23,6 +23,15 @@ export class DeviceStatus {
     @Prop({ required: false })
     fwVersion?: string;
 
+    @Prop({ required: false })
+    errors?: number;
+
+    @Prop({ required: false })
+    outboxDepth?: number;
+
+    @Prop({ required: false })
+    outboxAgeMs?: number;
+
     @Prop({ type: Object, required: false })
     raw?: Record<string, unknown>;
 }
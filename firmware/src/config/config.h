@@ -9,14 +9,34 @@
 #define MQTT_PORT 8883  // TLS port
 #define MQTT_USERNAME "pgr_device_mitspe6"  // Production device user
 #define MQTT_PASSWORD "Avivr_121"
+// The broker publishes the Last Will (online:false on the status topic) after
+// about 1.5 keepalive intervals without traffic
+#define MQTT_KEEPALIVE_S 60
+#define MQTT_CONNECT_TIMEOUT_MS 30000
+// Stable client ID with a persistent session (clean session off): the broker
+// keeps the QoS 1 subscription and queues commands while the link is down
+#define MQTT_CLIENT_ID "pgr_device_" DEVICE_ID
 
 // MQTT Topics
 #define MQTT_CMD_TOPIC "pgr/mitspe6/gate/cmd"
 #define MQTT_ACK_TOPIC "pgr/mitspe6/gate/ack"
 #define MQTT_STATUS_TOPIC "pgr/mitspe6/gate/status"
-
-// Status Heartbeat Interval (milliseconds)
+// Boot timing report, published once per boot on first MQTT connect
+#define MQTT_BOOT_TOPIC "pgr/mitspe6/gate/boot"
+// Compact binary framing (docs/mqtt-protocol.md): commands arriving on the /bin
+// topic are ACKed in binary on the ACK /bin topic; the JSON topics stay active
+#define MQTT_BINARY_ENABLED 1
+#define MQTT_CMD_BIN_TOPIC "pgr/mitspe6/gate/cmd/bin"
+#define MQTT_ACK_BIN_TOPIC "pgr/mitspe6/gate/ack/bin"
+
+// Status: checked every STATUS_INTERVAL_MS and published only on change, plus a
+// bare heartbeat every STATUS_LIVENESS_MS (must stay under the backend's 60 s staleness
+// window). The Last Will only covers a lost link: the modem answers the broker's
+// keepalive itself, so a hung MCU is detected by the missing heartbeat alone.
 #define STATUS_INTERVAL_MS 5000
+#define STATUS_LIVENESS_MS 45000
+#define STATUS_RSSI_SAMPLE_MS 30000  // AT+CSQ occupies the modem UART
+#define STATUS_RSSI_BUCKET_DB 10     // RSSI changes within a bucket are not reported
 
 // Recovery Thresholds
 #define MQTT_FAILS_BEFORE_PPP_REBUILD 3
@@ -31,12 +51,23 @@
 #define BACKOFF_BASE_MS 1000
 #define BACKOFF_MAX_MS 60000
 
-// Cold boot: delay before starting modem init (let power rail stabilize)
-#define COLD_BOOT_DELAY_MS 4000
+// Cold boot: delay before starting modem init (let power rail stabilize).
+// Modem readiness is detected from RDY / AT responses, so this only needs to
+// cover the ESP32 side; MODEM_POWER_STABLE_MS covers the modem rail.
+#define COLD_BOOT_DELAY_MS 500
 
 // Modem power stable delay after BOARD_POWERON HIGH, before reset sequence (optional)
 #define MODEM_POWER_STABLE_MS 2000
 
+// Readiness-driven modem boot: probe AT while waiting for RDY, give up waiting after max
+#define MODEM_AT_PROBE_TIMEOUT_MS 300
+#define MODEM_AT_PROBE_INTERVAL_MS 500
+#define MODEM_BOOT_MAX_WAIT_MS 15000
+
+// Warm reboot: after an ESP32-only reset (OOB reboot, panic, watchdog) reuse the
+// modem, data session and modem MQTT client recorded in RTC memory when still valid
+#define WARM_BOOT_ENABLED 1
+
 // Modem init retry cap: max powerCycle retries before backing off
 #define MODEM_INIT_MAX_RETRIES 5
 #define MODEM_INIT_BACKOFF_MS 60000
@@ -61,9 +92,47 @@
 // AT Command Timeouts (milliseconds)
 #define AT_CMD_TIMEOUT_MS 5000
 #define AT_INIT_TIMEOUT_MS 30000
+// Modem UART reader (modem/ModemStream.h): bulk RX buffer, longest line kept
+// (longer URCs are ignored, longer response lines truncated), CMQTT client slots tracked
+#define MODEM_RX_BUFFER 256
+#define MODEM_LINE_MAX 128
+#define MODEM_MQTT_CLIENTS 2
+// AT command queue (modem/AtQueue.h): commands waiting or in flight, longest command
+#define MODEM_AT_QUEUE_LEN 8
+#define MODEM_AT_CMD_MAX 48
+// UART rate negotiation after handshake (AT+IPR). The modem does not keep the rate
+// across a reset, so it always boots at MODEM_UART_BAUD. Rates are tried fastest
+// first; one that fails the round-trip check or keeps producing framing errors
+// is not tried again (persisted in NVS).
+#define MODEM_BAUD_NEGOTIATE 1
+#define MODEM_BAUD_RATES {921600, 460800, 230400}
+#define MODEM_BAUD_VERIFY_ROUNDS 3          // ATI round trips that must all succeed
+#define MODEM_BAUD_ERROR_LIMIT 8            // framing/parity errors per window before falling back
+#define MODEM_BAUD_ERROR_WINDOW_MS 60000
+// CMUX (modem/Cmux.h): after init the UART is multiplexed (AT+CMUX=0) into a channel
+// for TinyGSM (URCs, MQTT, PPP setup) and one for the AT queue and OOB HTTPS, so a
+// long HTTPS transfer does not swallow or hold up MQTT traffic. Falls back to the
+// plain UART for the rest of the boot if the modem refuses or a channel does not open.
+#define MODEM_CMUX_ENABLED 1
+#define CMUX_CHANNELS 2
+#define CMUX_DLCI_MAIN 1
+#define CMUX_DLCI_AUX 2
+#define CMUX_FRAME_MAX 31                   // N1 we send (AT+CMUX=0 default)
+#define CMUX_FRAME_MAX_RX 128               // longest frame accepted
+#define CMUX_CHANNEL_RX 1024                // per channel receive ring (flow control at 3/4)
+#define CMUX_OPEN_TIMEOUT_MS 3000
 
 // PPP Configuration
 #define PPP_TIMEOUT_MS 60000
+// Bring-up stages (ppp/PppSession.h); registration is bounded by PPP_TIMEOUT_MS
+#define PPP_REG_POLL_MS 1000                // AT+CREG? while no +CREG URC says registered
+#define PPP_APN_RETRY_MS 1000
+#define PPP_NETOPEN_TIMEOUT_MS 10000        // AT+NETOPEN until its +NETOPEN result
+#define PPP_ACTIVATE_RETRY_MS 3000
+#define PPP_ACTIVATE_MAX_ATTEMPTS 3
+// IP assignment is polled after network activation (no fixed post-activation sleep)
+#define PPP_IP_POLL_INTERVAL_MS 500
+#define PPP_IP_MAX_WAIT_MS 15000
 
 // Cellular APN Configuration (Cellcom Israel)
 #define CELLULAR_APN "sphone"  // Alternative: "sphone"
@@ -95,11 +164,79 @@
 
 // Gate Control Configuration
 #define GATE_COOLDOWN_MS 8000
-#define DEDUP_CACHE_SIZE 20
+// Opens requested in the last GATE_DEFER_WINDOW_MS of the cooldown are coalesced into
+// one deferred open at cooldown end instead of a COOLDOWN reject; they are ACKed once it
+// has run (keep the window under the backend's MCU_TIMEOUT_MS). At most
+// GATE_DEFER_MAX_ACKS requests wait for it, later ones get COOLDOWN.
+// Opens requested while the relay pulse is running are coalesced into that pulse.
+#define GATE_DEFER_WINDOW_MS 3000
+#define GATE_DEFER_MAX_ACKS 8
+// Dedupe (idempotency) cache: hash set in RTC memory, survives ESP32-only resets.
+// 128 slots x 5 bytes; kept at most 75% full so lookups stay short.
+#define DEDUP_TABLE_SLOTS 128
+#define DEDUP_MAX_ENTRIES 96
+#define DEDUP_TTL_S 600
+#define DEDUP_SWEEP_INTERVAL_S 60
+#define DEDUP_STAMP_UNIT_S 8
+
+// FreeRTOS task layout: modem/PPP/MQTT work on core 0, gate commands on core 1
+// so command-to-relay latency does not depend on modem recovery work.
+#define NETWORK_TASK_CORE 0
+#define NETWORK_TASK_STACK 8192
+#define NETWORK_TASK_PRIORITY 1
+#define GATE_TASK_CORE 1
+#define GATE_TASK_STACK 4096
+#define GATE_TASK_PRIORITY 3
+// Cooperative scheduler (network task): timer wheel resolution and capacity
+#define SCHEDULER_TICK_MS 10
+#define SCHEDULER_WHEEL_SLOTS 64
+#define SCHEDULER_MAX_TASKS 16
+// Max time the network task sleeps between passes (bounds modem drain latency)
+#define NETWORK_LOOP_IDLE_MS 10
+
+// Lock-free SPSC queue depths between the tasks (must be powers of two)
+#define GATE_COMMAND_QUEUE_LEN 8
+#define GATE_ACK_QUEUE_LEN 8
+
+// MQTT receive pool: commands are copied into one of these preallocated slots and
+// the slot is handed to the gate task. Larger payloads are rejected and counted.
+#define MQTT_RX_POOL_SLOTS GATE_COMMAND_QUEUE_LEN
+#define MQTT_RX_MAX_PAYLOAD 256
+
+// Outbound queue (mqtt/Outbox.h): ACKs and diagnostics are queued and sent in order
+// once connected, oldest first, high priority (ACKs) before low (diagnostics).
+// A message leaves the queue only after the modem confirms the publish.
+#define OUTBOX_PAYLOAD_MAX 512
+#define OUTBOX_SLOTS_HIGH 8
+#define OUTBOX_SLOTS_LOW 1       // one diagnostics batch in flight; the journal holds the rest
+#define OUTBOX_FLUSH_BATCH 4     // publishes per network loop pass
+#define OUTBOX_MAX_ATTEMPTS 5    // failed publishes before a message is dropped
+// ACKs that do not fit in RAM are journaled to NVS (and survive a reboot)
+#define OUTBOX_NVS_SPILL 1
+#define OUTBOX_NVS_SLOTS 16
+
+// Deferred logger (util/Log.h): entries below LOG_MIN_LEVEL are compiled out.
+// Records are queued in RAM and written to Serial by a low-priority task.
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#define LOG_RING_RECORDS 64
+#define LOG_RECORD_PAYLOAD 88
+#define LOG_TASK_CORE 1
+#define LOG_TASK_STACK 2048
+#define LOG_TASK_PRIORITY 0
+#define LOG_DRAIN_INTERVAL_MS 20
 
 // Diagnostic log (recovery events for backend upload)
 #define MQTT_DIAGNOSTICS_TOPIC "pgr/mitspe6/gate/diagnostics"
-#define DIAGNOSTIC_LOG_MAX_ENTRIES 32
+// Compact entries are packed into blocks: ~20 per block, a few hundred in total
+#define DIAG_BLOCK_COUNT 16
+#define DIAG_BLOCK_BYTES 114  // 128-byte block with its header
+// Journal commits: after this many pending entries, or once the oldest has waited this long
+#define DIAG_COMMIT_BATCH 4
+#define DIAG_COMMIT_INTERVAL_MS 5000
+// Background upload: one batch per tick while connected and the gate task is idle
+#define DIAG_UPLOAD_INTERVAL_MS 250
+#define DIAG_UPLOAD_BATCH 10
+#define DIAG_UPLOAD_DOC_SIZE 1024
 #define DIAGNOSTIC_LOG_ENABLED 1
 
 #endif // CONFIG_H
@@ -0,0 +1,229 @@
+#include "dedupe_cache.h"
+#include <string.h>
+#include "esp_timer.h"
+#include "protocol/Protocol.h"
+#include "util/Log.h"
+
+#define DEDUP_MAGIC 0x50554444UL  // "DDUP"
+#define DEDUP_SLOT_MASK (DEDUP_TABLE_SLOTS - 1)
+#define DEDUP_TTL_UNITS (DEDUP_TTL_S / DEDUP_STAMP_UNIT_S)
+
+static_assert((DEDUP_TABLE_SLOTS & (DEDUP_TABLE_SLOTS - 1)) == 0, "DEDUP_TABLE_SLOTS must be a power of two");
+static_assert(DEDUP_MAX_ENTRIES < DEDUP_TABLE_SLOTS, "Dedupe table needs free slots for probing");
+// 8-bit stamps: every live entry must be younger than 256 units (see maybeSweep)
+static_assert((DEDUP_TTL_S + DEDUP_SWEEP_INTERVAL_S) / DEDUP_STAMP_UNIT_S < 256, "Dedupe TTL too long for 8-bit stamps");
+
+// RTC_NOINIT_ATTR: survives esp_restart/panic/watchdog, garbage after power-on (checksum rejects it)
+struct DedupeTable {
+    uint32_t magic;
+    uint32_t clockSec;      // dedupe clock at the last update; the next boot continues from here
+    uint32_t lastSweepSec;
+    uint16_t count;
+    uint16_t reserved;
+    uint32_t fingerprints[DEDUP_TABLE_SLOTS];  // 0 = empty slot
+    uint8_t stamps[DEDUP_TABLE_SLOTS];         // insert time in DEDUP_STAMP_UNIT_S units (mod 256)
+    uint32_t checksum;
+};
+
+static RTC_NOINIT_ATTR DedupeTable table;
+static uint32_t clockBaseSec = 0;
+
+static uint32_t tableChecksum() {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&table);
+    uint32_t h = 2166136261UL;
+    for (size_t i = 0; i < offsetof(DedupeTable, checksum); i++) {
+        h ^= p[i];
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+static uint32_t mix32(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85EBCA6BUL;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35UL;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint8_t ageUnits(uint16_t index, uint32_t now) {
+    return (uint8_t)((uint8_t)(now / DEDUP_STAMP_UNIT_S) - table.stamps[index]);
+}
+
+void DedupeCache::init() {
+    bool valid = table.magic == DEDUP_MAGIC &&
+                 table.count <= DEDUP_MAX_ENTRIES &&
+                 table.checksum == tableChecksum();
+    if (valid) {
+        clockBaseSec = table.clockSec;
+        LOG(DEDUPE_RESTORED, table.count);
+    } else {
+        memset(&table, 0, sizeof(table));
+        table.magic = DEDUP_MAGIC;
+        clockBaseSec = 0;
+        seal();
+    }
+}
+
+bool DedupeCache::contains(const char* requestId) {
+    if (requestId == nullptr || requestId[0] == '\0') {
+        return false;
+    }
+    uint32_t now = nowSec();
+    maybeSweep(now);
+
+    int16_t index = find(fingerprint(requestId));
+    if (index < 0) {
+        return false;
+    }
+    if (ageUnits(index, now) >= DEDUP_TTL_UNITS) {
+        removeAt(index);
+        seal();
+        return false;
+    }
+    return true;
+}
+
+void DedupeCache::insert(const char* requestId) {
+    if (requestId == nullptr || requestId[0] == '\0') {
+        return;
+    }
+    uint32_t now = nowSec();
+    maybeSweep(now);
+
+    uint32_t fp = fingerprint(requestId);
+    uint8_t stamp = (uint8_t)(now / DEDUP_STAMP_UNIT_S);
+    int16_t existing = find(fp);
+    if (existing >= 0) {
+        table.stamps[existing] = stamp;
+    } else {
+        if (table.count >= DEDUP_MAX_ENTRIES) {
+            evictOldest(now);
+        }
+        uint16_t index = fp & DEDUP_SLOT_MASK;
+        while (table.fingerprints[index] != 0) {
+            index = (index + 1) & DEDUP_SLOT_MASK;
+        }
+        table.fingerprints[index] = fp;
+        table.stamps[index] = stamp;
+        table.count++;
+    }
+    table.clockSec = now;
+    seal();
+}
+
+uint16_t DedupeCache::size() {
+    return table.count;
+}
+
+uint32_t DedupeCache::fingerprint(const char* requestId) {
+    uint8_t uuid[PROTOCOL_BIN_UUID_LEN];
+    uint32_t h;
+    if (Protocol::parseUuid(requestId, uuid)) {
+        // Fold the 128-bit key (case and dashes don't matter)
+        uint32_t w[4];
+        memcpy(w, uuid, sizeof(w));
+        h = w[0] ^ ((w[1] << 8) | (w[1] >> 24)) ^ ((w[2] << 16) | (w[2] >> 16)) ^ ((w[3] << 24) | (w[3] >> 8));
+    } else {
+        // Not a UUID: hash the text (FNV-1a)
+        h = 2166136261UL;
+        for (const char* p = requestId; *p; p++) {
+            h ^= (uint8_t)*p;
+            h *= 16777619UL;
+        }
+    }
+    h = mix32(h);
+    return h != 0 ? h : 1;  // 0 marks an empty slot
+}
+
+uint32_t DedupeCache::nowSec() {
+    return clockBaseSec + (uint32_t)(esp_timer_get_time() / 1000000LL);
+}
+
+int16_t DedupeCache::find(uint32_t fp) {
+    uint16_t index = fp & DEDUP_SLOT_MASK;
+    for (uint16_t probes = 0; probes < DEDUP_TABLE_SLOTS; probes++) {
+        uint32_t slot = table.fingerprints[index];
+        if (slot == 0) {
+            return -1;
+        }
+        if (slot == fp) {
+            return index;
+        }
+        index = (index + 1) & DEDUP_SLOT_MASK;
+    }
+    return -1;
+}
+
+/**
+ * Delete by backward shift, so linear probing needs no tombstones.
+ */
+void DedupeCache::removeAt(uint16_t index) {
+    uint16_t hole = index;
+    uint16_t next = index;
+    table.fingerprints[hole] = 0;
+    for (;;) {
+        next = (next + 1) & DEDUP_SLOT_MASK;
+        uint32_t fp = table.fingerprints[next];
+        if (fp == 0) {
+            break;
+        }
+        // Entry stays if its home slot lies cyclically in (hole, next]
+        uint16_t home = fp & DEDUP_SLOT_MASK;
+        bool stays = (hole <= next) ? (hole < home && home <= next)
+                                    : (hole < home || home <= next);
+        if (!stays) {
+            table.fingerprints[hole] = fp;
+            table.stamps[hole] = table.stamps[next];
+            table.fingerprints[next] = 0;
+            hole = next;
+        }
+    }
+    table.count--;
+}
+
+void DedupeCache::evictOldest(uint32_t now) {
+    int16_t oldest = -1;
+    uint8_t oldestAge = 0;
+    for (uint16_t i = 0; i < DEDUP_TABLE_SLOTS; i++) {
+        if (table.fingerprints[i] != 0 && (oldest < 0 || ageUnits(i, now) > oldestAge)) {
+            oldest = i;
+            oldestAge = ageUnits(i, now);
+        }
+    }
+    if (oldest >= 0) {
+        removeAt(oldest);
+    }
+}
+
+/**
+ * Drop expired entries every DEDUP_SWEEP_INTERVAL_S (checked on each access).
+ * Keeps every live entry younger than TTL + sweep interval, so 8-bit stamps
+ * never wrap; after a longer idle gap everything has expired anyway.
+ */
+void DedupeCache::maybeSweep(uint32_t now) {
+    uint32_t sinceSweep = now - table.lastSweepSec;
+    if (sinceSweep < DEDUP_SWEEP_INTERVAL_S) {
+        return;
+    }
+
+    if (sinceSweep >= DEDUP_TTL_S + DEDUP_SWEEP_INTERVAL_S) {
+        memset(table.fingerprints, 0, sizeof(table.fingerprints));
+        table.count = 0;
+    } else {
+        for (uint16_t i = 0; i < DEDUP_TABLE_SLOTS; i++) {
+            // Re-check the same slot after a removal: backward shift may have filled it
+            while (table.fingerprints[i] != 0 && ageUnits(i, now) >= DEDUP_TTL_UNITS) {
+                removeAt(i);
+            }
+        }
+    }
+    table.lastSweepSec = now;
+    table.clockSec = now;
+    seal();
+}
+
+void DedupeCache::seal() {
+    table.checksum = tableChecksum();
+}
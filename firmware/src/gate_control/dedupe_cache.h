@@ -0,0 +1,48 @@
+#ifndef DEDUPE_CACHE_H
+#define DEDUPE_CACHE_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "config/config.h"
+
+/**
+ * Idempotency cache of processed requestIds.
+ * Open-addressed (linear probing) hash set of 32-bit fingerprints folded from
+ * the 128-bit binary UUID, each with an 8-bit coarse timestamp; entries expire
+ * after DEDUP_TTL_S (5 bytes per slot). Lives in RTC memory so it survives
+ * ESP32-only resets: a QoS1 redelivery after a reboot must not open the gate twice.
+ * Not thread-safe: used from the gate task only.
+ */
+class DedupeCache {
+public:
+    /**
+     * Restore the table from RTC memory if intact, otherwise start empty.
+     */
+    static void init();
+
+    /**
+     * Check if requestId is in the cache (and not expired).
+     */
+    static bool contains(const char* requestId);
+
+    /**
+     * Add requestId to the cache (evicts the oldest entry if full).
+     */
+    static void insert(const char* requestId);
+
+    /**
+     * Number of live entries.
+     */
+    static uint16_t size();
+
+private:
+    static uint32_t fingerprint(const char* requestId);
+    static uint32_t nowSec();
+    static int16_t find(uint32_t fp);
+    static void removeAt(uint16_t index);
+    static void evictOldest(uint32_t now);
+    static void maybeSweep(uint32_t now);
+    static void seal();
+};
+
+#endif // DEDUPE_CACHE_H
@@ -1,22 +1,27 @@
 #include "gate_control.h"
-#include <string.h>
+#include "dedupe_cache.h"
+#include "util/Log.h"
 
 uint32_t GateControl::lastOpenAtMs = 0;
-char GateControl::dedupeCache[DEDUP_CACHE_SIZE][37] = {0};
-uint8_t GateControl::dedupeCacheIndex = 0;
-uint8_t GateControl::dedupeCacheCount = 0;
+bool GateControl::openScheduled = false;
+uint32_t GateControl::scheduledOpenAtMs = 0;
+uint8_t GateControl::scheduledRequests = 0;
+volatile bool GateControl::actuating = false;
+volatile bool GateControl::pulseCompletePending = false;
+volatile uint32_t GateControl::lastPulseStartedAtMs = 0;
+volatile uint32_t GateControl::lastPulseEndedAtMs = 0;
 
 void GateControl::init() {
     lastOpenAtMs = 0;
-    dedupeCacheIndex = 0;
-    dedupeCacheCount = 0;
+    openScheduled = false;
+    scheduledRequests = 0;
+    actuating = false;
+    pulseCompletePending = false;
 
-    // Clear dedupe cache
-    for (uint8_t i = 0; i < DEDUP_CACHE_SIZE; i++) {
-        dedupeCache[i][0] = '\0';
-    }
+    // Dedupe entries from before an ESP32-only reset are kept
+    DedupeCache::init();
 
-    Serial.println("[GateControl] Initialized (cooldown and dedupe ready)");
+    LOG(GATECTL_INITIALIZED);
 }
 
 bool GateControl::canExecuteNow(uint32_t nowMs, uint32_t& remainingMs) {
@@ -41,30 +46,52 @@ bool GateControl::canExecuteNow(uint32_t nowMs, uint32_t& remainingMs) {
 
 void GateControl::recordOpen(uint32_t nowMs) {
     lastOpenAtMs = nowMs;
-    Serial.print("[GateControl] Recorded gate open at ");
-    Serial.print(nowMs);
-    Serial.print("ms (cooldown: ");
-    Serial.print(GATE_COOLDOWN_MS);
-    Serial.println("ms)");
+    actuating = true;
+    // Any open serves the requests waiting for a deferred one
+    openScheduled = false;
+    scheduledRequests = 0;
+    LOG(GATECTL_OPEN_RECORDED, nowMs, GATE_COOLDOWN_MS);
 }
 
-bool GateControl::wasProcessed(const char* requestId) {
-    if (requestId == nullptr || requestId[0] == '\0') {
-        return false;
+uint32_t GateControl::scheduleOpen(uint32_t nowMs) {
+    if (!openScheduled) {
+        openScheduled = true;
+        scheduledOpenAtMs = lastOpenAtMs + GATE_COOLDOWN_MS;
+        scheduledRequests = 0;
+        LOG(GATECTL_OPEN_SCHEDULED, msUntilScheduledOpen(nowMs));
+    }
+    if (scheduledRequests < 0xFF) {
+        scheduledRequests++;
     }
+    return scheduledOpenAtMs;
+}
 
-    // Check all entries in cache
-    uint8_t entriesToCheck = (dedupeCacheCount < DEDUP_CACHE_SIZE) ? dedupeCacheCount : DEDUP_CACHE_SIZE;
+bool GateControl::hasScheduledOpen() {
+    return openScheduled;
+}
 
-    for (uint8_t i = 0; i < entriesToCheck; i++) {
-        if (strcmp(dedupeCache[i], requestId) == 0) {
-            Serial.print("[GateControl] Dedupe hit: requestId ");
-            Serial.print(requestId);
-            Serial.println(" already processed");
-            return true;
-        }
+uint32_t GateControl::msUntilScheduledOpen(uint32_t nowMs) {
+    if (!openScheduled || (int32_t)(nowMs - scheduledOpenAtMs) >= 0) {
+        return 0;
+    }
+    return scheduledOpenAtMs - nowMs;
+}
+
+bool GateControl::takeScheduledOpen(uint32_t nowMs, uint8_t& requests) {
+    if (!openScheduled || (int32_t)(nowMs - scheduledOpenAtMs) < 0) {
+        return false;
     }
+    requests = scheduledRequests;
+    openScheduled = false;
+    scheduledRequests = 0;
+    return true;
+}
 
+bool GateControl::wasProcessed(const char* requestId) {
+    if (DedupeCache::contains(requestId)) {
+        LOG(GATECTL_DEDUPE_HIT, requestId);
+        return true;
+    }
     return false;
 }
 
@@ -73,22 +100,27 @@ void GateControl::markProcessed(const char* requestId) {
         return;
     }
 
-    // Copy requestId to cache (circular buffer)
-    strncpy(dedupeCache[dedupeCacheIndex], requestId, 36);
-    dedupeCache[dedupeCacheIndex][36] = '\0';  // Ensure null termination
+    DedupeCache::insert(requestId);
 
-    Serial.print("[GateControl] Marked requestId ");
-    Serial.print(requestId);
-    Serial.print(" as processed (cache index ");
-    Serial.print(dedupeCacheIndex);
-    Serial.println(")");
+    LOG(GATECTL_MARKED_PROCESSED, requestId, DedupeCache::size());
+}
 
-    // Advance circular buffer index
-    dedupeCacheIndex = (dedupeCacheIndex + 1) % DEDUP_CACHE_SIZE;
+void GateControl::onPulseComplete(uint32_t startedAtMs, uint32_t endedAtMs) {
+    lastPulseStartedAtMs = startedAtMs;
+    lastPulseEndedAtMs = endedAtMs;
+    actuating = false;
+    pulseCompletePending = true;
+}
 
-    // Track how many entries we have (until cache is full)
-    if (dedupeCacheCount < DEDUP_CACHE_SIZE) {
-        dedupeCacheCount++;
-    }
+bool GateControl::isActuating() {
+    return actuating;
 }
 
+void GateControl::loop() {
+    if (!pulseCompletePending) {
+        return;
+    }
+    pulseCompletePending = false;
+
+    LOG(GATECTL_PULSE_COMPLETED, lastPulseEndedAtMs - lastPulseStartedAtMs);
+}
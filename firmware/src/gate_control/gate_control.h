@@ -33,8 +33,37 @@ public:
      */
     static void recordOpen(uint32_t nowMs);
 
+    /**
+     * Schedule a deferred open at the end of the current cooldown.
+     * Requests scheduled before it runs share the same open.
+     *
+     * @param nowMs Current time in milliseconds
+     * @return Time (millis) the deferred open is due
+     */
+    static uint32_t scheduleOpen(uint32_t nowMs);
+
+    /**
+     * Check if a deferred open is scheduled.
+     */
+    static bool hasScheduledOpen();
+
+    /**
+     * Time until the scheduled open is due (0 if due now or none is scheduled).
+     */
+    static uint32_t msUntilScheduledOpen(uint32_t nowMs);
+
+    /**
+     * Take the scheduled open if it is due (clears it).
+     *
+     * @param nowMs Current time in milliseconds
+     * @param requests Output parameter: number of requests coalesced into it
+     * @return true if the caller should open the gate now
+     */
+    static bool takeScheduledOpen(uint32_t nowMs, uint8_t& requests);
+
     /**
      * Check if a requestId was already processed (dedupe check).
+     * Entries expire after DEDUP_TTL_S and survive ESP32-only resets.
      *
      * @param requestId Request ID string to check
      * @return true if requestId was already processed, false otherwise
@@ -48,11 +77,34 @@ public:
      */
     static void markProcessed(const char* requestId);
 
+    /**
+     * Relay pulse completion event (register with Relay::setPulseCompleteCallback).
+     * Runs in timer context; only records the event for loop() to report.
+     *
+     * @param startedAtMs Time the relay was energized
+     * @param endedAtMs Time the relay was released
+     */
+    static void onPulseComplete(uint32_t startedAtMs, uint32_t endedAtMs);
+
+    /**
+     * Check if a gate actuation (relay pulse) is in progress.
+     */
+    static bool isActuating();
+
+    /**
+     * Call from the gate task to process pending gate events (pulse completion).
+     */
+    static void loop();
+
 private:
     static uint32_t lastOpenAtMs;
-    static char dedupeCache[DEDUP_CACHE_SIZE][37];  // 37 bytes per UUID (36 + null terminator)
-    static uint8_t dedupeCacheIndex;
-    static uint8_t dedupeCacheCount;
+    static bool openScheduled;
+    static uint32_t scheduledOpenAtMs;
+    static uint8_t scheduledRequests;
+    static volatile bool actuating;
+    static volatile bool pulseCompletePending;
+    static volatile uint32_t lastPulseStartedAtMs;
+    static volatile uint32_t lastPulseEndedAtMs;
 };
 
 #endif // GATE_CONTROL_H
@@ -0,0 +1,258 @@
+#include "gate_task.h"
+#include "gate_control.h"
+#include "relay/relay.h"
+#include "util/Log.h"
+#include <string.h>
+
+CommandRing GateTask::commandRing;
+RxPool GateTask::rxSlots;
+AckRing GateTask::ackRing;
+TaskHandle_t GateTask::taskHandle = nullptr;
+uint32_t GateTask::droppedAcks = 0;
+uint32_t GateTask::relayFailures = 0;
+AckRequest GateTask::deferredAcks[GATE_DEFER_MAX_ACKS];
+uint8_t GateTask::deferredAckCount = 0;
+
+bool GateTask::start() {
+    if (taskHandle != nullptr) {
+        return true;
+    }
+
+    Relay::setPulseCompleteCallback(GateTask::onPulseComplete);
+
+    BaseType_t created = xTaskCreatePinnedToCore(
+        GateTask::run, "gate", GATE_TASK_STACK, nullptr,
+        GATE_TASK_PRIORITY, &taskHandle, GATE_TASK_CORE);
+    if (created != pdPASS) {
+        taskHandle = nullptr;
+        LOG(GATE_TASK_CREATE_FAILED);
+        return false;
+    }
+
+    LOG(GATE_TASK_STARTED, GATE_TASK_CORE);
+    return true;
+}
+
+CommandRing* GateTask::commands() {
+    return &commandRing;
+}
+
+RxPool* GateTask::rxPool() {
+    return &rxSlots;
+}
+
+AckRing* GateTask::acks() {
+    return &ackRing;
+}
+
+void GateTask::notify() {
+    if (taskHandle != nullptr) {
+        xTaskNotifyGive(taskHandle);
+    }
+}
+
+uint32_t GateTask::getDroppedAckCount() {
+    return droppedAcks;
+}
+
+uint32_t GateTask::getRelayFailureCount() {
+    return relayFailures;
+}
+
+uint32_t GateTask::getErrorCount() {
+    return droppedAcks + relayFailures;
+}
+
+void GateTask::run(void* arg) {
+    (void)arg;
+    int8_t slot;
+
+    for (;;) {
+        // Sleep until a command is queued, a relay pulse completes or a deferred open is due
+        TickType_t wait = portMAX_DELAY;
+        if (GateControl::hasScheduledOpen()) {
+            wait = pdMS_TO_TICKS(GateControl::msUntilScheduledOpen(millis())) + 1;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        while (commandRing.pop(slot)) {
+            processSlot(slot);
+        }
+
+        runScheduledOpen();
+
+        GateControl::loop();
+    }
+}
+
+/**
+ * Parse a received payload, hand the slot back to the pool, then run the command.
+ */
+void GateTask::processSlot(int8_t slot) {
+    CommandResult cmd;
+    const RxMessage& msg = rxSlots.get(slot);
+    bool parsed = msg.binary
+        ? Protocol::parseCommandBinary(msg.data, msg.len, cmd)
+        : Protocol::parseCommand(reinterpret_cast<const char*>(msg.data), msg.len, cmd);
+    rxSlots.release(slot);
+
+    if (!parsed) {
+        LOG(GATE_PARSE_FAILED);
+    }
+    handleCommand(cmd);
+}
+
+void GateTask::onPulseComplete(uint32_t startedAtMs, uint32_t endedAtMs) {
+    GateControl::onPulseComplete(startedAtMs, endedAtMs);
+    notify();
+}
+
+/**
+ * Run the deferred open once its cooldown has ended, then ACK the requests that
+ * joined it: ok (they are recorded for dedupe only now), or RELAY_FAIL.
+ */
+void GateTask::runScheduledOpen() {
+    uint32_t nowMs = millis();
+    uint8_t requests = 0;
+    if (!GateControl::takeScheduledOpen(nowMs, requests)) {
+        return;
+    }
+
+    LOG(GATE_DEFERRED_OPEN, requests);
+    bool opened = Relay::activatePulse();
+    if (opened) {
+        GateControl::recordOpen(nowMs);
+    } else {
+        relayFailures++;
+        LOG(GATE_DEFERRED_RELAY_FAIL);
+    }
+
+    for (uint8_t i = 0; i < deferredAckCount; i++) {
+        AckRequest& ack = deferredAcks[i];
+        if (opened) {
+            GateControl::markProcessed(ack.requestId);
+        } else {
+            ack.ok = false;
+            ack.errorCode = "RELAY_FAIL";
+            ack.scheduledAt = 0;
+        }
+        queueAck(ack);
+    }
+    deferredAckCount = 0;
+}
+
+bool GateTask::isDeferred(const char* requestId) {
+    for (uint8_t i = 0; i < deferredAckCount; i++) {
+        if (strcmp(deferredAcks[i].requestId, requestId) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+AckRequest GateTask::makeAck(const CommandResult& cmd, bool ok, const char* errorCode,
+                             uint32_t retryAfterMs, unsigned long long scheduledAt) {
+    AckRequest ack;
+    strncpy(ack.requestId, cmd.requestId, sizeof(ack.requestId) - 1);
+    ack.requestId[sizeof(ack.requestId) - 1] = '\0';
+    ack.ok = ok;
+    ack.binary = cmd.binary;  // reply in the encoding the command used
+    ack.errorCode = errorCode;
+    ack.retryAfterMs = retryAfterMs;
+    ack.scheduledAt = scheduledAt;
+    return ack;
+}
+
+void GateTask::queueAck(const CommandResult& cmd, bool ok, const char* errorCode,
+                        uint32_t retryAfterMs, unsigned long long scheduledAt) {
+    queueAck(makeAck(cmd, ok, errorCode, retryAfterMs, scheduledAt));
+}
+
+void GateTask::queueAck(const AckRequest& ack) {
+    if (!ackRing.push(ack)) {
+        droppedAcks++;
+        LOG(GATE_ACK_QUEUE_FULL, ack.requestId);
+    }
+}
+
+/**
+ * Process one gate command with validation, dedupe, coalescing, cooldown deferral, and relay control.
+ */
+void GateTask::handleCommand(const CommandResult& cmd) {
+    if (!cmd.valid) {
+        LOG(GATE_INVALID_PAYLOAD);
+        queueAck(cmd, false, "BAD_PAYLOAD");
+        return;
+    }
+
+    // Validate requestId is non-empty
+    if (cmd.requestId[0] == '\0') {
+        LOG(GATE_EMPTY_REQUEST_ID);
+        queueAck(cmd, false, "BAD_PAYLOAD");
+        return;
+    }
+
+    LOG(GATE_COMMAND, cmd.requestId, cmd.command, cmd.userId, cmd.issuedAt);
+
+    // Check if command is "open"
+    if (strcmp(cmd.command, "open") != 0) {
+        LOG(GATE_UNKNOWN_COMMAND, cmd.command);
+        queueAck(cmd, false, "UNKNOWN_COMMAND");
+        return;
+    }
+
+    // Check dedupe (idempotency)
+    if (GateControl::wasProcessed(cmd.requestId)) {
+        LOG(GATE_DEDUPE_HIT, cmd.requestId);
+        queueAck(cmd, true, nullptr);
+        return;
+    }
+
+    // Redelivered while waiting for the deferred open: its ACK is already held
+    if (isDeferred(cmd.requestId)) {
+        LOG(GATE_DEFER_PENDING, cmd.requestId);
+        return;
+    }
+
+    // Gate is already opening: this request is served by the running pulse
+    if (GateControl::isActuating()) {
+        LOG(GATE_COALESCED);
+        GateControl::markProcessed(cmd.requestId);
+        queueAck(cmd, true, nullptr);
+        return;
+    }
+
+    // Check cooldown
+    uint32_t nowMs = millis();
+    uint32_t remainingMs = 0;
+    if (!GateControl::canExecuteNow(nowMs, remainingMs)) {
+        if (remainingMs <= GATE_DEFER_WINDOW_MS && deferredAckCount < GATE_DEFER_MAX_ACKS) {
+            // Tail of the cooldown: join the deferred open instead of making the client retry.
+            // The ACK waits for the open (runScheduledOpen).
+            uint32_t dueAtMs = GateControl::scheduleOpen(nowMs);
+            uint32_t delayMs = dueAtMs - nowMs;
+            LOG(GATE_DEFERRED, delayMs);
+            // Estimated on the sender's clock (transit time ignored)
+            deferredAcks[deferredAckCount++] =
+                makeAck(cmd, true, nullptr, 0, cmd.issuedAt != 0 ? cmd.issuedAt + delayMs : 0);
+            return;
+        }
+
+        LOG(GATE_COOLDOWN, remainingMs);
+        queueAck(cmd, false, "COOLDOWN", remainingMs);
+        return;
+    }
+
+    // Activate relay (non-blocking: pin is released by the pulse timer)
+    LOG(GATE_ACTIVATING);
+    if (Relay::activatePulse()) {
+        // Record gate open and mark request as processed
+        GateControl::recordOpen(nowMs);
+        GateControl::markProcessed(cmd.requestId);
+        queueAck(cmd, true, nullptr);
+    } else {
+        relayFailures++;
+        LOG(GATE_RELAY_FAIL);
+        queueAck(cmd, false, "RELAY_FAIL");
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef GATE_TASK_H
+#define GATE_TASK_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "config/config.h"
+#include "protocol/Protocol.h"
+
+/**
+ * Gate command task (pinned to GATE_TASK_CORE).
+ * Parses and consumes commands received by the network task, runs GateControl and Relay,
+ * and hands ACK requests back to the network task for publishing.
+ * Never touches the modem, so modem/PPP recovery cannot delay gate opening.
+ */
+class GateTask {
+public:
+    /**
+     * Create the gate task. Call once in setup, after Relay::init() and GateControl::init().
+     * Returns true if the task was created.
+     */
+    static bool start();
+
+    /**
+     * Command queue (network task is the only producer).
+     * Carries indices of rxPool() slots; ownership of the slot moves with the index.
+     */
+    static CommandRing* commands();
+
+    /**
+     * Receive slots for command payloads (acquired by the network task, released here).
+     */
+    static RxPool* rxPool();
+
+    /**
+     * ACK queue (network task is the only consumer).
+     */
+    static AckRing* acks();
+
+    /**
+     * Wake the gate task (call after pushing to commands()).
+     */
+    static void notify();
+
+    /**
+     * Number of ACKs dropped because the ACK queue was full.
+     */
+    static uint32_t getDroppedAckCount();
+
+    /**
+     * Number of relay activations that failed, deferred opens included.
+     */
+    static uint32_t getRelayFailureCount();
+
+    /**
+     * Gate-side errors for the status errors field: dropped ACKs plus relay failures.
+     */
+    static uint32_t getErrorCount();
+
+private:
+    static void run(void* arg);
+    static void processSlot(int8_t slot);
+    static void handleCommand(const CommandResult& cmd);
+    static void runScheduledOpen();
+    static AckRequest makeAck(const CommandResult& cmd, bool ok, const char* errorCode,
+                              uint32_t retryAfterMs, unsigned long long scheduledAt);
+    static void queueAck(const CommandResult& cmd, bool ok, const char* errorCode,
+                         uint32_t retryAfterMs = 0, unsigned long long scheduledAt = 0);
+    static void queueAck(const AckRequest& ack);
+    static bool isDeferred(const char* requestId);
+    static void onPulseComplete(uint32_t startedAtMs, uint32_t endedAtMs);
+
+    static CommandRing commandRing;
+    static RxPool rxSlots;
+    static AckRing ackRing;
+    static TaskHandle_t taskHandle;
+    static uint32_t droppedAcks;
+    static uint32_t relayFailures;
+    // ACKs held until the deferred open has run (its outcome decides them)
+    static AckRequest deferredAcks[GATE_DEFER_MAX_ACKS];
+    static uint8_t deferredAckCount;
+};
+
+#endif // GATE_TASK_H
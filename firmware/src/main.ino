@@ -8,12 +8,16 @@
 #include "mqtt/MqttManager.h"
 #include "relay/relay.h"
 #include "gate_control/gate_control.h"
+#include "gate_control/gate_task.h"
 #include "protocol/Protocol.h"
+#include "util/Scheduler.h"
+#include "util/BootReport.h"
+#include "util/WarmBoot.h"
+#include "util/Log.h"
 #if DIAGNOSTIC_LOG_ENABLED
 #include "util/DiagnosticLog.h"
 #endif
-#include <ArduinoJson.h>  // For parsing requestId from invalid JSON
-#include <WiFi.h>  // For WiFiClient (works with PPP if initialized)
+#include <ArduinoJson.h>  // For diagnostic log upload
 
 // Disable watchdog timer to prevent boot loops
 #include "esp_task_wdt.h"
@@ -41,11 +45,23 @@ const unsigned long PUBLISH_INTERVAL = 5000; // Publish every 5 seconds
 int messageCount = 0;
 
 #if OOB_HTTP_ENABLED
-static unsigned long lastOobPollTime = 0;
 static bool applyOobAction(const char* action, unsigned long now);
 static bool pollOobCommandViaModem(unsigned long now);
 #endif
 
+static void networkTask(void* arg);
+static void networkLoop();
+static void queuePendingAcks();
+static void onOutboxDelivered(OutboxTopic topic, uint32_t tag, bool delivered);
+static void enterPppUp(unsigned long now);
+
+// Cooperative scheduler for periodic/deferred work in the network task (never sleep in loop)
+static Scheduler scheduler;
+static Scheduler::TaskId pppUpStageTask = Scheduler::INVALID_TASK;
+// Cold boot hold-off and modem init backoff windows (cleared by scheduled tasks)
+static bool coldBootPending = false;
+static bool modemInitBackoffActive = false;
+
 // Recovery: when we escalate from MQTT to PPP rebuild, force PPP to start fresh
 static bool forcePppRestart = false;
 // Modem init retry cap: count failures, then back off before retrying
@@ -54,22 +70,30 @@ static int modemInitRetries = 0;
 #if DIAGNOSTIC_LOG_ENABLED
 static DiagnosticLog diagnosticLog;
 static uint32_t bootSessionId = 0;
+// A diagnostics batch is in the outbox; its entries stay in the journal until delivered
+static bool diagnosticBatchQueued = false;
+// Gate task relay failures already written to the journal
+static uint32_t loggedRelayFailures = 0;
 #endif
 
 #if OOB_HTTP_ENABLED
 static bool applyOobAction(const char* action, unsigned long now) {
     if (strcmp(action, "reboot") == 0) {
-        Serial.println("[OOB] Action received: reboot");
+        LOG(OOB_ACTION, action);
 #if DIAGNOSTIC_LOG_ENABLED
-        diagnosticLog.append(DiagnosticLevel::Warn, "oob_reboot", nullptr);
+        diagnosticLog.append(DIAG_EVENT_OOB_REBOOT);
+        diagnosticLog.commit();
 #endif
+        // The warm-boot record already holds the live modem/PPP/MQTT state
+        // (updated every network loop pass), so the next boot can reuse it.
+        Log::flush();
         esp_restart();
         return true;
     }
     if (strcmp(action, "rebuild_ppp") == 0) {
-        Serial.println("[OOB] Action received: rebuild_ppp");
+        LOG(OOB_ACTION, action);
 #if DIAGNOSTIC_LOG_ENABLED
-        diagnosticLog.append(DiagnosticLevel::Warn, "oob_ppp_rebuild", nullptr);
+        diagnosticLog.append(DIAG_EVENT_OOB_PPP_REBUILD);
 #endif
         mqttManager->disconnect();
         mqttManager->resetMqttFailStreak();
@@ -84,16 +108,17 @@ static bool applyOobAction(const char* action, unsigned long now) {
 
 static bool pollOobCommandViaModem(unsigned long now) {
     if (pppManager == nullptr) return false;
-    TinyGsm* modem = pppManager->getModem();
+    TinyGsm* modem = pppManager->getAuxModem();
     if (modem == nullptr) return false;
+    // The AT queue shares this channel; the next poll is soon enough
+    if (modemManager->getAtQueue().busy()) return false;
 
-    Serial.println("[OOB] Polling pending-command via built-in HTTPS...");
+    LOG(OOB_POLLING);
     modem->https_begin();
     String url = String("https://") + OOB_API_HOST + "/api/device/pending-command?deviceId=" + DEVICE_ID;
     bool setOk = modem->https_set_url(url.c_str());
-    Serial.print("[OOB] https_set_url => ");
-    Serial.println(setOk ? "OK" : "FAIL");
     if (!setOk) {
+        LOG(OOB_SET_URL_FAILED);
         modem->https_end();
         return false;
     }
@@ -104,17 +129,14 @@ static bool pollOobCommandViaModem(unsigned long now) {
 
     size_t responseSize = 0;
     int code = modem->https_get(&responseSize);
-    Serial.print("[OOB] https_get code => ");
-    Serial.println(code);
-    Serial.print("[OOB] response size hint => ");
-    Serial.println((unsigned long)responseSize);
+    LOG(OOB_RESPONSE, code, (unsigned long)responseSize);
     if (code == 205) {
-        Serial.println("[OOB] status 205 => reboot");
+        LOG(OOB_STATUS_ACTION, code, "reboot");
         modem->https_end();
         return applyOobAction("reboot", now);
     }
     if (code == 206) {
-        Serial.println("[OOB] status 206 => rebuild_ppp");
+        LOG(OOB_STATUS_ACTION, code, "rebuild_ppp");
         modem->https_end();
         return applyOobAction("rebuild_ppp", now);
     }
@@ -124,7 +146,7 @@ static bool pollOobCommandViaModem(unsigned long now) {
         return false;
     }
     if (code != 200) {
-        Serial.println("[OOB] non-command status, skipping body parse");
+        LOG(OOB_NON_COMMAND_STATUS, code);
         modem->https_end();
         return false;
     }
@@ -132,6 +154,162 @@ static bool pollOobCommandViaModem(unsigned long now) {
 }
 #endif
 
+static void onColdBootDelayElapsed(void* ctx) {
+    (void)ctx;
+    LOG(DEVICE_COLD_BOOT_DONE);
+    coldBootPending = false;
+    stateEntryTime = millis();
+}
+
+static void onModemInitBackoffElapsed(void* ctx) {
+    (void)ctx;
+    LOG(DEVICE_INIT_BACKOFF_DONE);
+    modemInitBackoffActive = false;
+    modemInitRetries = 0;
+    stateEntryTime = millis();
+}
+
+#if DIAGNOSTIC_LOG_ENABLED
+static void onDiagnosticCommitTimer(void* ctx) {
+    (void)ctx;
+    diagnosticLog.commitIfDue(millis());
+}
+
+/**
+ * Queue the next batch of buffered diagnostics, one batch at a time.
+ * The batch goes to the outbox at low priority, behind any ACKs, and is built
+ * only while the gate task has no commands waiting. Entries are removed (and the
+ * journal tail persisted) only once the outbox reports the batch delivered, so a
+ * disconnect or reboot resumes at the first batch that was not acknowledged.
+ */
+static void onDiagnosticUploadTimer(void* ctx) {
+    (void)ctx;
+    if (deviceState != STATE_MQTT_CONNECTED || diagnosticBatchQueued || !diagnosticLog.hasEntries()) {
+        return;
+    }
+    if (!GateTask::commands()->empty() || GateTask::rxPool()->inUse() > 0) {
+        return;
+    }
+
+    // Static: one upload at a time, all from the network task
+    static StaticJsonDocument<DIAG_UPLOAD_DOC_SIZE> doc;
+    static char payload[OUTBOX_PAYLOAD_MAX];
+    if (bootSessionId == 0) bootSessionId = millis() + (uint32_t)random(0xFFFF);
+
+    doc.clear();
+    doc["deviceId"] = DEVICE_ID;
+    doc["fwVersion"] = FW_VERSION;
+    doc["sessionId"] = bootSessionId;
+    JsonArray arr = doc.createNestedArray("entries");
+    char eventBuf[DIAG_EVENT_LEN], messageBuf[DIAG_MESSAGE_LEN];
+    uint32_t firstSeq = diagnosticLog.getFirstSeq();
+    size_t batchCount = 0;
+    for (size_t i = 0; i < DIAG_UPLOAD_BATCH; i++) {
+        uint32_t ts;
+        uint8_t lvl;
+        if (!diagnosticLog.getEntry(i, &ts, &lvl, eventBuf, sizeof(eventBuf), messageBuf, sizeof(messageBuf)))
+            break;
+        JsonObject e = arr.createNestedObject();
+        e["ts"] = ts;
+        e["level"] = lvl == 0 ? "info" : (lvl == 1 ? "warn" : "error");
+        e["event"] = eventBuf;
+        if (messageBuf[0]) e["message"] = messageBuf;
+        // Keep the batch within one outbox slot
+        if (doc.overflowed() || measureJson(doc) >= sizeof(payload)) {
+            arr.remove(arr.size() - 1);
+            break;
+        }
+        batchCount++;
+    }
+    if (batchCount == 0 || doc.overflowed()) {
+        return;
+    }
+    size_t len = serializeJson(doc, payload, sizeof(payload));
+    if (len == 0 || len >= sizeof(payload)) {
+        return;
+    }
+    // Tagged with the sequence number after the batch: the journal may drop old
+    // entries before delivery, so a count alone could remove newer ones
+    if (mqttManager->enqueue(OUTBOX_TOPIC_DIAGNOSTICS, payload, len, OUTBOX_PRIORITY_LOW, 1, 0,
+                             firstSeq + (uint32_t)batchCount)) {
+        diagnosticBatchQueued = true;
+    }
+}
+#endif
+
+/**
+ * Outbox delivery: a diagnostics batch leaves the journal only once delivered.
+ */
+static void onOutboxDelivered(OutboxTopic topic, uint32_t tag, bool delivered) {
+#if DIAGNOSTIC_LOG_ENABLED
+    if (topic == OUTBOX_TOPIC_DIAGNOSTICS) {
+        diagnosticBatchQueued = false;
+        if (delivered) {
+            LOG(DEVICE_DIAG_BATCH_PUBLISHED);
+            diagnosticLog.removeBefore(tag);
+        }
+    }
+#else
+    (void)topic;
+    (void)tag;
+    (void)delivered;
+#endif
+}
+
+static void onStatusTimer(void* ctx) {
+    (void)ctx;
+    if (deviceState == STATE_MQTT_CONNECTED) {
+        mqttManager->publishStatus();
+    }
+}
+
+#if OOB_HTTP_ENABLED
+static void onOobPollTimer(void* ctx) {
+    (void)ctx;
+    // OOB channel is a safety net: it can request reboot/PPP rebuild even if MQTT is flaky.
+    // Only attempt when PPP is up and on a timer to minimize data usage.
+    if (deviceState == STATE_MQTT_CONNECTED) {
+        pollOobCommandViaModem(millis());
+    }
+}
+#endif
+
+// STATE_PPP_UP stages: run back-to-back as soon as each step succeeds
+static void onPppUpInitModemMqtt(void* ctx) {
+    (void)ctx;
+    pppUpStageTask = Scheduler::INVALID_TASK;
+    if (deviceState != STATE_PPP_UP) return;
+    LOG(DEVICE_MODEM_MQTT_INIT);
+    if (mqttManager->initializeModemMqtt(true, true, nullptr)) {
+        LOG(DEVICE_MODEM_MQTT_READY);
+        deviceState = STATE_MQTT_CONNECTING;
+        stateEntryTime = millis();
+    } else {
+        LOG(DEVICE_MODEM_MQTT_FAILED);
+        pppUpStageTask = scheduler.scheduleOnce(1000, onPppUpInitModemMqtt);
+    }
+}
+
+static void enterPppUp(unsigned long now) {
+    LOG(DEVICE_PPP_CONNECTED);
+    deviceState = STATE_PPP_UP;
+    stateEntryTime = now;
+    scheduler.cancel(pppUpStageTask);
+    pppUpStageTask = Scheduler::INVALID_TASK;
+
+    // Link MqttManager to PppManager (now that TinyGSM modem exists)
+    mqttManager->setPppManager(pppManager);
+    mqttManager->begin(MQTT_HOST, MQTT_PORT, MQTT_USERNAME, MQTT_PASSWORD);
+
+    // Warm reboot: the modem MQTT client may still be connected and subscribed
+    uint8_t clientIndex = 0;
+    if (WarmBoot::takeMqttReuse(clientIndex) && mqttManager->adoptSession(clientIndex)) {
+        deviceState = STATE_MQTT_CONNECTING;
+        return;
+    }
+    onPppUpInitModemMqtt(nullptr);
+}
+
 void setup() {
     // CRITICAL: Disable watchdog timer first to prevent boot loops
     disableCore0WDT();
@@ -140,217 +318,197 @@ void setup() {
 
     // Initialize serial immediately
     Serial.begin(115200);
-    delay(500);  // Short delay for serial to initialize
-
-    // Print early to confirm we got past global constructors
-    Serial.println();
-    Serial.println("========================================");
-    Serial.println("Parking Gate Remote - Production Firmware");
-    Serial.println("Cellular Connectivity via Cellcom Israel");
-    Serial.println("========================================");
-    Serial.flush();
-    delay(500);
-
-    // Print verbose configuration values
-    Serial.println();
-    Serial.println("=== CONFIGURATION VALUES ===");
-    Serial.print("Device ID: ");
-    Serial.println(DEVICE_ID);
-    Serial.print("FW Version: ");
-    Serial.println(FW_VERSION);
-    Serial.println();
-    Serial.println("--- Cellular/PPP Configuration ---");
-    Serial.print("APN: ");
-    Serial.println(CELLULAR_APN);
-    Serial.print("APN Username: ");
-    Serial.println(CELLULAR_USERNAME[0] ? CELLULAR_USERNAME : "(empty)");
-    Serial.print("APN Password: ");
-    Serial.println(CELLULAR_PASSWORD[0] ? "***" : "(empty)");
-    Serial.print("PPP Timeout: ");
-    Serial.print(PPP_TIMEOUT_MS);
-    Serial.println(" ms");
-    Serial.println();
-    Serial.println("--- Modem Configuration ---");
-    Serial.print("UART: Serial1");
-    Serial.println();
-    Serial.print("UART Baud: ");
-    Serial.println(MODEM_UART_BAUD);
-    Serial.print("TX Pin: ");
-    Serial.println(MODEM_TX_PIN);
-    Serial.print("RX Pin: ");
-    Serial.println(MODEM_RX_PIN);
-    #ifdef BOARD_POWERON_PIN
-    Serial.print("BOARD_POWERON Pin: ");
-    Serial.println(BOARD_POWERON_PIN);
-    #endif
-    Serial.print("RESET Pin: ");
-    Serial.println(MODEM_RESET_PIN);
-    Serial.print("RESET Level: ");
-    Serial.println(MODEM_RESET_LEVEL == HIGH ? "HIGH" : "LOW");
-    Serial.print("PWRKEY Pin: ");
-    Serial.println(BOARD_PWRKEY_PIN);
-    #ifdef MODEM_DTR_PIN
-    Serial.print("DTR Pin: ");
-    Serial.println(MODEM_DTR_PIN);
-    #endif
-    Serial.print("AT Init Timeout: ");
-    Serial.print(AT_INIT_TIMEOUT_MS);
-    Serial.println(" ms");
-    Serial.print("AT CMD Timeout: ");
-    Serial.print(AT_CMD_TIMEOUT_MS);
-    Serial.println(" ms");
-    Serial.println();
-    Serial.println("--- MQTT Configuration (Production) ---");
-    Serial.print("MQTT Host: ");
-    Serial.println(MQTT_HOST);
-    Serial.print("MQTT Port: ");
-    Serial.println(MQTT_PORT);
-    Serial.print("MQTT Username: ");
-    Serial.println(MQTT_USERNAME);
-    Serial.print("MQTT Password: ");
-    Serial.println(MQTT_PASSWORD[0] ? "***" : "(empty)");
-    Serial.print("MQTT CMD Topic: ");
-    Serial.println(MQTT_CMD_TOPIC);
-    Serial.print("MQTT ACK Topic: ");
-    Serial.println(MQTT_ACK_TOPIC);
-    Serial.print("MQTT Status Topic: ");
-    Serial.println(MQTT_STATUS_TOPIC);
-    Serial.print("Status Interval: ");
-    Serial.print(STATUS_INTERVAL_MS);
-    Serial.println(" ms");
-    Serial.println();
-    Serial.println("--- Recovery Configuration ---");
-    Serial.print("MQTT Fails Before PPP Rebuild: ");
-    Serial.println(MQTT_FAILS_BEFORE_PPP_REBUILD);
-    Serial.print("PPP Fails Before Modem Reset: ");
-    Serial.println(PPP_FAILS_BEFORE_MODEM_RESET);
-    Serial.print("Backoff Base: ");
-    Serial.print(BACKOFF_BASE_MS);
-    Serial.println(" ms");
-    Serial.print("Backoff Max: ");
-    Serial.print(BACKOFF_MAX_MS);
-    Serial.println(" ms");
-    Serial.print("Cold Boot Delay: ");
-    Serial.print(COLD_BOOT_DELAY_MS);
-    Serial.println(" ms");
-    Serial.print("Modem Init Max Retries: ");
-    Serial.println(MODEM_INIT_MAX_RETRIES);
-    Serial.print("Modem Init Backoff: ");
-    Serial.print(MODEM_INIT_BACKOFF_MS);
-    Serial.println(" ms");
-    Serial.println("========================================");
-    Serial.flush();
-    delay(500);
-
-    Serial.println("[Device] Setup() started successfully");
-    Serial.println("[Device] Initializing managers...");
-    Serial.flush();
+    // Modules log through the deferred logger (binary frames, see tools/log_decode.py)
+    Log::start();
+
+    // Log early to confirm we got past global constructors
+    LOG(DEVICE_BANNER, DEVICE_ID, FW_VERSION);
+
+    // Configuration values
+    LOG(DEVICE_CONFIG_CELLULAR, CELLULAR_APN, CELLULAR_USERNAME[0] ? CELLULAR_USERNAME : "(empty)",
+        CELLULAR_PASSWORD[0] ? "***" : "(empty)", (unsigned long)PPP_TIMEOUT_MS);
+#ifdef BOARD_POWERON_PIN
+    const int powerOnPin = BOARD_POWERON_PIN;
+#else
+    const int powerOnPin = -1;
+#endif
+#ifdef MODEM_DTR_PIN
+    const int dtrPin = MODEM_DTR_PIN;
+#else
+    const int dtrPin = -1;
+#endif
+    LOG(DEVICE_CONFIG_MODEM, (unsigned long)MODEM_UART_BAUD, MODEM_TX_PIN, MODEM_RX_PIN, powerOnPin,
+        MODEM_RESET_PIN, MODEM_RESET_LEVEL == HIGH ? "HIGH" : "LOW", BOARD_PWRKEY_PIN, dtrPin);
+    LOG(DEVICE_CONFIG_AT, (unsigned long)AT_INIT_TIMEOUT_MS, (unsigned long)AT_CMD_TIMEOUT_MS);
+    LOG(DEVICE_CONFIG_MQTT, MQTT_HOST, MQTT_PORT, MQTT_USERNAME, MQTT_PASSWORD[0] ? "***" : "(empty)",
+        (unsigned long)STATUS_INTERVAL_MS);
+    LOG(DEVICE_CONFIG_TOPICS, MQTT_CMD_TOPIC, MQTT_ACK_TOPIC, MQTT_STATUS_TOPIC);
+    LOG(DEVICE_CONFIG_RECOVERY, MQTT_FAILS_BEFORE_PPP_REBUILD, PPP_FAILS_BEFORE_MODEM_RESET,
+        (unsigned long)BACKOFF_BASE_MS, (unsigned long)BACKOFF_MAX_MS);
+    LOG(DEVICE_CONFIG_BOOT, (unsigned long)COLD_BOOT_DELAY_MS, MODEM_INIT_MAX_RETRIES,
+        (unsigned long)MODEM_INIT_BACKOFF_MS);
+
+    // Decide what the previous boot left running before any manager touches the modem
+    WarmBoot::begin();
 
     // Create managers dynamically to avoid constructor issues during global init
-    Serial.println("[Device] Creating ModemManager...");
-    Serial.flush();
-    delay(200);  // Give watchdog time
-
     modemManager = new ModemManager();
-    Serial.println("[Device] ModemManager created successfully");
-    Serial.flush();
-    delay(200);
-
-    Serial.println("[Device] Creating PppManager...");
-    Serial.flush();
-    delay(200);
-
     pppManager = new PppManager(modemManager);
-    Serial.println("[Device] PppManager created successfully");
-    Serial.flush();
-    delay(200);
-
-    Serial.println("[Device] Creating MqttManager...");
-    Serial.flush();
-    delay(200);
-
     mqttManager = new MqttManager();
-    Serial.println("[Device] MqttManager created successfully");
-    Serial.flush();
-    delay(200);
-
-    Serial.println("[Device] All managers created");
-    Serial.flush();
+    mqttManager->setDeliveryHandler(onOutboxDelivered);
+    mqttManager->setErrorCounter(GateTask::getErrorCount);
+    LOG(DEVICE_MANAGERS_CREATED);
 
     // Initialize relay and gate control
-    Serial.println("[Device] Initializing relay and gate control...");
     Relay::init();
     GateControl::init();
-    Serial.println("[Device] Relay and gate control initialized");
-    Serial.flush();
-
-    // Cold boot: wait for modem power rail to stabilize before any modem GPIO activity
-    Serial.print("[Device] Cold boot delay ");
-    Serial.print(COLD_BOOT_DELAY_MS);
-    Serial.println(" ms...");
-    Serial.flush();
-    delay(COLD_BOOT_DELAY_MS);
-    Serial.println("[Device] Cold boot delay complete");
-    Serial.flush();
+    GateTask::start();
+    LOG(DEVICE_GATE_READY);
+
+    // Cold boot: hold off modem GPIO activity until the power rail stabilizes.
+    // Scheduled rather than slept so the network task is already running meanwhile.
+    // Not needed after a warm reboot: the rails never went down.
+    if (!WarmBoot::isWarmBoot()) {
+        LOG(DEVICE_COLD_BOOT_DELAY, (unsigned long)COLD_BOOT_DELAY_MS);
+        coldBootPending = true;
+        scheduler.scheduleOnce(COLD_BOOT_DELAY_MS, onColdBootDelayElapsed);
+    }
+
+    // Periodic work in the network task
+    scheduler.schedulePeriodic(STATUS_INTERVAL_MS, onStatusTimer);
+#if DIAGNOSTIC_LOG_ENABLED
+    scheduler.schedulePeriodic(DIAG_COMMIT_INTERVAL_MS / 4, onDiagnosticCommitTimer);
+    scheduler.schedulePeriodic(DIAG_UPLOAD_INTERVAL_MS, onDiagnosticUploadTimer);
+#endif
+#if OOB_HTTP_ENABLED
+    scheduler.schedulePeriodic(OOB_POLL_INTERVAL_MS, onOobPollTimer, nullptr, OOB_POLL_INTERVAL_MS);
+#endif
 
     // Note: setPppManager() will be called after PPP is up (when TinyGSM modem is created)
     // MQTT will be initialized with production settings from config.h after PPP is up
 
     stateEntryTime = millis();
-    Serial.println("[Device] Starting in STATE_MODEM_INIT state");
-    Serial.flush();
+    BootReport::mark(BOOT_PHASE_SETUP_DONE);
+
+    // Modem/PPP/MQTT state machine runs in its own task, away from the gate task's core
+    xTaskCreatePinnedToCore(networkTask, "network", NETWORK_TASK_STACK, nullptr,
+                            NETWORK_TASK_PRIORITY, nullptr, NETWORK_TASK_CORE);
+    LOG(DEVICE_NETWORK_TASK, NETWORK_TASK_CORE);
 }
 
 void loop() {
+    // All work runs in the network and gate tasks
+    vTaskDelete(nullptr);
+}
+
+/**
+ * Move ACKs from the gate task into the outbox (high priority, QoS 1). Runs
+ * while disconnected too: the ACKs are sent in order once the session is back.
+ */
+static void queuePendingAcks() {
+    AckRequest ack;
+    while (GateTask::acks()->pop(ack)) {
+        bool queued;
+#if MQTT_BINARY_ENABLED
+        if (ack.binary) {
+            uint8_t frame[PROTOCOL_BIN_ACK_MAX_LEN];
+            size_t frameLen = Protocol::createAckBinary(ack.requestId, ack.ok, ack.errorCode, frame, sizeof(frame),
+                                                        ack.retryAfterMs, ack.scheduledAt);
+            queued = mqttManager->enqueue(OUTBOX_TOPIC_ACK_BIN, frame, frameLen, OUTBOX_PRIORITY_HIGH, 1,
+                                          OUTBOX_FLAG_SPILL);
+        } else
+#endif
+        {
+            char ackJson[256];
+            size_t len = Protocol::createAck(ack.requestId, ack.ok, ack.errorCode, ackJson, sizeof(ackJson),
+                                             ack.retryAfterMs, ack.scheduledAt);
+            queued = mqttManager->enqueue(OUTBOX_TOPIC_ACK, ackJson, len, OUTBOX_PRIORITY_HIGH, 1,
+                                          OUTBOX_FLAG_SPILL);
+        }
+        if (!queued) {
+            LOG(GATE_ACK_ENQUEUE_FAILED, ack.requestId);
+        } else if (ack.ok || ack.errorCode == nullptr) {
+            LOG(GATE_ACK_QUEUED, ack.requestId);
+        } else {
+            LOG(GATE_ACK_QUEUED_ERROR, ack.errorCode, ack.requestId);
+        }
+    }
+}
+
+static void networkTask(void* arg) {
+    (void)arg;
+    for (;;) {
+        networkLoop();
+    }
+}
+
+static void networkLoop() {
     // Safety check
     if (modemManager == nullptr || pppManager == nullptr || mqttManager == nullptr) {
-        Serial.println("[Device] ERROR: Managers not initialized!");
+        LOG(DEVICE_MANAGERS_MISSING);
         delay(1000);
         return;
     }
 
     unsigned long now = millis();
 
-    // Process MQTT messages if connected
+    // Queue ACKs from the gate task; process MQTT messages and flush the outbox if connected
+    queuePendingAcks();
+#if DIAGNOSTIC_LOG_ENABLED
+    uint32_t relayFailures = GateTask::getRelayFailureCount();
+    if (relayFailures != loggedRelayFailures) {
+        diagnosticLog.append(DIAG_EVENT_RELAY_FAIL, relayFailures);
+        loggedRelayFailures = relayFailures;
+    }
+#endif
     if (deviceState == STATE_MQTT_CONNECTED) {
         mqttManager->loop();
+        mqttManager->flushOutbox();
     }
 
+    // Run due scheduled tasks (status, OOB poll, PPP stages, backoff windows)
+    scheduler.tick(now);
+
+    // Queued AT commands go after this pass's publishes; never waits for the modem
+    modemManager->poll();
+
     // Feed watchdog regularly
     yield();
 
-    // State machine
+    // State machine. Past init it drives TinyGSM, which must not write while a
+    // queued command is waiting for its response (init itself runs on the queue).
+    if (deviceState != STATE_MODEM_INIT && modemManager->isAtBusy()) {
+        vTaskDelay(1);
+        return;
+    }
     switch (deviceState) {
         case STATE_MODEM_INIT:
+            // Cold boot hold-off / init backoff: wait for the scheduled task to clear it
+            if (coldBootPending || modemInitBackoffActive) {
+                break;
+            }
             // Modem initialization
             if (modemManager->init()) {
-                Serial.println("[Device] Modem initialized, starting PPP...");
+                LOG(DEVICE_MODEM_READY);
                 modemInitRetries = 0;
                 deviceState = STATE_PPP_CONNECTING;
                 stateEntryTime = now;
             } else if (now - stateEntryTime > AT_INIT_TIMEOUT_MS) {
                 if (modemInitRetries < MODEM_INIT_MAX_RETRIES) {
-                    Serial.println("[Device] Modem init timeout, power cycle retry...");
+                    LOG(DEVICE_MODEM_INIT_TIMEOUT, modemInitRetries + 1);
 #if DIAGNOSTIC_LOG_ENABLED
-                    char msg[12];
-                    snprintf(msg, sizeof(msg), "retry=%d", modemInitRetries + 1);
-                    diagnosticLog.append(DiagnosticLevel::Warn, "init_retry", msg);
+                    diagnosticLog.append(DIAG_EVENT_INIT_RETRY, modemInitRetries + 1);
 #endif
                     modemManager->powerCycle();
                     modemInitRetries++;
                     stateEntryTime = now;
                 } else {
 #if DIAGNOSTIC_LOG_ENABLED
-                    char msg[16];
-                    snprintf(msg, sizeof(msg), "backoff=%lu", (unsigned long)MODEM_INIT_BACKOFF_MS);
-                    diagnosticLog.append(DiagnosticLevel::Warn, "backoff", msg);
+                    diagnosticLog.append(DIAG_EVENT_BACKOFF, MODEM_INIT_BACKOFF_MS);
 #endif
-                    Serial.print("[Device] Modem init max retries reached, backing off ");
-                    Serial.print(MODEM_INIT_BACKOFF_MS);
-                    Serial.println(" ms...");
-                    delay(MODEM_INIT_BACKOFF_MS);
-                    modemInitRetries = 0;
-                    stateEntryTime = millis();
+                    LOG(DEVICE_MODEM_INIT_BACKOFF, (unsigned long)MODEM_INIT_BACKOFF_MS);
+                    modemInitBackoffActive = true;
+                    scheduler.scheduleOnce(MODEM_INIT_BACKOFF_MS, onModemInitBackoffElapsed);
                 }
             }
             break;
@@ -369,20 +527,17 @@ void loop() {
                 }
 
                 if (pppManager->waitForPppUp(PPP_TIMEOUT_MS)) {
-                    Serial.println("[Device] PPP connected!");
                     pppManager->resetPppFailStreak();
-                    deviceState = STATE_PPP_UP;
+                    enterPppUp(now);
                     pppStarted = false;
                 } else if (now - stateEntryTime > PPP_TIMEOUT_MS) {
-                    Serial.println("[Device] PPP connection timeout, retrying...");
+                    LOG(DEVICE_PPP_TIMEOUT);
                     pppManager->stop();
                     pppStarted = false;
                     if (pppManager->shouldHardReset()) {
-                        Serial.println("[Device] PPP failure threshold exceeded, modem hard reset...");
+                        LOG(DEVICE_PPP_HARD_RESET);
 #if DIAGNOSTIC_LOG_ENABLED
-                        char msg[8];
-                        snprintf(msg, sizeof(msg), "n=%d", (int)pppManager->getPppFailStreak());
-                        diagnosticLog.append(DiagnosticLevel::Warn, "modem_reset", msg);
+                        diagnosticLog.append(DIAG_EVENT_MODEM_RESET, pppManager->getPppFailStreak());
 #endif
                         modemManager->hardReset();
                         pppManager->resetPppFailStreak();
@@ -394,58 +549,17 @@ void loop() {
             break;
 
         case STATE_PPP_UP:
-            {
-                // Give PPP a moment to stabilize
-                static unsigned long pppUpTime = 0;
-                static bool mqttSetup = false;
-                static bool mqttInitialized = false;
-
-                if (pppUpTime == 0) {
-                    pppUpTime = now;
-                    Serial.println("[Device] PPP up, setting up MQTT...");
-                }
-
-                // Step 1: Link MqttManager to PppManager (now that TinyGSM modem exists)
-                if (!mqttSetup && (now - pppUpTime > 1000)) {
-                    Serial.println("[Device] Linking MqttManager to PppManager...");
-                    mqttManager->setPppManager(pppManager);
-                    mqttManager->begin(MQTT_HOST, MQTT_PORT, MQTT_USERNAME, MQTT_PASSWORD);
-                    mqttSetup = true;
-                }
-
-                // Step 2: Initialize modem MQTT with TLS (like POC)
-                if (mqttSetup && !mqttInitialized && (now - pppUpTime > 2000)) {
-                    Serial.println("[Device] Initializing modem MQTT with TLS...");
-                    if (mqttManager->initializeModemMqtt(true, true, nullptr)) {
-                        Serial.println("[Device] Modem MQTT initialized with TLS");
-                        mqttInitialized = true;
-                    } else {
-                        Serial.println("[Device] ERROR: Failed to initialize modem MQTT");
-                    }
-                }
-
-                // Step 3: Proceed to connect
-                if (mqttInitialized && (now - pppUpTime > 3000)) {
-                    Serial.println("[Device] Network ready, connecting to MQTT...");
-                    deviceState = STATE_MQTT_CONNECTING;
-                    stateEntryTime = now;
-                    pppUpTime = 0;
-                    mqttSetup = false;
-                    mqttInitialized = false;
-                }
-            }
+            // MQTT setup runs from enterPppUp (retries are scheduled tasks)
             break;
 
         case STATE_MQTT_CONNECTING:
             // Time-based escalation: don't stay stuck in MQTT_CONNECTING forever.
             // If we can't get MQTT back within a bounded window, rebuild PPP to recover.
             if (now - stateEntryTime > MQTT_CONNECTING_MAX_MS) {
-                Serial.println("[Device] MQTT connect taking too long, forcing PPP rebuild...");
+                LOG(DEVICE_MQTT_STUCK, now - stateEntryTime);
 #if DIAGNOSTIC_LOG_ENABLED
-                char msg[16];
-                snprintf(msg, sizeof(msg), "ms=%lu", (unsigned long)(now - stateEntryTime));
-                diagnosticLog.append(DiagnosticLevel::Warn, "mqtt_stuck", msg);
-                diagnosticLog.append(DiagnosticLevel::Warn, "ppp_rebuild", "reason=mqtt_stuck");
+                diagnosticLog.append(DIAG_EVENT_MQTT_STUCK, now - stateEntryTime);
+                diagnosticLog.append(DIAG_EVENT_PPP_REBUILD_MQTT_STUCK);
 #endif
                 mqttManager->disconnect();
                 mqttManager->resetMqttFailStreak();
@@ -457,11 +571,9 @@ void loop() {
             }
             // Before retrying MQTT, check if we should escalate to PPP rebuild
             if (mqttManager->shouldRebuildPpp()) {
-                Serial.println("[Device] MQTT fail threshold exceeded, rebuilding PPP...");
+                LOG(DEVICE_MQTT_FAIL_THRESHOLD);
 #if DIAGNOSTIC_LOG_ENABLED
-                char msg[8];
-                snprintf(msg, sizeof(msg), "n=%d", (int)mqttManager->getMqttFailStreak());
-                diagnosticLog.append(DiagnosticLevel::Warn, "ppp_rebuild", msg);
+                diagnosticLog.append(DIAG_EVENT_PPP_REBUILD, mqttManager->getMqttFailStreak());
 #endif
                 mqttManager->disconnect();
                 mqttManager->resetMqttFailStreak();
@@ -471,46 +583,21 @@ void loop() {
                 stateEntryTime = now;
                 break;
             }
+            // Before connect(): the resumed session delivers queued commands right away
+            mqttManager->setCommandQueue(GateTask::commands(), GateTask::rxPool(), GateTask::notify);
             if (mqttManager->connect()) {
-                Serial.println("[Device] MQTT connected!");
-                mqttManager->setCommandCallback(handleMqttCommand);
-                Serial.println("[Device] Command callback registered");
-#if DIAGNOSTIC_LOG_ENABLED
-                diagnosticLog.append(DiagnosticLevel::Info, "connection_restored", nullptr);
-                if (diagnosticLog.hasEntries()) {
-                    if (bootSessionId == 0) bootSessionId = millis() + (uint32_t)random(0xFFFF);
-                    const size_t batchSize = 10;
-                    while (diagnosticLog.hasEntries()) {
-                        DynamicJsonDocument doc(1024);
-                        doc["deviceId"] = DEVICE_ID;
-                        doc["fwVersion"] = FW_VERSION;
-                        doc["sessionId"] = bootSessionId;
-                        JsonArray arr = doc.createNestedArray("entries");
-                        char eventBuf[DIAG_EVENT_LEN], messageBuf[DIAG_MESSAGE_LEN];
-                        size_t batchCount = 0;
-                        for (size_t i = 0; i < batchSize; i++) {
-                            uint32_t ts;
-                            uint8_t lvl;
-                            if (!diagnosticLog.getEntry(i, &ts, &lvl, eventBuf, sizeof(eventBuf), messageBuf, sizeof(messageBuf)))
-                                break;
-                            JsonObject e = arr.createNestedObject();
-                            e["ts"] = ts;
-                            e["level"] = lvl == 0 ? "info" : (lvl == 1 ? "warn" : "error");
-                            e["event"] = eventBuf;
-                            if (messageBuf[0]) e["message"] = messageBuf;
-                            batchCount++;
-                        }
-                        if (batchCount == 0) break;
-                        String payload;
-                        serializeJson(doc, payload);
-                        if (mqttManager->publish(MQTT_DIAGNOSTICS_TOPIC, payload.c_str())) {
-                            Serial.println("[Device] Diagnostic log batch published");
-                            diagnosticLog.removeFirst(batchCount);
-                        } else {
-                            break;
-                        }
+                LOG(DEVICE_MQTT_CONNECTED);
+                if (!BootReport::isPublished()) {
+                    char bootJson[384];
+                    BootReport::toJson(bootJson, sizeof(bootJson));
+                    if (mqttManager->publish(MQTT_BOOT_TOPIC, bootJson)) {
+                        LOG(DEVICE_BOOT_REPORT, (unsigned)strlen(bootJson));
+                        BootReport::setPublished();
                     }
                 }
+#if DIAGNOSTIC_LOG_ENABLED
+                // Buffered entries are uploaded in the background (onDiagnosticUploadTimer)
+                diagnosticLog.append(DIAG_EVENT_CONNECTION_RESTORED);
 #endif
                 deviceState = STATE_MQTT_CONNECTED;
                 stateEntryTime = now;
@@ -518,24 +605,14 @@ void loop() {
             break;
 
         case STATE_MQTT_CONNECTED:
-#if OOB_HTTP_ENABLED
-            // OOB channel is a safety net: it can request reboot/PPP rebuild even if MQTT is flaky.
-            // Only attempt when PPP is up and on a timer to minimize data usage.
-            if (now - lastOobPollTime > OOB_POLL_INTERVAL_MS) {
-                lastOobPollTime = now;
-                if (pollOobCommandViaModem(now)) {
-                    break;
-                }
-            }
-#endif
-            mqttManager->publishStatus();
-            // Connection lost is detected either by modem (mqtt_connected) or by
+            // Status publish and OOB poll are scheduled tasks.
+            // Connection lost is detected either by modem URC (+CMQTTCONNLOST, cached) or by
             // failed status publish (MqttManager sets connected=false), so reconnect
             // and PPP-rebuild failsafe kick in after broker restart.
             if (!mqttManager->isConnected()) {
-                Serial.println("[Device] MQTT connection lost, reconnecting...");
+                LOG(DEVICE_MQTT_LOST);
 #if DIAGNOSTIC_LOG_ENABLED
-                diagnosticLog.append(DiagnosticLevel::Warn, "connection_lost", nullptr);
+                diagnosticLog.append(DIAG_EVENT_CONNECTION_LOST);
 #endif
                 deviceState = STATE_MQTT_CONNECTING;
                 stateEntryTime = now;
@@ -543,252 +620,13 @@ void loop() {
             break;
     }
 
-    delay(10);
-}
-
-void testConnectivity() {
-    Serial.println("[Device] ========================================");
-    Serial.println("[Device] Testing Cellular Internet Connectivity");
-    Serial.println("[Device] ========================================");
-
-    // CRITICAL: WiFiClient uses WiFi's DNS resolver, which doesn't work
-    // without ESP32 PPP stack initialized. This test will likely fail
-    // until we properly initialize the ESP32 PPP stack.
-
-    // Test 1: Try DNS resolution via modem (if supported)
-    Serial.println("[Device] Test 1: DNS Resolution via Modem AT Command");
-    if (modemManager != nullptr) {
-        Serial.println("[Device] Attempting DNS lookup via modem...");
-        // Try to resolve www.google.com using modem's DNS
-        // Note: A7670 may support AT+CDNSGIP command for DNS resolution
-        if (modemManager->sendATCommand("AT+CDNSGIP=1,\"www.google.com\"", "OK", 5000)) {
-            Serial.println("[Device] DNS resolution via modem: SUCCESS");
-        } else {
-            Serial.println("[Device] DNS resolution via modem: NOT SUPPORTED or FAILED");
-            Serial.println("[Device] Modem may not support AT+CDNSGIP command");
-        }
-    }
-    Serial.println();
-
-    // Test 2: Try to resolve DNS and connect to www.google.com via ESP32
-    // This will fail if ESP32 PPP stack is not initialized
-    Serial.println("[Device] Test 2: DNS Resolution + HTTP GET via ESP32");
-    Serial.println("[Device] NOTE: This requires ESP32 PPP stack to be initialized");
-    Serial.print("[Device] Attempting to connect to www.google.com:80...");
-    Serial.flush();
-
-    // Use WiFiClient (works with PPP if PPP stack is initialized)
-    // Note: This is a connectivity test, not WiFi-specific
-    WiFiClient testClient;
-
-    unsigned long startTime = millis();
-    bool connected = testClient.connect("www.google.com", 80);
-    unsigned long connectTime = millis() - startTime;
-
-    if (connected) {
-        Serial.println(" SUCCESS!");
-        Serial.print("[Device] Connection time: ");
-        Serial.print(connectTime);
-        Serial.println(" ms");
-
-        // Send HTTP GET request
-        Serial.println("[Device] Sending HTTP GET request...");
-        testClient.println("GET / HTTP/1.1");
-        testClient.println("Host: www.google.com");
-        testClient.println("Connection: close");
-        testClient.println();
-
-        // Wait for response
-        unsigned long timeout = millis() + 5000;
-        bool gotResponse = false;
-        int responseCode = 0;
-
-        while (millis() < timeout && testClient.connected()) {
-            if (testClient.available()) {
-                String line = testClient.readStringUntil('\n');
-                line.trim();
-
-                if (line.startsWith("HTTP/")) {
-                    // Parse response code
-                    int space1 = line.indexOf(' ');
-                    int space2 = line.indexOf(' ', space1 + 1);
-                    if (space1 > 0 && space2 > 0) {
-                        responseCode = line.substring(space1 + 1, space2).toInt();
-                    }
-                    Serial.print("[Device] HTTP Response: ");
-                    Serial.println(line);
-                    gotResponse = true;
-                } else if (line.length() > 0 && !gotResponse) {
-                    Serial.print("[Device] Response header: ");
-                    Serial.println(line);
-                }
+    // Keep the warm-boot handoff record current (no-op unless something changed)
+    WarmBoot::recordState(deviceState >= STATE_PPP_CONNECTING,
+                          deviceState >= STATE_PPP_UP,
+                          deviceState == STATE_MQTT_CONNECTED,
+                          mqttManager->getClientIndex());
 
-                // Read a few more lines to verify connection
-                if (gotResponse && responseCode > 0) {
-                    break;
-                }
-            }
-            delay(10);
-            yield();
-        }
-
-        if (gotResponse) {
-            Serial.print("[Device] HTTP Status Code: ");
-            Serial.println(responseCode);
-            if (responseCode == 200 || responseCode == 301 || responseCode == 302) {
-                Serial.println("[Device] ✓ Internet connectivity: WORKING");
-                Serial.println("[Device] ✓ DNS resolution: WORKING");
-                Serial.println("[Device] ✓ HTTP connectivity: WORKING");
-            } else {
-                Serial.print("[Device] ⚠ Got HTTP ");
-                Serial.print(responseCode);
-                Serial.println(" (unexpected)");
-            }
-        } else {
-            Serial.println("[Device] ⚠ Connected but no HTTP response received");
-        }
-
-        testClient.stop();
-        Serial.println("[Device] Connection closed");
-    } else {
-        Serial.println(" FAILED!");
-        Serial.print("[Device] Connection attempt took: ");
-        Serial.print(connectTime);
-        Serial.println(" ms");
-
-        int errorCode = testClient.getWriteError();
-        Serial.print("[Device] Error code: ");
-        Serial.println(errorCode);
-
-        if (errorCode == -11) {
-            Serial.println("[Device] ✗ DNS resolution FAILED (hostname not resolved)");
-            Serial.println("[Device] This indicates ESP32 PPP stack is not initialized");
-            Serial.println("[Device] Network interface cannot resolve DNS");
-        } else {
-            Serial.println("[Device] ✗ Connection FAILED (network unreachable)");
-        }
-    }
-
-    Serial.println("[Device] ========================================");
-    Serial.flush();
-    delay(500);
-}
-
-/**
- * Handle incoming MQTT command messages.
- * Processes gate open commands with validation, cooldown, dedupe, and relay control.
- */
-void handleMqttCommand(const char* topic, const char* payload) {
-    if (mqttManager == nullptr || !mqttManager->isConnected()) {
-        Serial.println("[Gate] ERROR: Cannot handle command - MQTT not connected");
-        return;
-    }
-
-    Serial.print("[Gate] Command received on topic: ");
-    Serial.print(topic);
-    Serial.print(", payload: ");
-    Serial.println(payload);
-
-    // Parse command JSON
-    CommandResult cmd;
-    if (!Protocol::parseCommand(payload, cmd)) {
-        Serial.println("[Gate] Invalid payload - attempting to extract requestId for BAD_PAYLOAD ACK");
-        char ackJson[256];
-        // Try to extract requestId from raw JSON for error reporting
-        char requestId[37] = "";
-        StaticJsonDocument<256> errorDoc;
-        DeserializationError error = deserializeJson(errorDoc, payload);
-        if (!error && errorDoc.containsKey("requestId") && errorDoc["requestId"].is<const char*>()) {
-            strncpy(requestId, errorDoc["requestId"].as<const char*>(), sizeof(requestId) - 1);
-            requestId[sizeof(requestId) - 1] = '\0';
-        }
-        Protocol::createAck(requestId[0] != '\0' ? requestId : "", false, "BAD_PAYLOAD", ackJson, sizeof(ackJson));
-        mqttManager->publish(MQTT_ACK_TOPIC, ackJson, false);
-        return;
-    }
-
-    // Validate requestId is non-empty
-    if (cmd.requestId[0] == '\0') {
-        Serial.println("[Gate] Empty requestId - publishing BAD_PAYLOAD ACK");
-        char ackJson[256];
-        Protocol::createAck(cmd.requestId, false, "BAD_PAYLOAD", ackJson, sizeof(ackJson));
-        mqttManager->publish(MQTT_ACK_TOPIC, ackJson, false);
-        return;
-    }
-
-    Serial.print("[Gate] Parsed command: requestId=");
-    Serial.print(cmd.requestId);
-    Serial.print(", command=");
-    Serial.print(cmd.command);
-    Serial.print(", userId=");
-    Serial.print(cmd.userId);
-    Serial.print(", issuedAt=");
-    Serial.println(cmd.issuedAt);
-
-    // Check if command is "open"
-    if (strcmp(cmd.command, "open") != 0) {
-        Serial.print("[Gate] Unknown command: ");
-        Serial.print(cmd.command);
-        Serial.println(" - publishing UNKNOWN_COMMAND ACK");
-        char ackJson[256];
-        Protocol::createAck(cmd.requestId, false, "UNKNOWN_COMMAND", ackJson, sizeof(ackJson));
-        mqttManager->publish(MQTT_ACK_TOPIC, ackJson, false);
-        return;
-    }
-
-    // Check dedupe (idempotency)
-    if (GateControl::wasProcessed(cmd.requestId)) {
-        Serial.print("[Gate] Dedupe hit for requestId: ");
-        Serial.print(cmd.requestId);
-        Serial.println(" - publishing idempotent success ACK");
-        char ackJson[256];
-        Protocol::createAck(cmd.requestId, true, nullptr, ackJson, sizeof(ackJson));
-        mqttManager->publish(MQTT_ACK_TOPIC, ackJson, false);
-        Serial.print("[Gate] ACK published: ok=true (idempotent) for requestId ");
-        Serial.println(cmd.requestId);
-        return;
-    }
-
-    // Check cooldown
-    uint32_t nowMs = millis();
-    uint32_t remainingMs = 0;
-    if (!GateControl::canExecuteNow(nowMs, remainingMs)) {
-        Serial.print("[Gate] Cooldown active - remaining: ");
-        Serial.print(remainingMs);
-        Serial.println("ms - publishing COOLDOWN ACK");
-        char ackJson[256];
-        Protocol::createAck(cmd.requestId, false, "COOLDOWN", ackJson, sizeof(ackJson));
-        mqttManager->publish(MQTT_ACK_TOPIC, ackJson, false);
-        Serial.print("[Gate] ACK published: ok=false, errorCode=COOLDOWN for requestId ");
-        Serial.println(cmd.requestId);
-        return;
-    }
-
-    // Activate relay
-    Serial.println("[Gate] Activating relay pulse...");
-    bool relaySuccess = Relay::activatePulse();
-
-    if (relaySuccess) {
-        // Record gate open and mark request as processed
-        GateControl::recordOpen(nowMs);
-        GateControl::markProcessed(cmd.requestId);
-
-        // Publish success ACK
-        char ackJson[256];
-        Protocol::createAck(cmd.requestId, true, nullptr, ackJson, sizeof(ackJson));
-        if (mqttManager->publish(MQTT_ACK_TOPIC, ackJson, false)) {
-            Serial.print("[Gate] ACK published: ok=true for requestId ");
-            Serial.println(cmd.requestId);
-        } else {
-            Serial.println("[Gate] ERROR: Failed to publish ACK");
-        }
-    } else {
-        // Publish failure ACK
-        Serial.println("[Gate] Relay activation failed - publishing RELAY_FAIL ACK");
-        char ackJson[256];
-        Protocol::createAck(cmd.requestId, false, "RELAY_FAIL", ackJson, sizeof(ackJson));
-        mqttManager->publish(MQTT_ACK_TOPIC, ackJson, false);
-        Serial.print("[Gate] ACK published: ok=false, errorCode=RELAY_FAIL for requestId ");
-        Serial.println(cmd.requestId);
-    }
+    // Yield until the next scheduled task is due, bounded so the modem keeps being drained
+    unsigned long waitMs = scheduler.msUntilNextDue(millis(), NETWORK_LOOP_IDLE_MS);
+    vTaskDelay(pdMS_TO_TICKS(waitMs > 0 ? waitMs : 1));
 }
@@ -0,0 +1,154 @@
+#include "AtQueue.h"
+#include "util/Log.h"
+#include <string.h>
+
+AtQueue::AtQueue(ModemStream& stream)
+    : stream(&stream), active(-1), sentAt(0), nextSeq(0) {
+    for (uint8_t i = 0; i < MODEM_AT_QUEUE_LEN; i++) {
+        slots[i].used = false;
+    }
+}
+
+void AtQueue::setStream(ModemStream& target) {
+    if (active < 0) {
+        stream = &target;
+    }
+}
+
+bool AtQueue::enqueue(const char* cmd, AtPriority priority, unsigned long timeoutMs,
+                      AtCallback done, void* ctx, AtLineHandler onLine, const char* expected) {
+    for (uint8_t i = 0; i < MODEM_AT_QUEUE_LEN; i++) {
+        Slot& slot = slots[i];
+        if (slot.used) {
+            continue;
+        }
+        strncpy(slot.cmd, cmd, sizeof(slot.cmd) - 1);
+        slot.cmd[sizeof(slot.cmd) - 1] = '\0';
+        slot.timeoutMs = timeoutMs;
+        slot.done = done;
+        slot.ctx = ctx;
+        slot.onLine = onLine;
+        slot.expected = expected;
+        slot.seq = nextSeq++;
+        slot.priority = priority;
+        slot.used = true;
+        return true;
+    }
+    LOG(MODEM_AT_QUEUE_FULL, cmd);
+    return false;
+}
+
+void AtQueue::poll(unsigned long now) {
+    for (;;) {
+        if (active < 0) {
+            int8_t slot = next();
+            if (slot < 0) {
+                return;
+            }
+            start(slot, now);
+        }
+
+        // Read only what has arrived; the response usually completes on a later poll
+        while (stream->responseResult() == AT_RESULT_PENDING && stream->read() >= 0) {
+        }
+
+        AtResult result = stream->responseResult();
+        if (result == AT_RESULT_PENDING) {
+            if (now - sentAt < slots[active].timeoutMs) {
+                return;
+            }
+            LOG(MODEM_AT_RESPONSE_TIMEOUT, slots[active].cmd);
+            result = AT_RESULT_TIMEOUT;
+        }
+        finish(result);
+    }
+}
+
+void AtQueue::readUrcs() {
+    if (active >= 0) {
+        return;
+    }
+    while (stream->read() >= 0) {
+    }
+}
+
+bool AtQueue::busy() const {
+    return active >= 0;
+}
+
+size_t AtQueue::pending() const {
+    size_t n = 0;
+    for (uint8_t i = 0; i < MODEM_AT_QUEUE_LEN; i++) {
+        if (slots[i].used) {
+            n++;
+        }
+    }
+    return n;
+}
+
+void AtQueue::clear() {
+    if (active >= 0) {
+        stream->endResponse();
+        active = -1;
+    }
+    for (uint8_t i = 0; i < MODEM_AT_QUEUE_LEN; i++) {
+        slots[i].used = false;
+    }
+}
+
+void AtQueue::cancel(void* ctx) {
+    for (uint8_t i = 0; i < MODEM_AT_QUEUE_LEN; i++) {
+        Slot& slot = slots[i];
+        if (!slot.used || slot.ctx != ctx) {
+            continue;
+        }
+        if (i == active) {
+            slot.done = nullptr;
+        } else {
+            slot.used = false;
+        }
+    }
+}
+
+int8_t AtQueue::next() const {
+    int8_t best = -1;
+    for (uint8_t i = 0; i < MODEM_AT_QUEUE_LEN; i++) {
+        const Slot& slot = slots[i];
+        if (!slot.used) {
+            continue;
+        }
+        if (best < 0 || slot.priority < slots[best].priority ||
+            (slot.priority == slots[best].priority && (int32_t)(slot.seq - slots[best].seq) < 0)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void AtQueue::start(int8_t slot, unsigned long now) {
+    Slot& s = slots[slot];
+    // Bytes not read yet stay in place: the response lines follow them and
+    // ModemStream still routes any URC among them
+    stream->beginResponse(s.expected, s.onLine, s.ctx);
+    stream->print(s.cmd);
+    stream->print("\r\n");
+    active = slot;
+    sentAt = now;
+}
+
+void AtQueue::finish(AtResult result) {
+    Slot& s = slots[active];
+    if (result == AT_RESULT_OK) {
+        LOG(MODEM_AT_RESPONSE, stream->finalLine());
+    } else if (result == AT_RESULT_ERROR) {
+        LOG(MODEM_AT_ERROR, stream->finalLine());
+    }
+    AtCallback done = s.done;
+    void* ctx = s.ctx;
+    stream->endResponse();
+    s.used = false;
+    active = -1;
+    if (done != nullptr) {
+        done(result, ctx);
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef AT_QUEUE_H
+#define AT_QUEUE_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "config/config.h"
+#include "ModemStream.h"
+
+// Lower value is sent first
+enum AtPriority : uint8_t {
+    AT_PRIORITY_HIGH = 0,  // modem bring-up
+    AT_PRIORITY_LOW,       // housekeeping queries (RSSI, ...)
+    AT_PRIORITY_COUNT
+};
+
+/**
+ * Called once per command with its outcome. The command's slot is already
+ * free, so the callback may queue follow-up commands.
+ */
+typedef void (*AtCallback)(AtResult result, void* ctx);
+
+/**
+ * Non-blocking AT command queue.
+ * Commands wait in fixed slots; poll() sends the oldest of the highest
+ * priority when the UART is free, reads whatever the modem has sent, and
+ * completes the command in flight on its final result code or its timeout.
+ * The next command goes out in the same poll() that completed the previous
+ * one. Response lines are matched by ModemStream, so bytes read by anyone
+ * else (TinyGSM) still count. Whatever poll() reads while a command is in
+ * flight is consumed, so the owner only polls when no one else needs those
+ * bytes (see ModemManager::isAtQueueHeld()). Used from the network task only.
+ */
+class AtQueue {
+public:
+    explicit AtQueue(ModemStream& stream);
+
+    /**
+     * Send on another stream from the next command on (CMUX channel opened or
+     * closed). Only while nothing is in flight.
+     */
+    void setStream(ModemStream& stream);
+
+    /**
+     * Queue a command (copied, at most MODEM_AT_CMD_MAX - 1 characters).
+     * onLine and expected as for ModemStream::beginResponse(); expected must
+     * outlive the command. Returns false if the queue is full.
+     */
+    bool enqueue(const char* cmd, AtPriority priority, unsigned long timeoutMs,
+                 AtCallback done = nullptr, void* ctx = nullptr,
+                 AtLineHandler onLine = nullptr, const char* expected = nullptr);
+
+    /**
+     * Drive the queue (call every loop pass). Never waits for the modem.
+     */
+    void poll(unsigned long now);
+
+    /**
+     * Read what has arrived while nothing is in flight, so ModemStream routes
+     * the URCs among it. Only for a caller that knows no one else reads the
+     * stream now (data session bring-up, before MQTT or HTTPS use it).
+     */
+    void readUrcs();
+
+    /**
+     * A command is in flight: its response has not arrived yet, so nobody else
+     * may send on the UART.
+     */
+    bool busy() const;
+
+    /**
+     * Commands queued or in flight.
+     */
+    size_t pending() const;
+
+    /**
+     * Drop every command (modem reset). Callbacks are not called.
+     */
+    void clear();
+
+    /**
+     * Drop the commands queued with ctx (their owner gave up on them). One
+     * already in flight still completes, without its callback.
+     */
+    void cancel(void* ctx);
+
+private:
+    struct Slot {
+        char cmd[MODEM_AT_CMD_MAX];
+        unsigned long timeoutMs;
+        AtCallback done;
+        void* ctx;
+        AtLineHandler onLine;
+        const char* expected;
+        uint32_t seq;       // enqueue order within a priority
+        uint8_t priority;
+        bool used;
+    };
+
+    int8_t next() const;
+    void start(int8_t slot, unsigned long now);
+    void finish(AtResult result);
+
+    ModemStream* stream;
+    Slot slots[MODEM_AT_QUEUE_LEN];
+    int8_t active;          // slot in flight, -1 if none
+    unsigned long sentAt;
+    uint32_t nextSeq;
+};
+
+#endif // AT_QUEUE_H
@@ -0,0 +1,404 @@
+#include "Cmux.h"
+#include "util/Log.h"
+#include <string.h>
+
+static const uint8_t FLAG = 0xF9;
+static const uint8_t EA = 0x01;
+static const uint8_t CR = 0x02;
+static const uint8_t PF = 0x10;
+
+// Frame types (control field without P/F)
+static const uint8_t SABM = 0x2F;
+static const uint8_t UA = 0x63;
+static const uint8_t DM = 0x0F;
+static const uint8_t DISC = 0x43;
+static const uint8_t UIH = 0xEF;
+static const uint8_t UI = 0x03;
+
+// Control channel message types (without EA and C/R)
+static const uint8_t MSG_CLD = 0xC0;    // multiplexer close down
+static const uint8_t MSG_MSC = 0xE0;    // modem status command
+
+// MSC V.24 signals: EA | RTC | RTR, plus FC to stop the sender
+static const uint8_t V24_READY = 0x0D;
+static const uint8_t V24_FC = 0x02;
+
+// FCS of a frame with a correct checksum byte appended
+static const uint8_t CRC_GOOD = 0xCF;
+
+// --- CmuxChannel ---
+
+CmuxChannel::CmuxChannel()
+    : mux(nullptr), dlci(0), open(false), stopped(false), rxHead(0), rxLen(0), txLen(0), dropped(0) {
+}
+
+void CmuxChannel::attach(Cmux* owner, uint8_t channelDlci) {
+    mux = owner;
+    dlci = channelDlci;
+}
+
+void CmuxChannel::reset() {
+    open = false;
+    stopped = false;
+    rxHead = 0;
+    rxLen = 0;
+    txLen = 0;
+}
+
+int CmuxChannel::available() {
+    if (rxLen == 0) {
+        mux->poll();
+    }
+    return rxLen;
+}
+
+int CmuxChannel::read() {
+    if (rxLen == 0) {
+        mux->poll();
+        if (rxLen == 0) {
+            return -1;
+        }
+    }
+    uint8_t c = rx[rxHead];
+    rxHead = (rxHead + 1) % sizeof(rx);
+    rxLen--;
+    // Resume the modem once the ring has drained to a quarter
+    if (stopped && rxLen <= sizeof(rx) / 4) {
+        stopped = false;
+        mux->sendModemStatus(dlci, false);
+    }
+    return c;
+}
+
+int CmuxChannel::peek() {
+    if (rxLen == 0) {
+        mux->poll();
+        if (rxLen == 0) {
+            return -1;
+        }
+    }
+    return rx[rxHead];
+}
+
+void CmuxChannel::flush() {
+    sendPending();
+    mux->serial.flush();
+}
+
+size_t CmuxChannel::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t CmuxChannel::write(const uint8_t* buffer, size_t size) {
+    if (!open) {
+        return 0;
+    }
+    size_t done = 0;
+    while (done < size) {
+        size_t n = sizeof(tx) - txLen;
+        if (n > size - done) {
+            n = size - done;
+        }
+        memcpy(tx + txLen, buffer + done, n);
+        txLen += n;
+        done += n;
+        if (txLen == sizeof(tx)) {
+            sendPending();
+        }
+    }
+    return size;
+}
+
+bool CmuxChannel::isOpen() const {
+    return open;
+}
+
+uint32_t CmuxChannel::getDroppedCount() const {
+    return dropped;
+}
+
+void CmuxChannel::push(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (rxLen == sizeof(rx)) {
+            dropped += len - i;
+            LOG(CMUX_RX_OVERFLOW, dlci, (unsigned int)(len - i));
+            return;
+        }
+        rx[(rxHead + rxLen) % sizeof(rx)] = data[i];
+        rxLen++;
+    }
+    // Ask the modem to hold off while there is still room for frames in flight
+    if (!stopped && rxLen >= sizeof(rx) * 3 / 4) {
+        stopped = true;
+        mux->sendModemStatus(dlci, true);
+    }
+}
+
+size_t CmuxChannel::rxCount() const {
+    return rxLen;
+}
+
+void CmuxChannel::sendPending() {
+    if (txLen == 0) {
+        return;
+    }
+    mux->sendFrame(dlci, UIH, tx, txLen);
+    txLen = 0;
+}
+
+// --- Cmux ---
+
+Cmux::Cmux(HardwareSerial& serial)
+    : serial(serial), controlOpen(false), rxState(RX_FLAG), rxAddress(0), rxControl(0), rxLen(0),
+      rxPos(0), rxCrc(0xFF), rxValid(false) {
+    for (uint8_t i = 0; i < CMUX_CHANNELS; i++) {
+        channels[i].attach(this, i + 1);
+    }
+}
+
+void Cmux::begin() {
+    reset();
+    sendFrame(0, SABM | PF, nullptr, 0);
+}
+
+void Cmux::poll() {
+    uint8_t buf[64];
+    int n;
+    while ((n = serial.available()) > 0) {
+        if (n > (int)sizeof(buf)) {
+            n = sizeof(buf);
+        }
+        size_t got = serial.read(buf, (size_t)n);
+        if (got == 0) {
+            break;
+        }
+        for (size_t i = 0; i < got; i++) {
+            feed(buf[i]);
+        }
+    }
+    for (uint8_t i = 0; i < CMUX_CHANNELS; i++) {
+        channels[i].sendPending();
+    }
+}
+
+bool Cmux::isOpen() const {
+    if (!controlOpen) {
+        return false;
+    }
+    for (uint8_t i = 0; i < CMUX_CHANNELS; i++) {
+        if (!channels[i].open) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Cmux::close() {
+    const uint8_t cld[] = {MSG_CLD | CR | EA, EA};  // CLD, length 0
+    sendFrame(0, UIH, cld, sizeof(cld));
+    serial.flush();
+    reset();
+}
+
+void Cmux::reset() {
+    controlOpen = false;
+    for (uint8_t i = 0; i < CMUX_CHANNELS; i++) {
+        channels[i].reset();
+    }
+    rxState = RX_FLAG;
+}
+
+CmuxChannel& Cmux::channel(uint8_t dlci) {
+    return channels[(dlci >= 1 && dlci <= CMUX_CHANNELS) ? dlci - 1 : 0];
+}
+
+/**
+ * CRC-8 of 27.010 (x^8 + x^2 + x + 1, reflected), one byte at a time. The
+ * header is only a few bytes, so no table.
+ */
+uint8_t Cmux::crc(uint8_t crc, uint8_t b) {
+    crc ^= b;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x01) ? (crc >> 1) ^ 0xE0 : crc >> 1;
+    }
+    return crc;
+}
+
+/**
+ * Frames we send are commands (C/R set). The FCS covers address, control and
+ * length (UIH), or the whole frame for the other types, which carry no data here.
+ */
+void Cmux::sendFrame(uint8_t dlci, uint8_t control, const uint8_t* data, size_t len) {
+    uint8_t header[5];
+    size_t h = 0;
+    header[h++] = FLAG;
+    header[h++] = (uint8_t)((dlci << 2) | CR | EA);
+    header[h++] = control;
+    if (len <= 127) {
+        header[h++] = (uint8_t)((len << 1) | EA);
+    } else {
+        header[h++] = (uint8_t)((len & 0x7F) << 1);
+        header[h++] = (uint8_t)(len >> 7);
+    }
+    uint8_t fcs = 0xFF;
+    for (size_t i = 1; i < h; i++) {
+        fcs = crc(fcs, header[i]);
+    }
+    uint8_t trailer[2] = {(uint8_t)(0xFF - fcs), FLAG};
+
+    serial.write(header, h);
+    if (len > 0) {
+        serial.write(data, len);
+    }
+    serial.write(trailer, sizeof(trailer));
+}
+
+void Cmux::sendModemStatus(uint8_t dlci, bool stop) {
+    const uint8_t msc[] = {
+        MSG_MSC | CR | EA,
+        (2 << 1) | EA,                              // length 2
+        (uint8_t)((dlci << 2) | CR | EA),
+        (uint8_t)(V24_READY | (stop ? V24_FC : 0))
+    };
+    sendFrame(0, UIH, msc, sizeof(msc));
+}
+
+void Cmux::feed(uint8_t b) {
+    switch (rxState) {
+        case RX_FLAG:
+            if (b == FLAG) {
+                rxState = RX_ADDRESS;
+            }
+            break;
+
+        case RX_ADDRESS:
+            if (b == FLAG) {
+                break;  // back-to-back flags
+            }
+            rxAddress = b;
+            rxCrc = crc(0xFF, b);
+            rxState = RX_CONTROL;
+            break;
+
+        case RX_CONTROL:
+            rxControl = b;
+            rxCrc = crc(rxCrc, b);
+            rxState = RX_LENGTH;
+            break;
+
+        case RX_LENGTH:
+            rxCrc = crc(rxCrc, b);
+            rxLen = b >> 1;
+            rxPos = 0;
+            rxState = (b & EA) ? (rxLen > 0 ? RX_DATA : RX_FCS) : RX_LENGTH2;
+            break;
+
+        case RX_LENGTH2:
+            rxCrc = crc(rxCrc, b);
+            rxLen |= (uint16_t)b << 7;
+            rxState = rxLen > 0 ? RX_DATA : RX_FCS;
+            break;
+
+        case RX_DATA:
+            // Over-long frames are consumed but dropped
+            if (rxPos < sizeof(rxFrame)) {
+                rxFrame[rxPos] = b;
+            }
+            rxPos++;
+            if ((rxControl & ~PF) != UIH && (rxControl & ~PF) != UI) {
+                rxCrc = crc(rxCrc, b);
+            }
+            if (rxPos == rxLen) {
+                rxState = RX_FCS;
+            }
+            break;
+
+        case RX_FCS:
+            rxValid = crc(rxCrc, b) == CRC_GOOD && rxLen <= sizeof(rxFrame);
+            rxState = RX_END;
+            break;
+
+        case RX_END:
+            if (b == FLAG) {
+                if (rxValid) {
+                    handleFrame();
+                } else {
+                    LOG(CMUX_BAD_FRAME, rxAddress >> 2);
+                }
+                rxState = RX_ADDRESS;  // the closing flag may open the next frame
+            } else {
+                rxState = RX_FLAG;
+            }
+            break;
+    }
+}
+
+void Cmux::handleFrame() {
+    uint8_t dlci = rxAddress >> 2;
+    uint8_t type = rxControl & ~PF;
+    CmuxChannel* ch = (dlci >= 1 && dlci <= CMUX_CHANNELS) ? &channels[dlci - 1] : nullptr;
+
+    switch (type) {
+        case UA:
+            if (dlci == 0) {
+                if (!controlOpen) {
+                    controlOpen = true;
+                    for (uint8_t i = 1; i <= CMUX_CHANNELS; i++) {
+                        sendFrame(i, SABM | PF, nullptr, 0);
+                    }
+                }
+            } else if (ch != nullptr && !ch->open) {
+                ch->open = true;
+                sendModemStatus(dlci, false);
+                LOG(CMUX_CHANNEL_OPEN, dlci);
+            }
+            break;
+
+        case DM:
+            if (ch != nullptr) {
+                ch->open = false;
+            }
+            LOG(CMUX_CHANNEL_REFUSED, dlci);
+            break;
+
+        case DISC:
+            sendFrame(dlci, UA | PF, nullptr, 0);
+            if (dlci == 0) {
+                reset();
+            } else if (ch != nullptr) {
+                ch->open = false;
+            }
+            LOG(CMUX_CHANNEL_CLOSED, dlci);
+            break;
+
+        case UIH:
+        case UI:
+            if (dlci == 0) {
+                handleControl(rxFrame, rxLen);
+            } else if (ch != nullptr) {
+                ch->push(rxFrame, rxLen);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * Control channel messages from the modem. Commands other than MSC are not
+ * answered; the A7670 only sends MSC in practice.
+ */
+void Cmux::handleControl(const uint8_t* data, size_t len) {
+    if (len < 2 || (data[0] & CR) == 0) {
+        return;  // responses to our commands need no action
+    }
+    if ((data[0] & 0xFC) == MSG_MSC) {
+        // Respond with the same values, C/R cleared
+        uint8_t reply[8];
+        size_t n = len < sizeof(reply) ? len : sizeof(reply);
+        memcpy(reply, data, n);
+        reply[0] &= ~CR;
+        sendFrame(0, UIH, reply, n);
+    }
+}
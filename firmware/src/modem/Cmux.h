@@ -0,0 +1,143 @@
+#ifndef CMUX_H
+#define CMUX_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <HardwareSerial.h>
+#include "config/config.h"
+
+class Cmux;
+
+/**
+ * One virtual serial port (DLCI) of the multiplexer.
+ * Received data waits in a fixed ring until read; writes are collected into
+ * one UIH frame, sent when it is full, on flush() or on the next Cmux::poll().
+ * available() polls the multiplexer, so a reader waiting on it (TinyGSM) keeps
+ * the UART drained for every channel.
+ */
+class CmuxChannel : public Stream {
+public:
+    CmuxChannel();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    /**
+     * The modem acknowledged the channel (UA to our SABM).
+     */
+    bool isOpen() const;
+
+    /**
+     * Bytes dropped because the receive ring was full.
+     */
+    uint32_t getDroppedCount() const;
+
+private:
+    friend class Cmux;
+
+    void attach(Cmux* mux, uint8_t dlci);
+    void reset();
+    void push(const uint8_t* data, size_t len);
+    size_t rxCount() const;
+    void sendPending();
+
+    Cmux* mux;
+    uint8_t dlci;
+    bool open;
+    bool stopped;       // we asked the modem to stop sending (MSC FC)
+    uint8_t rx[CMUX_CHANNEL_RX];
+    uint16_t rxHead;    // next byte to read
+    uint16_t rxLen;
+    uint8_t tx[CMUX_FRAME_MAX];
+    uint8_t txLen;
+    uint32_t dropped;
+};
+
+/**
+ * 3GPP TS 27.010 basic-option multiplexer over the modem UART (AT+CMUX=0).
+ * DLCI 0 is the control channel; DLCIs 1..CMUX_CHANNELS carry independent AT
+ * sessions, so a long transfer on one does not hold up responses and URCs on
+ * another. Receive flow control per channel through MSC (FC bit) when its ring
+ * fills up. No heap allocation. Used from the network task only.
+ */
+class Cmux {
+public:
+    explicit Cmux(HardwareSerial& serial);
+
+    /**
+     * Start the multiplexer once the modem has answered OK to AT+CMUX=0:
+     * open the control channel, then every data channel. Non-blocking, the
+     * acknowledgements are handled by poll().
+     */
+    void begin();
+
+    /**
+     * Read everything the UART holds, hand payloads to their channels and send
+     * frames waiting in the channels' transmit buffers.
+     */
+    void poll();
+
+    /**
+     * Control channel and every data channel are open.
+     */
+    bool isOpen() const;
+
+    /**
+     * Send the multiplexer close-down command (back to plain AT mode). Sent even
+     * if nothing is open here: after an ESP32-only reset the modem may still be
+     * multiplexing.
+     */
+    void close();
+
+    /**
+     * Forget all channel state without sending anything (modem reset).
+     */
+    void reset();
+
+    /**
+     * Data channel dlci (1..CMUX_CHANNELS).
+     */
+    CmuxChannel& channel(uint8_t dlci);
+
+private:
+    friend class CmuxChannel;
+
+    enum RxState : uint8_t {
+        RX_FLAG,
+        RX_ADDRESS,
+        RX_CONTROL,
+        RX_LENGTH,
+        RX_LENGTH2,
+        RX_DATA,
+        RX_FCS,
+        RX_END
+    };
+
+    void sendFrame(uint8_t dlci, uint8_t control, const uint8_t* data, size_t len);
+    void sendModemStatus(uint8_t dlci, bool stop);
+    void feed(uint8_t b);
+    void handleFrame();
+    void handleControl(const uint8_t* data, size_t len);
+    static uint8_t crc(uint8_t crc, uint8_t b);
+
+    HardwareSerial& serial;
+    CmuxChannel channels[CMUX_CHANNELS];
+    bool controlOpen;
+
+    // Frame being received
+    RxState rxState;
+    uint8_t rxAddress;
+    uint8_t rxControl;
+    uint16_t rxLen;
+    uint16_t rxPos;
+    uint8_t rxCrc;
+    bool rxValid;
+    uint8_t rxFrame[CMUX_FRAME_MAX_RX];
+};
+
+#endif // CMUX_H
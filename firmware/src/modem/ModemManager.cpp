@@ -1,7 +1,24 @@
 #include "ModemManager.h"
+#include "util/BootReport.h"
+#include "util/WarmBoot.h"
+#include "util/Log.h"
+#include <Preferences.h>
+#include <stdio.h>
+
+static const char* NVS_NAMESPACE = "pgr_modem";
+static const char* NVS_KEY_BAUD = "baud";   // last rate verified good
+static const char* NVS_KEY_STEP = "step";   // MODEM_BAUD_RATES entries given up on
+static const uint32_t BAUD_RATES[] = MODEM_BAUD_RATES;
+static const uint8_t BAUD_RATE_COUNT = sizeof(BAUD_RATES) / sizeof(BAUD_RATES[0]);
+
+volatile uint32_t ModemManager::uartErrors = 0;
 
 ModemManager::ModemManager()
-    : modemSerial(1), ready(false), initStartTime(0), initState(INIT_POWER_ON) {
+    : modemSerial(1), stream(modemSerial, link), auxStream(modemSerial, link), mux(modemSerial),
+      cmuxOpen(false), cmuxDisabled(false), cmuxCloseSent(false), atQueue(stream), ready(false), initStartTime(0),
+      initState(INIT_PROBE), lastAtProbe(0), powerOnAttempts(0), resetOnPowerOn(false), probePending(false),
+      probeResult(AT_RESULT_PENDING), probesLeft(0), warmExpected(false), configFailed(false),
+      baud(MODEM_UART_BAUD), targetBaud(0), errorsAtWindow(0), errorWindowStart(0), bootLineLen(0) {
     // Use Serial1 (UART 1) to match POC
     // Defer hardware initialization to avoid blocking in constructor
     // Hardware will be initialized in init() method
@@ -12,109 +29,148 @@ bool ModemManager::init() {
     unsigned long now = millis();
 
     switch (initState) {
-        case INIT_POWER_ON:
+        case INIT_PROBE:
+            // After a warm reboot the modem is expected to be up (it may be mid-URC) and
+            // still at the rate negotiated before the reboot.
+            warmExpected = WarmBoot::takeModemReuse();
+            #if MODEM_BAUD_NEGOTIATE
+            if (warmExpected) {
+                Preferences prefs;
+                if (prefs.begin(NVS_NAMESPACE, true)) {
+                    baud = prefs.getUInt(NVS_KEY_BAUD, MODEM_UART_BAUD);
+                    prefs.end();
+                }
+            }
+            #endif
+
             // Initialize hardware on first call (deferred from constructor)
-            // Follow the working POC sequence exactly
-            Serial.println("[Modem] Initializing hardware...");
-            Serial.flush();
-            yield();
-
-            // STEP 1: Initialize Serial FIRST (before GPIO) - matches POC
-            Serial.println("[Modem] Initializing UART (Serial1)...");
-            Serial.print("[Modem] TX: ");
-            Serial.print(MODEM_TX_PIN);
-            Serial.print(", RX: ");
-            Serial.print(MODEM_RX_PIN);
-            Serial.print(", Baud: ");
-            Serial.println(MODEM_UART_BAUD);
-            Serial.flush();
-            yield();
-
-            modemSerial.begin(MODEM_UART_BAUD, SERIAL_8N1, MODEM_RX_PIN, MODEM_TX_PIN);
-            yield();
-            delay(2000);  // Give modem time to start (matches POC)
-            yield();
-
-            Serial.println("[Modem] UART initialized");
-            Serial.flush();
-            yield();
-
-            // STEP 2: Configure BOARD_POWERON_PIN (must be HIGH for modem power)
+            LOG(MODEM_UART_INIT, MODEM_TX_PIN, MODEM_RX_PIN, baud);
+            modemSerial.begin(baud, SERIAL_8N1, MODEM_RX_PIN, MODEM_TX_PIN);
+            modemSerial.onReceiveError(onUartError);
+            BootReport::mark(BOOT_PHASE_UART_READY);
+
+            // Modem may still be powered from before an ESP32-only reset: if it
+            // answers AT there is nothing to power up or wait for.
+            #ifdef MODEM_DTR_PIN
+            pinMode(MODEM_DTR_PIN, OUTPUT);
+            digitalWrite(MODEM_DTR_PIN, LOW);
+            #endif
+            // Give a warm modem a few probes before falling back to the power-on sequence
+            probesLeft = warmExpected ? 3 : 1;
+            queueProbe(MODEM_AT_PROBE_TIMEOUT_MS);
+            initState = INIT_PROBE_WAIT;
+            break;
+
+        case INIT_PROBE_WAIT:
+            if (probePending) {
+                break;
+            }
+            // ERROR is an answer too (to bytes sent at the other rate or a close-down frame)
+            if (probeResult == AT_RESULT_OK || probeResult == AT_RESULT_ERROR) {
+                if (warmExpected) {
+                    LOG(MODEM_WARM_RUNNING);
+                }
+                LOG(MODEM_ALREADY_ON);
+                BootReport::mark(BOOT_PHASE_MODEM_AT_OK);
+                initState = INIT_CONFIGURE;
+            } else if (probesLeft > 0) {
+                queueProbe(MODEM_AT_PROBE_TIMEOUT_MS);
+            #if MODEM_CMUX_ENABLED
+            } else if (!cmuxCloseSent) {
+                // After an ESP32-only reset the modem may still be multiplexing
+                LOG(MODEM_CMUX_STALE_CLOSE);
+                mux.close();
+                cmuxCloseSent = true;
+                probesLeft = 1;
+                queueProbe(MODEM_AT_PROBE_TIMEOUT_MS);
+            #endif
+            } else if (baud != MODEM_UART_BAUD) {
+                // The modem was restarted since the rate was negotiated
+                LOG(MODEM_BAUD_PROBE_FALLBACK, (unsigned long)baud, (unsigned long)MODEM_UART_BAUD);
+                setBaud(MODEM_UART_BAUD);
+                cmuxCloseSent = false;
+                probesLeft = 1;
+                queueProbe(MODEM_AT_PROBE_TIMEOUT_MS);
+            } else {
+                if (warmExpected) {
+                    LOG(MODEM_WARM_NOT_RESPONDING);
+                }
+                initState = INIT_POWER_ON;
+            }
+            break;
+
+        case INIT_POWER_ON:
+            // Follow the working POC sequence, minus the fixed sleeps: readiness is
+            // detected in INIT_WAIT_POWER from RDY / AT responses.
+            LOG(MODEM_HW_INIT);
+            detachMux();
+            setBaud(MODEM_UART_BAUD);  // what the modem boots at
+
+            // STEP 1: Configure BOARD_POWERON_PIN (must be HIGH for modem power)
             #ifdef BOARD_POWERON_PIN
-            Serial.println("[Modem] Setting BOARD_POWERON_PIN HIGH...");
-            Serial.flush();
-            yield();
+            LOG(MODEM_POWERON_PIN);
             pinMode(BOARD_POWERON_PIN, OUTPUT);
-            yield();
             digitalWrite(BOARD_POWERON_PIN, HIGH);
-            yield();
-            delay(MODEM_POWER_STABLE_MS);  // Let modem power rail stabilize before reset
-            yield();
             #endif
+            BootReport::mark(BOOT_PHASE_MODEM_POWER_ON);
+
+            initState = INIT_WAIT_RAIL;
+            initStartTime = now;
+            break;
+
+        case INIT_WAIT_RAIL:
+            // Let modem power rail stabilize before reset/power key (non-blocking)
+            if (now - initStartTime < MODEM_POWER_STABLE_MS) {
+                break;
+            }
 
-            // STEP 3: Reset modem sequence (matches POC)
-            Serial.println("[Modem] Resetting modem...");
-            Serial.flush();
-            yield();
-            pinMode(MODEM_RESET_PIN, OUTPUT);
-            yield();
-            digitalWrite(MODEM_RESET_PIN, !MODEM_RESET_LEVEL);
-            yield();
-            delay(100);
-            yield();
-            digitalWrite(MODEM_RESET_PIN, MODEM_RESET_LEVEL);
-            yield();
-            delay(2600);  // Matches POC delay
-            yield();
-            digitalWrite(MODEM_RESET_PIN, !MODEM_RESET_LEVEL);
-            yield();
-            delay(100);
-            yield();
-
-            // STEP 4: Set DTR pin LOW (prevents sleep state)
+            // STEP 2: Reset modem sequence (matches POC). Only needed to recover a
+            // wedged or running modem; a freshly powered modem boots from the power
+            // key alone, while a running one would be switched off by it.
+            if (powerOnAttempts > 0 || resetOnPowerOn) {
+                LOG(MODEM_RESETTING);
+                pinMode(MODEM_RESET_PIN, OUTPUT);
+                resetPin();
+                delay(100);
+                resetOnPowerOn = false;
+            }
+
+            // STEP 3: Set DTR pin LOW (prevents sleep state)
             #ifdef MODEM_DTR_PIN
-            Serial.println("[Modem] Setting MODEM_DTR_PIN LOW...");
-            Serial.flush();
-            yield();
             pinMode(MODEM_DTR_PIN, OUTPUT);
-            yield();
             digitalWrite(MODEM_DTR_PIN, LOW);
-            yield();
-            delay(100);
-            yield();
             #endif
 
-            // STEP 5: Power on sequence (matches POC)
-            Serial.println("[Modem] Powering on modem...");
-            Serial.flush();
-            yield();
+            // STEP 4: Power on sequence (matches POC)
+            LOG(MODEM_POWERING_ON);
             pinMode(BOARD_PWRKEY_PIN, OUTPUT);
-            yield();
-            digitalWrite(BOARD_PWRKEY_PIN, LOW);
-            yield();
-            delay(100);
-            yield();
-            digitalWrite(BOARD_PWRKEY_PIN, HIGH);
-            yield();
-            delay(MODEM_POWERON_PULSE_WIDTH_MS);
-            yield();
-            digitalWrite(BOARD_PWRKEY_PIN, LOW);
-            yield();
-            delay(100);
-            yield();
-
-            Serial.println("[Modem] Hardware initialized, waiting for modem to boot...");
-            Serial.flush();
-            yield();
-
+            powerOn();
+            powerOnAttempts++;
+
+            LOG(MODEM_WAIT_BOOT);
+            flushSerial();
+            bootLineLen = 0;
+            lastAtProbe = now;
+            probeResult = AT_RESULT_PENDING;  // the modem before the power cycle answered
             initState = INIT_WAIT_POWER;
             initStartTime = now;
             break;
 
         case INIT_WAIT_POWER:
-            // Wait for modem to boot (typically 3-5 seconds)
-            if (now - initStartTime > 5000) {
-                Serial.println("[Modem] Starting AT handshake...");
+            // Advance as soon as the modem reports RDY or answers AT, instead of a fixed wait
+            if (scanBootUrcs()) {
+                LOG(MODEM_RDY);
+                initState = INIT_AT_HANDSHAKE;
+                initStartTime = now;
+            } else if (!probePending && probeResult == AT_RESULT_OK) {
+                LOG(MODEM_AT_OK_BEFORE_RDY);
+                BootReport::mark(BOOT_PHASE_MODEM_AT_OK);
+                initState = INIT_CONFIGURE;
+            } else if (!probePending && now - lastAtProbe >= MODEM_AT_PROBE_INTERVAL_MS) {
+                lastAtProbe = now;
+                queueProbe(MODEM_AT_PROBE_TIMEOUT_MS);
+            } else if (now - initStartTime > MODEM_BOOT_MAX_WAIT_MS) {
+                LOG(MODEM_NO_RDY);
                 flushSerial();
                 initState = INIT_AT_HANDSHAKE;
                 initStartTime = now;
@@ -122,78 +178,408 @@ bool ModemManager::init() {
             break;
 
         case INIT_AT_HANDSHAKE:
-            if (sendATCommand("AT", "OK", AT_CMD_TIMEOUT_MS)) {
-                Serial.println("[Modem] AT handshake OK");
-                initState = INIT_DISABLE_ECHO;
+            if (probePending) {
+                break;
+            }
+            if (probeResult == AT_RESULT_OK) {
+                LOG(MODEM_AT_OK);
+                BootReport::mark(BOOT_PHASE_MODEM_AT_OK);
+                initState = INIT_CONFIGURE;
             } else if (now - initStartTime > AT_INIT_TIMEOUT_MS) {
-                Serial.println("[Modem] AT handshake timeout");
+                LOG(MODEM_AT_TIMEOUT);
                 initState = INIT_POWER_ON;  // Retry from power on
                 return false;
+            } else {
+                queueProbe(AT_CMD_TIMEOUT_MS);
             }
             break;
 
-        case INIT_DISABLE_ECHO:
-            if (sendATCommand("ATE0", "OK", AT_CMD_TIMEOUT_MS)) {
-                Serial.println("[Modem] Echo disabled");
-                initState = INIT_QUERY_SIM;
-            } else {
-                Serial.println("[Modem] Failed to disable echo");
+        case INIT_CONFIGURE:
+            // All configuration and queries go out back to back from the queue
+            configFailed = false;
+            queueConfiguration();
+            initState = INIT_CONFIGURE_WAIT;
+            break;
+
+        case INIT_CONFIGURE_WAIT:
+            if (atQueue.pending() > 0) {
+                break;
+            }
+            if (configFailed) {
+                // The modem is running: restart it rather than switch it off
+                resetOnPowerOn = true;
                 initState = INIT_POWER_ON;
                 return false;
             }
+            targetBaud = nextBaud();
+            initState = (targetBaud != 0 && targetBaud != baud) ? INIT_SET_BAUD : INIT_CMUX;
             break;
 
-        case INIT_QUERY_SIM:
-            if (sendATCommand("AT+CCID", "OK", AT_CMD_TIMEOUT_MS)) {
-                Serial.println("[Modem] SIM query OK");
-                initState = INIT_QUERY_NETWORK;
-            } else {
-                Serial.println("[Modem] SIM query failed (non-critical)");
-                initState = INIT_QUERY_NETWORK;  // Continue anyway
+        case INIT_SET_BAUD:
+            // The modem answers OK at the old rate, then switches
+            {
+                char cmd[24];
+                snprintf(cmd, sizeof(cmd), "AT+IPR=%lu", (unsigned long)targetBaud);
+                LOG(MODEM_BAUD_SWITCH, (unsigned long)targetBaud);
+                probeResult = AT_RESULT_PENDING;
+                probePending = atQueue.enqueue(cmd, AT_PRIORITY_HIGH, AT_CMD_TIMEOUT_MS, onProbeDone, this);
+                initState = INIT_SET_BAUD_WAIT;
+            }
+            break;
+
+        case INIT_SET_BAUD_WAIT:
+            if (probePending) {
+                break;
             }
+            if (probeResult != AT_RESULT_OK) {
+                LOG(MODEM_BAUD_REJECTED, (unsigned long)targetBaud, (unsigned long)baud);
+                dropBaud();
+                initState = INIT_CMUX;
+                break;
+            }
+            setBaud(targetBaud);
+            probesLeft = MODEM_BAUD_VERIFY_ROUNDS;
+            queueProbe(AT_CMD_TIMEOUT_MS, "ATI");
+            initState = INIT_VERIFY_BAUD;
             break;
 
-        case INIT_QUERY_NETWORK:
-            if (sendATCommand("AT+CREG?", "OK", AT_CMD_TIMEOUT_MS)) {
-                Serial.println("[Modem] Network registration query OK");
-                initState = INIT_QUERY_RSSI;
+        case INIT_VERIFY_BAUD:
+            // Round trips with a multi-line answer, not just OK
+            if (probePending) {
+                break;
+            }
+            if (probeResult == AT_RESULT_OK && probesLeft > 0) {
+                queueProbe(AT_CMD_TIMEOUT_MS, "ATI");
+            } else if (probeResult == AT_RESULT_OK) {
+                Preferences prefs;
+                if (prefs.begin(NVS_NAMESPACE, false)) {
+                    prefs.putUInt(NVS_KEY_BAUD, baud);
+                    prefs.end();
+                }
+                LOG(MODEM_BAUD_OK, (unsigned long)baud);
+                initState = INIT_CMUX;
             } else {
-                Serial.println("[Modem] Network query failed (non-critical)");
-                initState = INIT_QUERY_RSSI;  // Continue anyway
+                // The modem is at a rate we cannot talk at. Ask it back to the default
+                // (it may get through), then reset it: the rate may be kept across a restart.
+                LOG(MODEM_BAUD_VERIFY_FAILED, (unsigned long)baud, (unsigned long)MODEM_UART_BAUD);
+                dropBaud();
+                char cmd[24];
+                snprintf(cmd, sizeof(cmd), "AT+IPR=%lu", (unsigned long)MODEM_UART_BAUD);
+                probeResult = AT_RESULT_PENDING;
+                probePending = atQueue.enqueue(cmd, AT_PRIORITY_HIGH, AT_CMD_TIMEOUT_MS, onProbeDone, this);
+                initState = INIT_RESTORE_BAUD;
+            }
+            break;
+
+        case INIT_RESTORE_BAUD:
+            if (probePending) {
+                break;
+            }
+            resetOnPowerOn = true;
+            initState = INIT_POWER_ON;
+            return false;
+
+        case INIT_CMUX:
+            // Last step: from here on every AT command is framed
+            #if MODEM_CMUX_ENABLED
+            if (!cmuxDisabled) {
+                probeResult = AT_RESULT_PENDING;
+                probePending = atQueue.enqueue("AT+CMUX=0", AT_PRIORITY_HIGH, AT_CMD_TIMEOUT_MS, onProbeDone, this);
+                initState = INIT_CMUX_WAIT;
+                break;
             }
+            #endif
+            initState = INIT_COMPLETE;
             break;
 
-        case INIT_QUERY_RSSI:
-            if (sendATCommand("AT+CSQ", "OK", AT_CMD_TIMEOUT_MS)) {
-                Serial.println("[Modem] Signal strength query OK");
+        case INIT_CMUX_WAIT:
+            if (probePending) {
+                break;
+            }
+            if (probeResult != AT_RESULT_OK) {
+                LOG(MODEM_CMUX_REJECTED);
+                cmuxDisabled = true;
                 initState = INIT_COMPLETE;
-            } else {
-                Serial.println("[Modem] RSSI query failed (non-critical)");
-                initState = INIT_COMPLETE;  // Continue anyway
+                break;
+            }
+            mux.begin();
+            initStartTime = now;
+            initState = INIT_CMUX_OPEN;
+            break;
+
+        case INIT_CMUX_OPEN:
+            mux.poll();
+            if (mux.isOpen()) {
+                attachMux();
+                LOG(MODEM_CMUX_OPEN, CMUX_CHANNELS);
+                initState = INIT_COMPLETE;
+            } else if (now - initStartTime > CMUX_OPEN_TIMEOUT_MS) {
+                // The modem may be multiplexing without answering: close down and restart it
+                LOG(MODEM_CMUX_FAILED);
+                cmuxDisabled = true;
+                mux.close();
+                resetOnPowerOn = true;
+                initState = INIT_POWER_ON;
+                return false;
             }
             break;
 
         case INIT_COMPLETE:
             ready = true;
-            Serial.println("[Modem] Initialization complete");
+            BootReport::mark(BOOT_PHASE_MODEM_READY);
+            LOG(MODEM_READY);
             return true;
     }
 
     return false;
 }
 
+void ModemManager::poll() {
+    unsigned long now = millis();
+    checkUartErrors(now);
+    if (cmuxOpen) {
+        mux.poll();
+    }
+    // A command already in flight still completes (its response is in the way anyway)
+    if (atQueue.busy() || !isAtQueueHeld()) {
+        atQueue.poll(now);
+    }
+}
+
+AtQueue& ModemManager::getAtQueue() {
+    return atQueue;
+}
+
+bool ModemManager::isAtBusy() const {
+    return !cmuxOpen && atQueue.busy();
+}
+
+bool ModemManager::isAtQueueHeld() const {
+    if (cmuxOpen) {
+        return false;
+    }
+    for (uint8_t i = 0; i < MODEM_MQTT_CLIENTS; i++) {
+        if (stream.link().mqttConnected[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ModemManager::isMuxOpen() const {
+    return cmuxOpen;
+}
+
+ModemStream& ModemManager::getAuxStream() {
+    return cmuxOpen ? auxStream : stream;
+}
+
+/**
+ * Move TinyGSM's stream and the AT queue onto their channels. The queue is idle
+ * here (AT+CMUX=0 was its last command).
+ */
+void ModemManager::attachMux() {
+    stream.setChannel(&mux.channel(CMUX_DLCI_MAIN));
+    auxStream.setChannel(&mux.channel(CMUX_DLCI_AUX));
+    atQueue.setStream(auxStream);
+    cmuxOpen = true;
+}
+
+/**
+ * Back to the plain UART (modem reset: it leaves CMUX mode). Call with the AT
+ * queue cleared.
+ */
+void ModemManager::detachMux() {
+    mux.reset();
+    stream.setChannel(nullptr);
+    auxStream.setChannel(nullptr);
+    atQueue.setStream(stream);
+    cmuxOpen = false;
+}
+
+void ModemManager::queueProbe(unsigned long timeoutMs, const char* cmd) {
+    probeResult = AT_RESULT_PENDING;
+    probePending = atQueue.enqueue(cmd, AT_PRIORITY_HIGH, timeoutMs, onProbeDone, this);
+    if (probesLeft > 0) {
+        probesLeft--;
+    }
+}
+
+/**
+ * Echo off, then URC reports on (see ModemStream), then the SIM, registration
+ * and signal queries. Only a failed ATE0 fails initialization.
+ */
+void ModemManager::queueConfiguration() {
+    atQueue.enqueue("ATE0", AT_PRIORITY_HIGH, AT_CMD_TIMEOUT_MS, onEchoDone, this);
+    atQueue.enqueue("AT+CREG=1", AT_PRIORITY_HIGH, AT_CMD_TIMEOUT_MS, onCregModeDone, this);
+    atQueue.enqueue("AT+CGEREP=2,1", AT_PRIORITY_HIGH, AT_CMD_TIMEOUT_MS, onCgerepDone, this);
+    atQueue.enqueue("AT+CCID", AT_PRIORITY_HIGH, AT_CMD_TIMEOUT_MS, onSimDone, this);
+    atQueue.enqueue("AT+CREG?", AT_PRIORITY_HIGH, AT_CMD_TIMEOUT_MS, onRegDone, this);
+    atQueue.enqueue("AT+CSQ", AT_PRIORITY_HIGH, AT_CMD_TIMEOUT_MS, onRssiDone, this);
+}
+
+/**
+ * Switch the ESP32 side of the UART. Bytes received around the switch are
+ * garbage at one rate or the other, so they are dropped unparsed.
+ */
+void ModemManager::setBaud(uint32_t rate) {
+    if (rate == baud) {
+        return;
+    }
+    modemSerial.updateBaudRate(rate);
+    baud = rate;
+    stream.discardInput();
+    errorsAtWindow = uartErrors;
+    errorWindowStart = millis();
+}
+
+/**
+ * Fastest rate not given up on yet, 0 if none is left (or negotiation is off).
+ */
+uint32_t ModemManager::nextBaud() const {
+    #if MODEM_BAUD_NEGOTIATE
+    Preferences prefs;
+    uint8_t step = 0;
+    if (prefs.begin(NVS_NAMESPACE, true)) {
+        step = prefs.getUChar(NVS_KEY_STEP, 0);
+        prefs.end();
+    }
+    return step < BAUD_RATE_COUNT ? BAUD_RATES[step] : 0;
+    #else
+    return 0;
+    #endif
+}
+
+/**
+ * Give up on the rate being negotiated (or running): the next negotiation tries
+ * the next slower one, and a warm reboot probes at the default rate.
+ */
+void ModemManager::dropBaud() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        return;
+    }
+    uint8_t step = prefs.getUChar(NVS_KEY_STEP, 0);
+    if (step < BAUD_RATE_COUNT) {
+        prefs.putUChar(NVS_KEY_STEP, step + 1);
+    }
+    prefs.putUInt(NVS_KEY_BAUD, MODEM_UART_BAUD);
+    prefs.end();
+}
+
+/**
+ * Framing and parity errors mean the link does not hold at the negotiated rate:
+ * ask the modem back to the default rate and follow it there. If the modem does
+ * not understand the request either, the link fails and the usual recovery
+ * (PPP rebuild, hard reset) brings it back at the default rate.
+ */
+void ModemManager::checkUartErrors(unsigned long now) {
+    if (baud == MODEM_UART_BAUD || !ready) {
+        return;
+    }
+    uint32_t errors = uartErrors - errorsAtWindow;
+    if (errors >= MODEM_BAUD_ERROR_LIMIT) {
+        LOG(MODEM_BAUD_ERRORS, (unsigned long)errors, (unsigned long)baud, (unsigned long)MODEM_UART_BAUD);
+        dropBaud();
+        char cmd[24];
+        snprintf(cmd, sizeof(cmd), "AT+IPR=%lu", (unsigned long)MODEM_UART_BAUD);
+        if (!atQueue.enqueue(cmd, AT_PRIORITY_HIGH, AT_CMD_TIMEOUT_MS, onBaudFallbackDone, this)) {
+            setBaud(MODEM_UART_BAUD);
+        }
+        errorsAtWindow = uartErrors;
+        errorWindowStart = now;
+    } else if (now - errorWindowStart >= MODEM_BAUD_ERROR_WINDOW_MS) {
+        errorsAtWindow = uartErrors;
+        errorWindowStart = now;
+    }
+}
+
+// UART driver event task
+void ModemManager::onUartError(hardwareSerial_error_t error) {
+    if (error == UART_FRAME_ERROR || error == UART_PARITY_ERROR) {
+        uartErrors = uartErrors + 1;
+    }
+}
+
+void ModemManager::onBaudFallbackDone(AtResult result, void* ctx) {
+    (void)result;  // the modem switches after its OK; on a timeout, try the default anyway
+    static_cast<ModemManager*>(ctx)->setBaud(MODEM_UART_BAUD);
+}
+
+void ModemManager::onProbeDone(AtResult result, void* ctx) {
+    ModemManager* self = static_cast<ModemManager*>(ctx);
+    self->probeResult = result;
+    self->probePending = false;
+}
+
+void ModemManager::onEchoDone(AtResult result, void* ctx) {
+    if (result == AT_RESULT_OK) {
+        LOG(MODEM_ECHO_OFF);
+    } else {
+        LOG(MODEM_ECHO_OFF_FAILED);
+        static_cast<ModemManager*>(ctx)->configFailed = true;
+    }
+}
+
+void ModemManager::onCregModeDone(AtResult result, void* ctx) {
+    (void)ctx;
+    if (result != AT_RESULT_OK) {
+        LOG(MODEM_URCS_FAILED);  // non-critical
+    }
+}
+
+void ModemManager::onCgerepDone(AtResult result, void* ctx) {
+    (void)ctx;
+    if (result == AT_RESULT_OK) {
+        LOG(MODEM_URCS_ON);
+    } else {
+        LOG(MODEM_URCS_FAILED);  // non-critical
+    }
+}
+
+void ModemManager::onSimDone(AtResult result, void* ctx) {
+    (void)ctx;
+    if (result == AT_RESULT_OK) {
+        LOG(MODEM_SIM_OK);
+    } else {
+        LOG(MODEM_SIM_FAILED);
+    }
+}
+
+void ModemManager::onRegDone(AtResult result, void* ctx) {
+    (void)ctx;
+    if (result == AT_RESULT_OK) {
+        LOG(MODEM_REG_OK);
+    } else {
+        LOG(MODEM_REG_FAILED);
+    }
+}
+
+void ModemManager::onRssiDone(AtResult result, void* ctx) {
+    (void)ctx;
+    if (result == AT_RESULT_OK) {
+        LOG(MODEM_RSSI_OK);
+    } else {
+        LOG(MODEM_RSSI_FAILED);
+    }
+}
+
 void ModemManager::powerCycle() {
-    Serial.println("[Modem] Power cycling...");
+    LOG(MODEM_POWER_CYCLE);
     powerOff();
     delay(2000);
     powerOn();
     ready = false;
     initState = INIT_POWER_ON;
     initStartTime = 0;
+    atQueue.clear();
+    probePending = false;
+    detachMux();
+    stream.resetLink();
 }
 
 void ModemManager::hardReset() {
-    Serial.println("[Modem] Hard reset...");
+    LOG(MODEM_HARD_RESET);
     resetPin();
     delay(100);
     digitalWrite(MODEM_RESET_PIN, HIGH);
@@ -201,7 +587,11 @@ void ModemManager::hardReset() {
     ready = false;
     initState = INIT_POWER_ON;
     initStartTime = 0;
+    atQueue.clear();
+    probePending = false;
+    detachMux();
     flushSerial();
+    stream.resetLink();
 }
 
 bool ModemManager::isReady() const {
@@ -212,84 +602,30 @@ HardwareSerial* ModemManager::getSerial() {
     return &modemSerial;
 }
 
-bool ModemManager::sendATCommand(const char* cmd, const char* expectedResponse, unsigned long timeoutMs) {
-    flushSerial();
-    modemSerial.print(cmd);
-    modemSerial.print("\r\n");
-    return waitForResponse(expectedResponse, timeoutMs);
+ModemStream& ModemManager::getStream() {
+    return stream;
 }
 
-bool ModemManager::waitForResponse(const char* expectedResponse, unsigned long timeoutMs) {
-    unsigned long startTime = millis();
-    String response = "";
-
-    while (millis() - startTime < timeoutMs) {
-        while (modemSerial.available()) {
-            char c = modemSerial.read();
-            response += c;
-
-            // Check for expected response
-            if (response.indexOf(expectedResponse) >= 0) {
-                Serial.print("[Modem] Response: ");
-                Serial.println(response);
-                return true;
-            }
-
-            // Check for ERROR
-            if (response.indexOf("ERROR") >= 0) {
-                Serial.print("[Modem] Error response: ");
-                Serial.println(response);
-                return false;
-            }
-        }
-        delay(10);
-    }
-
-    Serial.print("[Modem] Timeout waiting for: ");
-    Serial.print(expectedResponse);
-    Serial.print(", got: ");
-    Serial.println(response);
-    return false;
+const ModemLinkState& ModemManager::getLink() const {
+    return stream.link();
 }
 
-String ModemManager::sendATCommandGetResponse(const char* cmd, const char* expectedResponse, unsigned long timeoutMs) {
-    flushSerial();
-    modemSerial.print(cmd);
-    modemSerial.print("\r\n");
-
-    unsigned long startTime = millis();
-    String response = "";
-
-    while (millis() - startTime < timeoutMs) {
-        while (modemSerial.available()) {
-            char c = modemSerial.read();
-            response += c;
-
-            // Check for expected response
-            if (response.indexOf(expectedResponse) >= 0) {
-                // Continue reading until OK or ERROR
-                delay(100);  // Wait for remaining data
-                while (modemSerial.available()) {
-                    response += (char)modemSerial.read();
-                }
-                return response;
-            }
+bool ModemManager::isMqttConnected(uint8_t client) const {
+    return client < MODEM_MQTT_CLIENTS && stream.link().mqttConnected[client];
+}
 
-            // Check for ERROR
-            if (response.indexOf("ERROR") >= 0) {
-                return response;  // Return error response
-            }
-        }
-        delay(10);
-    }
+void ModemManager::setMqttConnected(uint8_t client, bool connected) {
+    stream.setMqttConnected(client, connected);
+}
 
-    return response;  // Return whatever we got (may be empty on timeout)
+bool ModemManager::isRegistered() const {
+    int8_t reg = stream.link().registration;
+    return reg == 1 || reg == 5;
 }
 
 void ModemManager::powerOn() {
-    // Power on sequence matches POC
+    // Power key pulse, matches POC
     // Note: BOARD_POWERON_PIN is set HIGH in init() sequence
-    // This method is kept for compatibility but power-on is done in init()
     yield();
     digitalWrite(BOARD_PWRKEY_PIN, LOW);
     yield();
@@ -318,9 +654,36 @@ void ModemManager::resetPin() {
     digitalWrite(MODEM_RESET_PIN, !MODEM_RESET_LEVEL);
 }
 
+bool ModemManager::scanBootUrcs() {
+    bool rdy = false;
+    while (stream.available()) {
+        char c = (char)stream.read();
+        if (c == '\r' || c == '\n') {
+            if (bootLineLen == 0) {
+                continue;
+            }
+            bootLine[bootLineLen] = '\0';
+            bootLineLen = 0;
+            if (strcmp(bootLine, "RDY") == 0) {
+                BootReport::mark(BOOT_PHASE_MODEM_RDY);
+                rdy = true;
+            } else if (strcmp(bootLine, "PB DONE") == 0) {
+                BootReport::mark(BOOT_PHASE_SIM_READY);
+            } else if (strcmp(bootLine, "+CPIN: READY") == 0) {
+                BootReport::mark(BOOT_PHASE_SIM_READY);
+            }
+            continue;
+        }
+        if (bootLineLen < sizeof(bootLine) - 1) {
+            bootLine[bootLineLen++] = c;
+        }
+    }
+    return rdy;
+}
+
 void ModemManager::flushSerial() {
-    while (modemSerial.available()) {
-        modemSerial.read();
+    while (stream.available()) {
+        stream.read();
     }
 }
 
@@ -5,6 +5,9 @@
 #include <stdint.h>
 #include <HardwareSerial.h>
 #include "config/config.h"
+#include "ModemStream.h"
+#include "AtQueue.h"
+#include "Cmux.h"
 
 /**
  * Manages A7670G cellular modem initialization, power control, and AT commands.
@@ -15,11 +18,48 @@ public:
 
     /**
      * Initialize modem: power on, AT handshake, configure.
-     * Non-blocking, call repeatedly until returns true.
+     * Non-blocking, call repeatedly until returns true (commands go through the
+     * AT queue, so poll() must run too).
      * Returns true when modem is ready.
      */
     bool init();
 
+    /**
+     * Drive the AT command queue. Call every network loop pass.
+     */
+    void poll();
+
+    /**
+     * Non-blocking AT command queue. Code that talks to the modem directly
+     * (TinyGSM) must wait while isAtBusy().
+     */
+    AtQueue& getAtQueue();
+
+    /**
+     * A queued command is waiting for its response on the UART TinyGSM uses.
+     * Never true while CMUX is up: the queue has its own channel then.
+     */
+    bool isAtBusy() const;
+
+    /**
+     * Queued commands wait: the queue shares the plain UART with TinyGSM and an
+     * MQTT session is up. Its +CMQTTRX blocks are only parsed by TinyGSM's
+     * mqtt_handle(), so no one else may read them. Never true while CMUX is up.
+     */
+    bool isAtQueueHeld() const;
+
+    /**
+     * The UART is multiplexed (see MODEM_CMUX_ENABLED).
+     */
+    bool isMuxOpen() const;
+
+    /**
+     * Stream for HTTPS and other long transactions: the auxiliary CMUX channel
+     * (shared with the AT queue, so wait while getAtQueue().busy()), or the
+     * main stream when CMUX is not up.
+     */
+    ModemStream& getAuxStream();
+
     /**
      * Power cycle the modem (power off, then on).
      */
@@ -41,38 +81,106 @@ public:
     HardwareSerial* getSerial();
 
     /**
-     * Send AT command to modem (public interface for PPP configuration).
-     * Returns true if command succeeds (receives expected response).
+     * Modem UART wrapped so that URCs update getLink(). Give this (not
+     * getSerial()) to TinyGSM, so the URCs it reads are seen too.
+     */
+    ModemStream& getStream();
+
+    /**
+     * Connection state cached from URCs (no AT round trip).
      */
-    bool sendATCommand(const char* cmd, const char* expectedResponse, unsigned long timeoutMs);
+    const ModemLinkState& getLink() const;
 
     /**
-     * Send AT command and return the full response string.
-     * Useful for commands that return data (like DNS resolution).
+     * Whether the modem last reported CMQTT client `client` connected.
      */
-    String sendATCommandGetResponse(const char* cmd, const char* expectedResponse, unsigned long timeoutMs);
+    bool isMqttConnected(uint8_t client) const;
+
+    /**
+     * Record a CMQTT client state learned from a command response.
+     */
+    void setMqttConnected(uint8_t client, bool connected);
+
+    /**
+     * Whether the last +CREG reported home or roaming registration.
+     */
+    bool isRegistered() const;
 
 private:
     HardwareSerial modemSerial;
+    ModemLinkState link;
+    ModemStream stream;     // TinyGSM: plain UART, or CMUX_DLCI_MAIN
+    ModemStream auxStream;  // CMUX_DLCI_AUX
+    Cmux mux;
+    bool cmuxOpen;
+    bool cmuxDisabled;      // refused or failed once: plain UART until reboot
+    bool cmuxCloseSent;     // leftover session close-down tried while probing
+    AtQueue atQueue;
     bool ready;
     unsigned long initStartTime;
     enum InitState {
+        INIT_PROBE,
+        INIT_PROBE_WAIT,
         INIT_POWER_ON,
+        INIT_WAIT_RAIL,
         INIT_WAIT_POWER,
         INIT_AT_HANDSHAKE,
-        INIT_DISABLE_ECHO,
-        INIT_QUERY_SIM,
-        INIT_QUERY_NETWORK,
-        INIT_QUERY_RSSI,
+        INIT_CONFIGURE,
+        INIT_CONFIGURE_WAIT,
+        INIT_SET_BAUD,
+        INIT_SET_BAUD_WAIT,
+        INIT_VERIFY_BAUD,
+        INIT_RESTORE_BAUD,
+        INIT_CMUX,
+        INIT_CMUX_WAIT,
+        INIT_CMUX_OPEN,
         INIT_COMPLETE
     };
     InitState initState;
+    unsigned long lastAtProbe;
+    uint8_t powerOnAttempts;
+    bool resetOnPowerOn;    // the modem is running: reset it before the power key pulse
+
+    // "AT" probe through the queue
+    bool probePending;
+    AtResult probeResult;
+    uint8_t probesLeft;
+    bool warmExpected;
+    bool configFailed;  // a command the modem cannot work without failed (ATE0)
+
+    // UART rate (see MODEM_BAUD_NEGOTIATE)
+    uint32_t baud;              // rate the ESP32 side runs at
+    uint32_t targetBaud;        // rate being negotiated
+    uint32_t errorsAtWindow;    // uartErrors at the start of the error window
+    unsigned long errorWindowStart;
+    static volatile uint32_t uartErrors;
+
+    // Boot URC line buffer (RDY / PB DONE detection during INIT_WAIT_POWER)
+    char bootLine[32];
+    uint8_t bootLineLen;
 
-    bool waitForResponse(const char* expectedResponse, unsigned long timeoutMs);
+    void queueProbe(unsigned long timeoutMs, const char* cmd = "AT");
+    void setBaud(uint32_t rate);
+    void attachMux();
+    void detachMux();
+    uint32_t nextBaud() const;
+    void dropBaud();
+    void checkUartErrors(unsigned long now);
+    static void onUartError(hardwareSerial_error_t error);
+    static void onBaudFallbackDone(AtResult result, void* ctx);
+    void queueConfiguration();
+    static void onProbeDone(AtResult result, void* ctx);
+    static void onEchoDone(AtResult result, void* ctx);
+    static void onCregModeDone(AtResult result, void* ctx);
+    static void onCgerepDone(AtResult result, void* ctx);
+    static void onSimDone(AtResult result, void* ctx);
+    static void onRegDone(AtResult result, void* ctx);
+    static void onRssiDone(AtResult result, void* ctx);
     void powerOn();
     void powerOff();
     void resetPin();
     void flushSerial();
+    bool scanBootUrcs();
 };
 
 #endif // MODEM_MANAGER_H
@@ -0,0 +1,332 @@
+#include "ModemStream.h"
+#include "util/Log.h"
+#include <stdlib.h>
+#include <string.h>
+
+const ModemStream::UrcRoute ModemStream::ROUTES[] = {
+    {"+CMQTTCONNLOST: ", &ModemStream::onMqttConnLost},
+    {"+CMQTTNONET", &ModemStream::onMqttNoNet},
+    {"+CMQTTCONNECT: ", &ModemStream::onMqttConnect},
+    {"+CMQTTDISC: ", &ModemStream::onMqttDisc},
+    {"+CMQTTRXSTART: ", &ModemStream::onMqttRxStart},
+    {"+CMQTTRXPAYLOAD: ", &ModemStream::onMqttRxPayload},
+    {"+CMQTTRXEND: ", &ModemStream::onMqttRxEnd},
+    {"+CREG: ", &ModemStream::onCreg},
+    {"+CGEV: ", &ModemStream::onCgev},
+    {"+NETOPEN: ", &ModemStream::onNetOpen},
+};
+
+// Integer field at p; moves p past it and a following comma. False if p is not a number.
+static bool takeInt(const char*& p, long& value) {
+    char* end;
+    value = strtol(p, &end, 10);
+    if (end == p) {
+        return false;
+    }
+    p = (*end == ',') ? end + 1 : end;
+    return true;
+}
+
+ModemStream::ModemStream(HardwareSerial& serial, ModemLinkState& state)
+    : serial(serial), channel(nullptr), rxLen(0), rxPos(0), lineLen(0), lineOverflow(false), expected(nullptr),
+      expectedLen(0), onLine(nullptr), onLineCtx(nullptr), result(AT_RESULT_PENDING), inPayload(false),
+      state(state) {
+    resetLink();
+}
+
+/**
+ * Refill the RX buffer once it is drained: one driver call for everything the
+ * UART holds, instead of one per byte. A CMUX channel is already a RAM ring.
+ */
+bool ModemStream::fill() {
+    if (rxPos < rxLen) {
+        return true;
+    }
+    int n = channel != nullptr ? channel->available() : serial.available();
+    if (n <= 0) {
+        return false;
+    }
+    if (n > (int)sizeof(rx)) {
+        n = sizeof(rx);
+    }
+    if (channel != nullptr) {
+        rxLen = 0;
+        int c;
+        while (rxLen < n && (c = channel->read()) >= 0) {
+            rx[rxLen++] = (uint8_t)c;
+        }
+    } else {
+        rxLen = (uint16_t)serial.read(rx, (size_t)n);
+    }
+    rxPos = 0;
+    return rxLen > 0;
+}
+
+int ModemStream::available() {
+    return (rxLen - rxPos) + (channel != nullptr ? channel->available() : serial.available());
+}
+
+int ModemStream::read() {
+    if (!fill()) {
+        return -1;
+    }
+    char c = (char)rx[rxPos++];
+    feed(c);
+    return (uint8_t)c;
+}
+
+int ModemStream::peek() {
+    if (!fill()) {
+        return -1;
+    }
+    return rx[rxPos];
+}
+
+void ModemStream::flush() {
+    if (channel != nullptr) {
+        channel->flush();
+    } else {
+        serial.flush();
+    }
+}
+
+size_t ModemStream::write(uint8_t c) {
+    return channel != nullptr ? channel->write(c) : serial.write(c);
+}
+
+size_t ModemStream::write(const uint8_t* buffer, size_t size) {
+    return channel != nullptr ? channel->write(buffer, size) : serial.write(buffer, size);
+}
+
+const ModemLinkState& ModemStream::link() const {
+    return state;
+}
+
+void ModemStream::beginResponse(const char* expectedPrefix, AtLineHandler handler, void* ctx) {
+    // "OK" is matched as a final result code anyway
+    expected = (expectedPrefix != nullptr && strcmp(expectedPrefix, "OK") != 0) ? expectedPrefix : nullptr;
+    expectedLen = expected != nullptr ? strlen(expected) : 0;
+    onLine = handler;
+    onLineCtx = ctx;
+    result = AT_RESULT_PENDING;
+}
+
+AtResult ModemStream::responseResult() const {
+    return result;
+}
+
+const char* ModemStream::finalLine() const {
+    return line;
+}
+
+void ModemStream::endResponse() {
+    expected = nullptr;
+    onLine = nullptr;
+    onLineCtx = nullptr;
+    result = AT_RESULT_PENDING;
+}
+
+void ModemStream::setMqttConnected(uint8_t client, bool connected) {
+    if (client < MODEM_MQTT_CLIENTS) {
+        state.mqttConnected[client] = connected;
+    }
+}
+
+void ModemStream::resetLink() {
+    state.registration = -1;
+    state.pdpActive = -1;
+    for (uint8_t i = 0; i < MODEM_MQTT_CLIENTS; i++) {
+        state.mqttConnected[i] = false;
+    }
+    state.mqttConnLost = 0;
+    state.mqttRxCount = 0;
+    state.netOpenCount = 0;
+    state.netOpenError = -1;
+    state.lastUrcAt = 0;
+    lineLen = 0;
+    lineOverflow = false;
+    inPayload = false;
+}
+
+void ModemStream::discardInput() {
+    rxLen = 0;
+    rxPos = 0;
+    if (channel != nullptr) {
+        while (channel->read() >= 0) {
+        }
+    } else {
+        while (serial.available() > 0) {
+            serial.read(rx, sizeof(rx));
+        }
+    }
+    lineLen = 0;
+    lineOverflow = false;
+}
+
+void ModemStream::setChannel(Stream* source) {
+    channel = source;
+    rxLen = 0;
+    rxPos = 0;
+    lineLen = 0;
+    lineOverflow = false;
+    inPayload = false;
+}
+
+void ModemStream::feed(char c) {
+    if (c == '\r' || c == '\n') {
+        if (lineLen > 0) {
+            line[lineLen] = '\0';
+            if (!lineOverflow) {
+                dispatch(line);
+            }
+            if (result == AT_RESULT_PENDING) {
+                matchResponse(line, lineLen);
+            }
+        }
+        lineLen = 0;
+        lineOverflow = false;
+        return;
+    }
+    if (lineLen < sizeof(line) - 1) {
+        line[lineLen++] = c;
+    } else {
+        lineOverflow = true;
+    }
+}
+
+void ModemStream::matchResponse(const char* text, size_t len) {
+    if (strcmp(text, "OK") == 0) {
+        result = AT_RESULT_OK;
+    } else if (strcmp(text, "ERROR") == 0 || strncmp(text, "+CME ERROR", 10) == 0 ||
+               strncmp(text, "+CMS ERROR", 10) == 0) {
+        result = AT_RESULT_ERROR;
+    } else {
+        if (onLine != nullptr) {
+            onLine(text, len, onLineCtx);
+        }
+        if (expected != nullptr && strncmp(text, expected, expectedLen) == 0) {
+            result = AT_RESULT_OK;
+        }
+    }
+}
+
+void ModemStream::dispatch(const char* text) {
+    if (text[0] != '+') {
+        return;
+    }
+    // A command payload may contain anything, including text that looks like a URC
+    if (inPayload && strncmp(text, "+CMQTTRXEND: ", 13) != 0) {
+        return;
+    }
+    for (size_t i = 0; i < sizeof(ROUTES) / sizeof(ROUTES[0]); i++) {
+        size_t n = strlen(ROUTES[i].prefix);
+        if (strncmp(text, ROUTES[i].prefix, n) == 0) {
+            state.lastUrcAt = millis();
+            (this->*ROUTES[i].handler)(text + n);
+            return;
+        }
+    }
+}
+
+// +CMQTTCONNLOST: <client>,<cause>
+void ModemStream::onMqttConnLost(const char* args) {
+    long client, cause = -1;
+    if (!takeInt(args, client)) {
+        return;
+    }
+    takeInt(args, cause);
+    setMqttConnected((uint8_t)client, false);
+    state.mqttConnLost++;
+    LOG(MODEM_URC_MQTT_LOST, (int)client, (int)cause);
+}
+
+// +CMQTTNONET: the network closed under every client
+void ModemStream::onMqttNoNet(const char* args) {
+    (void)args;
+    for (uint8_t i = 0; i < MODEM_MQTT_CLIENTS; i++) {
+        state.mqttConnected[i] = false;
+    }
+    state.mqttConnLost++;
+    LOG(MODEM_URC_MQTT_NONET);
+}
+
+// +CMQTTCONNECT: <client>,<err> (connect result), or the AT+CMQTTCONNECT? answer:
+// <client>,"<server>",... when connected and <client> alone when not
+void ModemStream::onMqttConnect(const char* args) {
+    long client, err;
+    if (!takeInt(args, client)) {
+        return;
+    }
+    if (*args == '"') {
+        setMqttConnected((uint8_t)client, true);
+    } else if (takeInt(args, err)) {
+        setMqttConnected((uint8_t)client, err == 0);
+    } else {
+        setMqttConnected((uint8_t)client, false);
+    }
+}
+
+// +CMQTTDISC: <client>,<err>
+void ModemStream::onMqttDisc(const char* args) {
+    long client, err;
+    if (takeInt(args, client) && takeInt(args, err) && err == 0) {
+        setMqttConnected((uint8_t)client, false);
+    }
+}
+
+// +CMQTTRXSTART: <client>,<topic_len>,<payload_len>
+void ModemStream::onMqttRxStart(const char* args) {
+    (void)args;
+    state.mqttRxCount++;
+}
+
+// +CMQTTRXPAYLOAD: <client>,<len>, followed by the payload bytes
+void ModemStream::onMqttRxPayload(const char* args) {
+    (void)args;
+    inPayload = true;
+}
+
+// +CMQTTRXEND: <client>
+void ModemStream::onMqttRxEnd(const char* args) {
+    (void)args;
+    inPayload = false;
+}
+
+// URC: +CREG: <stat>[,<lac>,<ci>]; AT+CREG? answer: +CREG: <n>,<stat>[,...]
+void ModemStream::onCreg(const char* args) {
+    long first, second;
+    if (!takeInt(args, first)) {
+        return;
+    }
+    long stat = takeInt(args, second) ? second : first;
+    if (stat != state.registration) {
+        state.registration = (int8_t)stat;
+        LOG(MODEM_URC_REGISTRATION, (int)stat);
+    }
+}
+
+// +CGEV: NW DETACH / ME PDN DEACT <cid> / ME PDN ACT <cid> / ...
+void ModemStream::onCgev(const char* args) {
+    int8_t active;
+    if (strstr(args, "DEACT") != nullptr || strstr(args, "DETACH") != nullptr) {
+        active = 0;
+    } else if (strstr(args, "ACT") != nullptr) {
+        active = 1;
+    } else {
+        return;
+    }
+    if (active != state.pdpActive) {
+        state.pdpActive = active;
+        LOG(MODEM_URC_PDP, args);
+    }
+}
+
+// +NETOPEN: <err>, the delayed result of AT+NETOPEN (we never send AT+NETOPEN?)
+void ModemStream::onNetOpen(const char* args) {
+    long err;
+    if (!takeInt(args, err)) {
+        return;
+    }
+    state.netOpenError = (int8_t)err;
+    state.netOpenCount++;
+}
@@ -0,0 +1,158 @@
+#ifndef MODEM_STREAM_H
+#define MODEM_STREAM_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <HardwareSerial.h>
+#include "config/config.h"
+
+/**
+ * Connection state as last reported by the modem's unsolicited result codes.
+ * Read for free instead of querying the modem over the UART.
+ */
+struct ModemLinkState {
+    int8_t registration;                        // +CREG <stat> (1 home, 5 roaming), -1 until reported
+    int8_t pdpActive;                           // from +CGEV: 1 active, 0 deactivated, -1 unknown
+    bool mqttConnected[MODEM_MQTT_CLIENTS];     // per CMQTT client index
+    uint32_t mqttConnLost;                      // +CMQTTCONNLOST / +CMQTTNONET seen
+    uint32_t mqttRxCount;                       // +CMQTTRXSTART seen
+    uint32_t netOpenCount;                      // +NETOPEN results seen (AT+NETOPEN completes with it)
+    int8_t netOpenError;                        // last +NETOPEN <err>, 0 = data session open
+    unsigned long lastUrcAt;                    // millis() of the last routed line
+};
+
+// Outcome of an AT command (see ModemStream::beginResponse)
+enum AtResult : int8_t {
+    AT_RESULT_PENDING = -1,
+    AT_RESULT_OK = 0,       // OK, or a line starting with the expected prefix
+    AT_RESULT_ERROR,        // ERROR, +CME ERROR, +CMS ERROR
+    AT_RESULT_TIMEOUT
+};
+
+/**
+ * Intermediate response line, as a view into the line buffer (not terminated
+ * by CR/LF, but NUL-terminated). Only valid during the call.
+ */
+typedef void (*AtLineHandler)(const char* line, size_t len, void* ctx);
+
+/**
+ * Stream over the modem UART, or over one CMUX channel once the multiplexer is
+ * up, that routes URCs and matches AT responses.
+ * Bytes are pulled from the UART driver in bulk into a fixed RX buffer. Every
+ * byte read (by TinyGSM or ModemManager) is also fed to a line splitter, which
+ * handles each line once, as it completes:
+ * - lines that match the URC table (+CMQTTCONNLOST, +CMQTTRXSTART, +CREG,
+ *   +CGEV, ...) update ModemLinkState;
+ * - while a response is pending (beginResponse()), final result codes complete
+ *   it and other lines go to its line handler.
+ * Nothing is consumed or altered, so the reader still sees every byte.
+ * No heap allocation. Used from the network task only.
+ */
+class ModemStream : public Stream {
+public:
+    /**
+     * state is shared by every stream on the same modem: URCs may arrive on any
+     * CMUX channel.
+     */
+    ModemStream(HardwareSerial& serial, ModemLinkState& state);
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override;
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    const ModemLinkState& link() const;
+
+    /**
+     * Start matching the response to a command about to be sent. It completes on
+     * OK, ERROR, +CME ERROR or +CMS ERROR, or (if expected is set) on the first
+     * line starting with expected. onLine (optional) gets every line that is not
+     * a result code, including the expected one.
+     */
+    void beginResponse(const char* expected, AtLineHandler onLine = nullptr, void* ctx = nullptr);
+
+    /**
+     * AT_RESULT_PENDING until the final line of the response has been read.
+     */
+    AtResult responseResult() const;
+
+    /**
+     * The line that completed the response; valid until the next read().
+     */
+    const char* finalLine() const;
+
+    /**
+     * Stop matching (after completion or timeout).
+     */
+    void endResponse();
+
+    /**
+     * Record an MQTT client state learned from a command response (the response
+     * line may not be complete yet when the caller has parsed it).
+     */
+    void setMqttConnected(uint8_t client, bool connected);
+
+    /**
+     * Forget everything reported so far (modem reset or power cycle).
+     */
+    void resetLink();
+
+    /**
+     * Drop buffered and pending UART bytes and any partial line without
+     * parsing them (after a baud rate change they are garbage).
+     */
+    void discardInput();
+
+    /**
+     * Read and write through a CMUX channel instead of the UART (nullptr: back
+     * to the UART). Buffered bytes of the old source are dropped.
+     */
+    void setChannel(Stream* channel);
+
+private:
+    typedef void (ModemStream::*UrcHandler)(const char* args);
+    struct UrcRoute {
+        const char* prefix;
+        UrcHandler handler;
+    };
+    static const UrcRoute ROUTES[];
+
+    bool fill();
+    void feed(char c);
+    void dispatch(const char* line);
+    void matchResponse(const char* line, size_t len);
+
+    void onMqttConnLost(const char* args);
+    void onMqttNoNet(const char* args);
+    void onMqttConnect(const char* args);
+    void onMqttDisc(const char* args);
+    void onMqttRxStart(const char* args);
+    void onMqttRxPayload(const char* args);
+    void onMqttRxEnd(const char* args);
+    void onCreg(const char* args);
+    void onCgev(const char* args);
+    void onNetOpen(const char* args);
+
+    HardwareSerial& serial;
+    Stream* channel;    // CMUX channel, nullptr for the UART itself
+    uint8_t rx[MODEM_RX_BUFFER];
+    uint16_t rxLen;     // bytes in rx
+    uint16_t rxPos;     // next byte to read
+    char line[MODEM_LINE_MAX];
+    uint8_t lineLen;
+    bool lineOverflow;  // rest of an over-long line is dropped (URCs) or truncated (responses)
+
+    // Pending AT response
+    const char* expected;
+    size_t expectedLen;
+    AtLineHandler onLine;
+    void* onLineCtx;
+    AtResult result;
+    bool inPayload;     // between +CMQTTRXPAYLOAD and +CMQTTRXEND: broker data, not URCs
+    ModemLinkState& state;
+};
+
+#endif // MODEM_STREAM_H
@@ -2,8 +2,13 @@
 #include "utilities.h"
 #include "MqttManager.h"
 #include "ppp/PppManager.h"
+#include "modem/ModemManager.h"
 #include "protocol/Protocol.h"
+#include "util/BootReport.h"
+#include "util/Log.h"
 #include <TinyGsm.h>  // For TinyGsm type
+#include <stdlib.h>
+#include <string.h>
 // TinyGSM is included via PppManager.h
 
 MqttManager* MqttManager::instance = nullptr;
@@ -11,8 +16,11 @@ MqttManager* MqttManager::instance = nullptr;
 MqttManager::MqttManager()
     : backoff(BACKOFF_BASE_MS, BACKOFF_MAX_MS),
       connected(false), mqttFailStreak(0), lastConnectAttempt(0),
-      lastStatusPublish(0), commandCallback(nullptr),
-      pppManager(nullptr), modem(nullptr),
+      commandRing(nullptr), rxPool(nullptr), commandNotify(nullptr),
+      droppedCommands(0), oversizeCommands(0), errorCounter(nullptr),
+      lastRssiSampleAt(0), rssi(0), deliveryHandler(nullptr),
+      sslEnabled(false),
+      pppManager(nullptr), modemManager(nullptr), modem(nullptr),
       customHost(nullptr), customPort(0), customUsername(nullptr), customPassword(nullptr),
       useCustomSettings(false), mqttClientId(0) {
     instance = this;
@@ -23,43 +31,41 @@ void MqttManager::setPppManager(PppManager* pppManager) {
 
     // Get TinyGsm modem from PppManager (for modem's built-in MQTT API)
     if (pppManager != nullptr) {
+        modemManager = pppManager->getModemManager();
         modem = pppManager->getModem();
         if (modem != nullptr) {
-            Serial.println("[MQTT] Using modem's built-in MQTT client (supports TLS/SSL)");
+            LOG(MQTT_USING_MODEM_CLIENT);
         } else {
-            Serial.println("[MQTT] WARNING: Modem not available");
+            LOG(MQTT_MODEM_MISSING_WARN);
         }
     }
 }
 
 bool MqttManager::initializeModemMqtt(bool enableSSL, bool enableSNI, const char* rootCA) {
     if (modem == nullptr) {
-        Serial.println("[MQTT] ERROR: Modem not available");
+        LOG(MQTT_MODEM_MISSING);
         return false;
     }
 
-    Serial.println("[MQTT] Initializing modem MQTT client...");
-    Serial.print("[MQTT] SSL: ");
-    Serial.println(enableSSL ? "enabled" : "disabled");
-    Serial.print("[MQTT] SNI: ");
-    Serial.println(enableSNI ? "enabled" : "disabled");
+    LOG(MQTT_INIT, enableSSL ? "enabled" : "disabled", enableSNI ? "enabled" : "disabled");
 
     // Initialize modem MQTT (like POC: modem.mqtt_begin(enableSSL, enableSNI))
     modem->mqtt_begin(enableSSL, enableSNI);
+    sslEnabled = enableSSL;
 
     // Set root CA certificate if provided
     if (rootCA != nullptr && strlen(rootCA) > 0) {
-        Serial.println("[MQTT] Setting root CA certificate...");
+        LOG(MQTT_SET_ROOT_CA);
         modem->mqtt_set_certificate(rootCA);
     }
 
-    Serial.println("[MQTT] Modem MQTT initialized");
+    LOG(MQTT_INITIALIZED);
     return true;
 }
 
 void MqttManager::begin() {
     if (modem == nullptr) {
-        Serial.println("[MQTT] ERROR: Modem not initialized. Call setPppManager() first!");
+        LOG(MQTT_MODEM_NOT_SET);
         return;
     }
     useCustomSettings = false;
@@ -67,7 +73,7 @@ void MqttManager::begin() {
 
 void MqttManager::begin(const char* host, uint16_t port, const char* username, const char* password) {
     if (modem == nullptr) {
-        Serial.println("[MQTT] ERROR: Modem not initialized. Call setPppManager() first!");
+        LOG(MQTT_MODEM_NOT_SET);
         return;
     }
 
@@ -82,7 +88,7 @@ bool MqttManager::connect() {
     unsigned long now = millis();
 
     // If already connected, check connection health
-    if (connected && modem != nullptr && modem->mqtt_connected()) {
+    if (connected && modem != nullptr && linkUp()) {
         return true;
     }
 
@@ -95,7 +101,7 @@ bool MqttManager::connect() {
     lastConnectAttempt = now;
 
     if (modem == nullptr) {
-        Serial.println("[MQTT] ERROR: Modem not available");
+        LOG(MQTT_MODEM_MISSING);
         incrementFailStreak();
         backoff.increment();
         return false;
@@ -106,30 +112,33 @@ bool MqttManager::connect() {
     const char* username = useCustomSettings ? customUsername : MQTT_USERNAME;
     const char* password = useCustomSettings ? customPassword : MQTT_PASSWORD;
 
-    Serial.print("[MQTT] Connecting to broker ");
-    Serial.print(host);
-    Serial.print(":");
-    Serial.print(port);
-    Serial.println("...");
-
-    String clientId = String("pgr_device_") + String(DEVICE_ID) + String("_") + String(random(0xffff), HEX);
-
-    // Use modem's built-in MQTT client (handles DNS and TLS internally)
-    // Like POC: modem.mqtt_connect(mqtt_client_id, broker, broker_port, client_id, username, password)
-    bool success = modem->mqtt_connect(mqttClientId, host, port, clientId.c_str(), username, password);
-
-    if (success && modem->mqtt_connected()) {
-        Serial.println("[MQTT] Connected to broker");
-
-        // Set callback for incoming messages
-        modem->mqtt_set_callback(staticMqttCallback);
-
-        // Subscribe to command topic
-        if (modem->mqtt_subscribe(mqttClientId, MQTT_CMD_TOPIC)) {
-            Serial.print("[MQTT] Subscribed to ");
-            Serial.println(MQTT_CMD_TOPIC);
+    LOG(MQTT_CONNECTING, host, port);
+
+    // Queued commands can arrive as soon as CONNECT completes
+    modem->mqtt_set_callback(staticMqttCallback);
+
+    // Modem's built-in MQTT client (handles DNS and TLS internally)
+    bool success = openSession(host, port, MQTT_CLIENT_ID, username, password);
+
+    if (success) {
+        LOG(MQTT_CONNECTED);
+        BootReport::mark(BOOT_PHASE_MQTT_CONNECTED);
+
+        // The persistent session keeps the subscriptions; renewing them is harmless
+        // and covers a session the broker has dropped
+        if (subscribe(MQTT_CMD_TOPIC, 1)) {
+            LOG(MQTT_SUBSCRIBED, MQTT_CMD_TOPIC);
+#if MQTT_BINARY_ENABLED
+            // Backend picks the encoding per device by topic; both stay subscribed
+            if (subscribe(MQTT_CMD_BIN_TOPIC, 1)) {
+                LOG(MQTT_SUBSCRIBED, MQTT_CMD_BIN_TOPIC);
+            } else {
+                LOG(MQTT_SUBSCRIBE_BIN_FAILED);
+            }
+#endif
+            BootReport::mark(BOOT_PHASE_MQTT_SUBSCRIBED);
         } else {
-            Serial.println("[MQTT] Failed to subscribe to command topic");
+            LOG(MQTT_SUBSCRIBE_FAILED);
             modem->mqtt_disconnect();
             incrementFailStreak();
             backoff.increment();
@@ -139,26 +148,122 @@ bool MqttManager::connect() {
         connected = true;
         resetMqttFailStreak();
         backoff.reset();
+
+        // Birth: replaces the retained status (and any Last Will the broker sent).
+        // On failure the next publishStatus() retries the full document.
+        lastRssiSampleAt = 0;
+        statusSchedule.requestFull();
+        sendStatus(millis());
         return true;
     } else {
-        Serial.println("[MQTT] Connection failed");
+        LOG(MQTT_CONNECT_FAILED);
         connected = false;
         incrementFailStreak();
         backoff.increment();
 
-        Serial.print("[MQTT] Next retry in ");
-        Serial.print(backoff.getNextDelay());
-        Serial.println("ms");
+        LOG(MQTT_NEXT_RETRY, backoff.getNextDelay());
 
         return false;
     }
 }
 
+/**
+ * Open the modem MQTT session step by step. mqtt_connect() in the TinyGSM fork
+ * goes straight from acquiring the client to CONNECT, leaving no point to
+ * register the Last Will, so the CMQTT commands are sent here directly.
+ */
+bool MqttManager::openSession(const char* host, uint16_t port, const char* clientId,
+                              const char* username, const char* password) {
+    // Release whatever an earlier session left in this slot (errors if it is free)
+    modem->sendAT(GF("+CMQTTDISC="), mqttClientId, ',', 60);
+    if (modem->waitResponse(AT_CMD_TIMEOUT_MS) == 1) {
+        modem->waitResponse(AT_CMD_TIMEOUT_MS, GF("+CMQTTDISC: "));
+    }
+    modem->sendAT(GF("+CMQTTREL="), mqttClientId);
+    modem->waitResponse(AT_CMD_TIMEOUT_MS);
+
+    modem->sendAT(GF("+CMQTTACCQ="), mqttClientId, GF(",\""), clientId, GF("\","), sslEnabled ? 1 : 0);
+    if (modem->waitResponse(AT_CMD_TIMEOUT_MS) != 1) {
+        LOG(MQTT_SESSION_STEP_FAILED, "ACCQ");
+        return false;
+    }
+    if (sslEnabled) {
+        modem->sendAT(GF("+CMQTTSSLCFG="), mqttClientId, ',', 0);
+        if (modem->waitResponse(AT_CMD_TIMEOUT_MS) != 1) {
+            LOG(MQTT_SESSION_STEP_FAILED, "SSLCFG");
+            return false;
+        }
+    }
+
+    // Last Will. The A76xx has no retain flag for it: the backend sees it live,
+    // a late subscriber gets the retained birth instead (see docs/mqtt-protocol.md).
+    char will[128];
+    size_t willLen = Protocol::createStatus(DEVICE_ID, false, millis(), 0, nullptr, will, sizeof(will));
+    modem->sendAT(GF("+CMQTTWILLTOPIC="), mqttClientId, ',', strlen(MQTT_STATUS_TOPIC));
+    if (!writePrompt(MQTT_STATUS_TOPIC, strlen(MQTT_STATUS_TOPIC))) {
+        LOG(MQTT_SESSION_STEP_FAILED, "WILLTOPIC");
+        return false;
+    }
+    modem->sendAT(GF("+CMQTTWILLMSG="), mqttClientId, ',', willLen, ',', 1);
+    if (!writePrompt(will, willLen)) {
+        LOG(MQTT_SESSION_STEP_FAILED, "WILLMSG");
+        return false;
+    }
+
+    // clean_session 0: resume the broker-side session (subscriptions, queued QoS 1 commands)
+    modem->sendAT(GF("+CMQTTCONNECT="), mqttClientId, GF(",\"tcp://"), host, ':', port, GF("\","),
+                  MQTT_KEEPALIVE_S, ',', 0, GF(",\""), username, GF("\",\""), password, '"');
+    if (modem->waitResponse(AT_CMD_TIMEOUT_MS) != 1 ||
+        modem->waitResponse(MQTT_CONNECT_TIMEOUT_MS, GF("+CMQTTCONNECT: ")) != 1) {
+        LOG(MQTT_SESSION_STEP_FAILED, "CONNECT");
+        return false;
+    }
+    // +CMQTTCONNECT: <client>,<err>
+    modem->stream.parseInt();
+    bool ok = modem->stream.parseInt() == 0;
+    if (modemManager != nullptr) {
+        modemManager->setMqttConnected(mqttClientId, ok);
+    }
+    return ok;
+}
+
+bool MqttManager::adoptSession(uint8_t clientIndex) {
+    if (modem == nullptr) {
+        return false;
+    }
+    mqttClientId = clientIndex;
+    // Nothing cached yet for a session the previous boot opened: ask once
+    bool up = modem->mqtt_connected();
+    if (modemManager != nullptr) {
+        modemManager->setMqttConnected(mqttClientId, up);
+    }
+    if (!up) {
+        LOG(MQTT_WARM_SESSION_GONE);
+        return false;
+    }
+
+    LOG(MQTT_WARM_ADOPTED, mqttClientId);
+    modem->mqtt_set_callback(staticMqttCallback);
+    BootReport::mark(BOOT_PHASE_MQTT_CONNECTED);
+    BootReport::mark(BOOT_PHASE_MQTT_SUBSCRIBED);
+    connected = true;
+    resetMqttFailStreak();
+    backoff.reset();
+    return true;
+}
+
+uint8_t MqttManager::getClientIndex() const {
+    return mqttClientId;
+}
+
 void MqttManager::disconnect() {
     if (connected && modem != nullptr) {
-        Serial.println("[MQTT] Disconnecting...");
+        LOG(MQTT_DISCONNECTING);
         modem->mqtt_disconnect();
         connected = false;
+        if (modemManager != nullptr) {
+            modemManager->setMqttConnected(mqttClientId, false);
+        }
     }
 }
 
@@ -169,82 +274,275 @@ bool MqttManager::isConnected() const {
     if (!connected) {
         return false;
     }
-    if (modem != nullptr) {
-        return modem->mqtt_connected();
-    }
-    return connected;
+    return linkUp();
+}
+
+/**
+ * Connection state of our CMQTT client as last reported by the modem.
+ */
+bool MqttManager::linkUp() const {
+    return modemManager == nullptr || modemManager->isMqttConnected(mqttClientId);
+}
+
+/**
+ * No queued AT command is waiting for its response, so TinyGSM may use the UART.
+ */
+bool MqttManager::uartFree() const {
+    return modemManager == nullptr || !modemManager->isAtBusy();
 }
 
 bool MqttManager::publish(const char* topic, const char* payload, bool retained) {
     if (!isConnected() || modem == nullptr) {
-        Serial.println("[MQTT] Cannot publish: not connected");
+        LOG(MQTT_PUBLISH_NOT_CONNECTED);
         return false;
     }
 
-    // Use modem's MQTT publish (like POC: modem.mqtt_publish(mqtt_client_id, topic, payload))
-    bool result = modem->mqtt_publish(mqttClientId, topic, payload);
+    // mqtt_publish() has no retain flag
+    bool result = retained
+        ? publishRaw(topic, (const uint8_t*)payload, strlen(payload), true)
+        : modem->mqtt_publish(mqttClientId, topic, payload);
     if (!result) {
-        Serial.print("[MQTT] Failed to publish to ");
-        Serial.println(topic);
+        LOG(MQTT_PUBLISH_FAILED, topic);
     }
     return result;
 }
 
+bool MqttManager::publishBinary(const char* topic, const uint8_t* payload, size_t len) {
+    if (!isConnected() || modem == nullptr) {
+        LOG(MQTT_PUBLISH_NOT_CONNECTED);
+        return false;
+    }
+
+    // mqtt_publish() takes a C string, so raw frames (may contain 0x00) go through
+    // the CMQTT topic/payload prompts directly
+    bool ok = publishRaw(topic, payload, len, false);
+    if (!ok) {
+        LOG(MQTT_PUBLISH_FAILED, topic);
+    }
+    return ok;
+}
+
+/**
+ * Subscribe through the CMQTT topic prompt with an explicit QoS.
+ */
+bool MqttManager::subscribe(const char* topic, uint8_t qos) {
+    modem->sendAT(GF("+CMQTTSUBTOPIC="), mqttClientId, ',', strlen(topic), ',', qos);
+    if (!writePrompt(topic, strlen(topic))) {
+        return false;
+    }
+    modem->sendAT(GF("+CMQTTSUB="), mqttClientId);
+    if (modem->waitResponse(AT_CMD_TIMEOUT_MS) != 1 ||
+        modem->waitResponse(AT_CMD_TIMEOUT_MS, GF("+CMQTTSUB: ")) != 1) {
+        return false;
+    }
+    // +CMQTTSUB: <client>,<err>
+    modem->stream.parseInt();
+    return modem->stream.parseInt() == 0;
+}
+
+/**
+ * Publish through the CMQTT topic/payload prompts. For QoS 1 the modem reports
+ * +CMQTTPUB only after the broker's PUBACK, so success means delivered.
+ */
+bool MqttManager::publishRaw(const char* topic, const uint8_t* payload, size_t len, bool retained, uint8_t qos) {
+    modem->sendAT(GF("+CMQTTTOPIC="), mqttClientId, ',', strlen(topic));
+    if (!writePrompt(topic, strlen(topic))) {
+        return false;
+    }
+    modem->sendAT(GF("+CMQTTPAYLOAD="), mqttClientId, ',', (uint32_t)len);
+    if (!writePrompt(payload, len)) {
+        return false;
+    }
+    modem->sendAT(GF("+CMQTTPUB="), mqttClientId, ',', qos, ',', 60, ',', retained ? 1 : 0);
+    if (modem->waitResponse(AT_CMD_TIMEOUT_MS) != 1 ||
+        modem->waitResponse(AT_CMD_TIMEOUT_MS, GF("+CMQTTPUB: ")) != 1) {
+        return false;
+    }
+    // +CMQTTPUB: <client>,<err>
+    modem->stream.parseInt();
+    return modem->stream.parseInt() == 0;
+}
+
+/**
+ * Answer a CMQTT ">" prompt with data (topic, payload or will).
+ */
+bool MqttManager::writePrompt(const void* data, size_t len) {
+    if (modem->waitResponse(AT_CMD_TIMEOUT_MS, GF(">")) != 1) {
+        return false;
+    }
+    modem->stream.write((const uint8_t*)data, len);
+    return modem->waitResponse(AT_CMD_TIMEOUT_MS) == 1;
+}
+
+bool MqttManager::enqueue(OutboxTopic topic, const void* payload, size_t len, OutboxPriority priority,
+                          uint8_t qos, uint8_t flags, uint32_t tag) {
+    return outbox.push(topic, payload, len, priority, qos, flags, tag);
+}
+
+void MqttManager::flushOutbox() {
+    if (!isConnected() || modem == nullptr || !uartFree()) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < OUTBOX_FLUSH_BATCH; i++) {
+        OutboxMessage* msg = outbox.peek();
+        if (msg == nullptr) {
+            return;
+        }
+        const char* topic = Outbox::topicName(msg->topic);
+        OutboxTopic msgTopic = (OutboxTopic)msg->topic;
+        uint32_t tag = msg->tag;
+
+        if (publishRaw(topic, msg->payload, msg->len, false, msg->qos)) {
+            LOG(OUTBOX_PUBLISHED, topic, (unsigned long)(millis() - msg->enqueuedAt));
+            outbox.pop();
+            if (deliveryHandler != nullptr) {
+                deliveryHandler(msgTopic, tag, true);
+            }
+            continue;
+        }
+
+        msg->attempts++;
+        LOG(OUTBOX_PUBLISH_FAILED, topic, msg->attempts);
+        if (msg->attempts >= OUTBOX_MAX_ATTEMPTS) {
+            // Do not let one message the modem keeps rejecting block the queue
+            LOG(OUTBOX_GAVE_UP, topic, msg->attempts);
+            outbox.pop();
+            if (deliveryHandler != nullptr) {
+                deliveryHandler(msgTopic, tag, false);
+            }
+        }
+        // As for status: a failed publish means the session is gone, reconnect
+        connected = false;
+        return;
+    }
+}
+
+void MqttManager::setDeliveryHandler(void (*handler)(OutboxTopic topic, uint32_t tag, bool delivered)) {
+    deliveryHandler = handler;
+}
+
+size_t MqttManager::getOutboxDepth() const {
+    return outbox.depth();
+}
+
+uint32_t MqttManager::getOutboxAgeMs() const {
+    return outbox.oldestAgeMs(millis());
+}
+
 void MqttManager::publishAck(const char* requestId, bool ok, const char* errorCode) {
     if (!isConnected()) {
-        Serial.println("[MQTT] Cannot publish ACK: not connected");
+        LOG(MQTT_ACK_NOT_CONNECTED);
         return;
     }
 
     // ACK will be created by caller using Protocol::createAck
     // This method is a placeholder for future use if needed
-    Serial.print("[MQTT] ACK prepared for requestId: ");
-    Serial.println(requestId);
+    LOG(MQTT_ACK_PREPARED, requestId);
 }
 
 void MqttManager::publishStatus() {
-    if (!isConnected()) {
+    if (!isConnected() || modem == nullptr || !uartFree()) {
         return;
     }
 
-    unsigned long now = millis();
-    if (now - lastStatusPublish < STATUS_INTERVAL_MS) {
-        return;
+    if (!sendStatus(millis())) {
+        LOG(MQTT_STATUS_FAILED);
+        // Treat failed publish as connection lost so state machine triggers reconnect.
+        // Modem may still report mqtt_connected() true until keepalive fails.
+        connected = false;
     }
+}
 
-    lastStatusPublish = now;
+/**
+ * Publish the status message statusSchedule says is due, if any. Only the
+ * planned fields are included: the backend keeps the others from earlier
+ * messages. The full document is retained (birth). Returns false if the
+ * publish failed.
+ */
+bool MqttManager::sendStatus(unsigned long now) {
+    sampleRssi(now);
+    uint32_t errors = droppedCommands + oversizeCommands + (errorCounter != nullptr ? errorCounter() : 0);
+    size_t outboxDepth = outbox.depth();
+    StatusPlan plan;
+    if (!statusSchedule.due(now, rssi, errors, outboxDepth, plan)) {
+        return true;
+    }
 
-    // Create status JSON using Protocol
     char statusJson[256];
-    Protocol::createStatus(DEVICE_ID, true, now, 0, FW_VERSION, statusJson, sizeof(statusJson));
+    Protocol::createStatus(DEVICE_ID, true, now,
+                           plan.withRssi ? rssi : 0,
+                           plan.full ? FW_VERSION : nullptr,
+                           statusJson, sizeof(statusJson),
+                           plan.withErrors ? (long)errors : -1,
+                           plan.withOutbox ? (long)outboxDepth : -1,
+                           plan.withOutbox ? (long)outbox.oldestAgeMs(now) : -1);
+
+    if (!publish(MQTT_STATUS_TOPIC, statusJson, plan.full)) {
+        return false;
+    }
+    LOG(MQTT_STATUS_PUBLISHED, statusJson);
+    statusSchedule.sent(plan, now, rssi, errors, outboxDepth);
+    return true;
+}
 
-    // Publish status message
-    if (publish(MQTT_STATUS_TOPIC, statusJson, false)) {
-        Serial.print("[MQTT] Status published: ");
-        Serial.println(statusJson);
-    } else {
-        Serial.println("[MQTT] Failed to publish status");
-        // Treat failed publish as connection lost so state machine triggers reconnect.
-        // Modem may still report mqtt_connected() true until keepalive fails.
-        connected = false;
+void MqttManager::sampleRssi(unsigned long now) {
+    if (lastRssiSampleAt != 0 && now - lastRssiSampleAt < STATUS_RSSI_SAMPLE_MS) {
+        return;
+    }
+    lastRssiSampleAt = now;
+    // Housekeeping: queued behind everything else, the value lands for the next status
+    if (modemManager != nullptr && !modemManager->isAtQueueHeld()) {
+        modemManager->getAtQueue().enqueue("AT+CSQ", AT_PRIORITY_LOW, AT_CMD_TIMEOUT_MS,
+                                           nullptr, this, onCsqLine);
+        return;
+    }
+    // Queue held for our session on the shared UART: ask through TinyGSM, like
+    // every other call made during the session
+    int16_t csq = modem->getSignalQuality();
+    rssi = (csq >= 0 && csq <= 31) ? -113 + 2 * csq : 0;
+}
+
+// +CSQ: <rssi>,<ber>
+void MqttManager::onCsqLine(const char* line, size_t len, void* ctx) {
+    (void)len;
+    if (strncmp(line, "+CSQ: ", 6) != 0) {
+        return;
     }
+    int csq = atoi(line + 6);
+    // CSQ 0..31 maps to -113..-51 dBm; 99 means unknown
+    static_cast<MqttManager*>(ctx)->rssi = (csq >= 0 && csq <= 31) ? -113 + 2 * csq : 0;
+}
+
+void MqttManager::setCommandQueue(CommandRing* ring, RxPool* pool, void (*notify)()) {
+    commandRing = ring;
+    rxPool = pool;
+    commandNotify = notify;
+}
+
+uint32_t MqttManager::getDroppedCommandCount() const {
+    return droppedCommands;
+}
+
+uint32_t MqttManager::getOversizeCommandCount() const {
+    return oversizeCommands;
 }
 
-void MqttManager::setCommandCallback(void (*callback)(const char* topic, const char* payload)) {
-    commandCallback = callback;
+void MqttManager::setErrorCounter(uint32_t (*count)()) {
+    errorCounter = count;
 }
 
 void MqttManager::loop() {
-    if (!connected || modem == nullptr) {
+    if (!connected || modem == nullptr || !uartFree()) {
         return;
     }
 
     // Process MQTT messages (like POC: modem.mqtt_handle())
     modem->mqtt_handle();
 
-    // Check connection status
-    if (!modem->mqtt_connected()) {
-        Serial.println("[MQTT] Connection lost");
+    // Connection loss arrives as a URC, which mqtt_handle() has just read
+    if (!linkUp()) {
+        LOG(MQTT_CONNECTION_LOST);
         connected = false;
         incrementFailStreak();
     }
@@ -256,18 +554,48 @@ void MqttManager::staticMqttCallback(const char* topic, const uint8_t* payload,
         return;
     }
 
-    // Create null-terminated string from payload
-    char message[len + 1];
-    memcpy(message, payload, len);
-    message[len] = '\0';
+#if MQTT_BINARY_ENABLED
+    bool binary = strcmp(topic, MQTT_CMD_BIN_TOPIC) == 0;
+#else
+    bool binary = false;
+#endif
+
+    LOG(MQTT_RECEIVED, topic, len);
+
+    if (instance->commandRing == nullptr || instance->rxPool == nullptr) {
+        LOG(MQTT_NO_COMMAND_QUEUE);
+        return;
+    }
+
+    // Copy into a preallocated slot and hand it to the gate task, which parses it.
+    // Nothing here scales with the broker-supplied length.
+    if (len > MQTT_RX_MAX_PAYLOAD) {
+        instance->oversizeCommands++;
+        LOG(MQTT_PAYLOAD_OVERSIZE, len, MQTT_RX_MAX_PAYLOAD);
+        return;
+    }
+
+    int8_t slot = instance->rxPool->acquire();
+    if (slot == RxPool::NO_SLOT) {
+        instance->droppedCommands++;
+        LOG(MQTT_NO_RX_SLOT);
+        return;
+    }
+
+    RxMessage& msg = instance->rxPool->get(slot);
+    memcpy(msg.data, payload, len);
+    msg.len = (uint16_t)len;
+    msg.binary = binary;
 
-    Serial.print("[MQTT] Message received on topic: ");
-    Serial.print(topic);
-    Serial.print(", payload: ");
-    Serial.println(message);
+    if (!instance->commandRing->push(slot)) {
+        instance->rxPool->release(slot);
+        instance->droppedCommands++;
+        LOG(MQTT_COMMAND_QUEUE_FULL);
+        return;
+    }
 
-    if (instance->commandCallback != nullptr) {
-        instance->commandCallback(topic, message);
+    if (instance->commandNotify != nullptr) {
+        instance->commandNotify();
     }
 }
 
@@ -277,20 +605,17 @@ uint8_t MqttManager::getMqttFailStreak() const {
 
 void MqttManager::resetMqttFailStreak() {
     if (mqttFailStreak > 0) {
-        Serial.print("[MQTT] Resetting failure streak (was ");
-        Serial.print(mqttFailStreak);
-        Serial.println(")");
+        LOG(MQTT_FAIL_STREAK_RESET, mqttFailStreak);
     }
     mqttFailStreak = 0;
 }
 
 void MqttManager::incrementFailStreak() {
     mqttFailStreak++;
-    Serial.print("[MQTT] Failure streak: ");
-    Serial.println(mqttFailStreak);
+    LOG(MQTT_FAIL_STREAK, mqttFailStreak);
 
     if (shouldRebuildPpp()) {
-        Serial.println("[MQTT] Failure threshold exceeded, will rebuild PPP");
+        LOG(MQTT_REBUILD_PPP);
     }
 }
 
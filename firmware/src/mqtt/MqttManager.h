@@ -5,11 +5,15 @@
 #include <stdint.h>
 #include "config/config.h"
 #include "util/Backoff.h"
+#include "protocol/Protocol.h"
+#include "Outbox.h"
+#include "StatusSchedule.h"
 #include "tinygsm_pre.h"  // Must be before TinyGSM includes
 #include <TinyGsm.h>  // For TinyGsm type
 
-// Forward declaration
+// Forward declarations
 class PppManager;
+class ModemManager;
 
 /**
  * MQTT client manager with automatic reconnection and failure tracking.
@@ -44,11 +48,27 @@ public:
 
     /**
      * Connect to MQTT broker.
+     * Resumes the persistent session of MQTT_CLIENT_ID, so commands the broker
+     * queued during an outage are delivered right after CONNECT (set the command
+     * queue first). Registers the Last Will ({online:false} on the status topic)
+     * and, once subscribed, publishes the full status as a retained birth message.
      * Returns true if connected, false otherwise.
      * Non-blocking, call repeatedly until returns true.
      */
     bool connect();
 
+    /**
+     * Adopt a modem MQTT client left connected by the previous boot (warm reboot).
+     * Re-attaches the message callback; the modem keeps the session and subscription.
+     * Returns false if the modem no longer reports that client connected.
+     */
+    bool adoptSession(uint8_t clientIndex);
+
+    /**
+     * Modem MQTT client index in use (0 or 1).
+     */
+    uint8_t getClientIndex() const;
+
     /**
      * Disconnect from MQTT broker.
      */
@@ -56,6 +76,7 @@ public:
 
     /**
      * Check if MQTT is currently connected.
+     * Reads the state cached from modem URCs (+CMQTTCONNLOST), no AT round trip.
      */
     bool isConnected() const;
 
@@ -65,20 +86,78 @@ public:
      */
     bool publish(const char* topic, const char* payload, bool retained = false);
 
+    /**
+     * Publish a binary payload (may contain 0x00) at QoS 1.
+     * Returns true if the modem reported the publish complete.
+     */
+    bool publishBinary(const char* topic, const uint8_t* payload, size_t len);
+
+    /**
+     * Queue a message for flushOutbox() (see mqtt/Outbox.h). Works while
+     * disconnected. Returns false if the queue dropped it.
+     */
+    bool enqueue(OutboxTopic topic, const void* payload, size_t len, OutboxPriority priority,
+                 uint8_t qos, uint8_t flags = 0, uint32_t tag = 0);
+
+    /**
+     * Publish queued messages in order, at most OUTBOX_FLUSH_BATCH per call.
+     * Stops at the first failed publish (the message stays queued) and reports
+     * the connection lost. Call from the network loop while connected.
+     */
+    void flushOutbox();
+
+    /**
+     * Called after a queued message leaves the queue: delivered, or dropped
+     * after OUTBOX_MAX_ATTEMPTS failed publishes. tag is the value given to enqueue().
+     */
+    void setDeliveryHandler(void (*handler)(OutboxTopic topic, uint32_t tag, bool delivered));
+
+    /**
+     * Messages waiting in the outbox.
+     */
+    size_t getOutboxDepth() const;
+
+    /**
+     * Age of the oldest message waiting in the outbox (ms, 0 if empty).
+     */
+    uint32_t getOutboxAgeMs() const;
+
     /**
      * Publish ACK message.
      */
     void publishAck(const char* requestId, bool ok, const char* errorCode = nullptr);
 
     /**
-     * Publish status message.
+     * Publish status if anything is due (caller schedules it every STATUS_INTERVAL_MS):
+     * the full document after each connect, a delta with only the changed fields
+     * when the RSSI bucket or error count changes, otherwise a bare heartbeat
+     * (deviceId, online, updatedAt) every STATUS_LIVENESS_MS.
      */
     void publishStatus();
 
     /**
-     * Set callback for incoming command messages.
+     * Set queue for incoming commands.
+     * Messages on the command topic are copied into a pool slot in the MQTT
+     * callback and the slot index is pushed to the ring; the consumer parses the
+     * payload and releases the slot. notify (optional) is called after each push.
+     */
+    void setCommandQueue(CommandRing* ring, RxPool* pool, void (*notify)());
+
+    /**
+     * Number of commands dropped because no receive slot was free or the queue was full.
+     */
+    uint32_t getDroppedCommandCount() const;
+
+    /**
+     * Number of commands rejected for exceeding MQTT_RX_MAX_PAYLOAD.
+     */
+    uint32_t getOversizeCommandCount() const;
+
+    /**
+     * Add errors counted outside MqttManager (e.g. GateTask::getErrorCount) to
+     * the status errors field. count is read from the network task.
      */
-    void setCommandCallback(void (*callback)(const char* topic, const char* payload));
+    void setErrorCounter(uint32_t (*count)());
 
     /**
      * Call this in loop() to process MQTT messages.
@@ -116,11 +195,38 @@ private:
     bool connected;
     uint8_t mqttFailStreak;
     unsigned long lastConnectAttempt;
-    unsigned long lastStatusPublish;
-    void (*commandCallback)(const char* topic, const char* payload);
+    CommandRing* commandRing;
+    RxPool* rxPool;
+    void (*commandNotify)();
+    uint32_t droppedCommands;
+    uint32_t oversizeCommands;
+    uint32_t (*errorCounter)();
+
+    // Status as last published; publishStatus() only sends what changed
+    StatusSchedule statusSchedule;
+    unsigned long lastRssiSampleAt;
+    int rssi;                // last sample in dBm, 0 if unknown
+
+    Outbox outbox;
+    void (*deliveryHandler)(OutboxTopic topic, uint32_t tag, bool delivered);
+
+    bool sslEnabled;
+
+    bool linkUp() const;
+    bool uartFree() const;
+
+    bool openSession(const char* host, uint16_t port, const char* clientId,
+                     const char* username, const char* password);
+    bool subscribe(const char* topic, uint8_t qos);
+    bool writePrompt(const void* data, size_t len);
+    bool publishRaw(const char* topic, const uint8_t* payload, size_t len, bool retained, uint8_t qos = 1);
+    bool sendStatus(unsigned long now);
+    void sampleRssi(unsigned long now);
+    static void onCsqLine(const char* line, size_t len, void* ctx);
 
     // PppManager reference (for getting TinyGsm modem)
     PppManager* pppManager;
+    ModemManager* modemManager;  // URC-cached link state
     TinyGsm* modem;  // Direct access to modem for MQTT API
 
     // Custom MQTT settings (if set via begin(host, port, ...))
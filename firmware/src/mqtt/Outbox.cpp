@@ -0,0 +1,247 @@
+#include "Outbox.h"
+#include "util/Log.h"
+#include <Preferences.h>
+#include <string.h>
+
+static const char* NVS_NAMESPACE = "pgr_outbox";
+static const char* NVS_KEY_HEAD = "head";
+static const char* NVS_KEY_TAIL = "tail";
+
+static const char* const TOPICS[OUTBOX_TOPIC_COUNT] = {
+    MQTT_ACK_TOPIC,
+    MQTT_ACK_BIN_TOPIC,
+    MQTT_DIAGNOSTICS_TOPIC,
+};
+
+// Header bytes of OutboxMessage (stored in NVS together with payload[len])
+#define OUTBOX_HEADER_LEN offsetof(OutboxMessage, payload)
+
+// peeked value for the spilled message held in spillMsg
+#define PEEKED_SPILL OUTBOX_PRIORITY_COUNT
+
+Outbox::Outbox()
+    : peeked(-1), spillMsgValid(false), spillHead(0), spillTail(0), spillOldestAt(0), dropped(0), spilled(0) {
+    rings[OUTBOX_PRIORITY_HIGH] = {highSlots, OUTBOX_SLOTS_HIGH, 0, 0};
+    rings[OUTBOX_PRIORITY_LOW] = {lowSlots, OUTBOX_SLOTS_LOW, 0, 0};
+#if OUTBOX_NVS_SPILL
+    spillLoad();
+#endif
+}
+
+bool Outbox::push(OutboxTopic topic, const void* payload, size_t len, OutboxPriority priority,
+                  uint8_t qos, uint8_t flags, uint32_t tag) {
+    if (len > OUTBOX_PAYLOAD_MAX || topic >= OUTBOX_TOPIC_COUNT || priority >= OUTBOX_PRIORITY_COUNT) {
+        dropped++;
+        LOG(OUTBOX_DROPPED, topicName(topic), (unsigned int)len);
+        return false;
+    }
+
+    Ring& ring = rings[priority];
+    // Once messages are spilled, newer spillable ones follow them to NVS to keep
+    // the order; the others still use free RAM slots
+    bool toSpill = ring.count == ring.capacity ||
+                   ((flags & OUTBOX_FLAG_SPILL) && priority == OUTBOX_PRIORITY_HIGH && spillHead != spillTail);
+    OutboxMessage spill;
+    OutboxMessage* msg = toSpill ? &spill : &ring.slots[ring.head];
+    msg->enqueuedAt = millis();
+    msg->tag = tag;
+    msg->len = (uint16_t)len;
+    msg->topic = topic;
+    msg->qos = qos;
+    msg->flags = flags;
+    msg->attempts = 0;
+    memcpy(msg->payload, payload, len);
+
+    if (!toSpill) {
+        ring.head = (ring.head + 1) % ring.capacity;
+        ring.count++;
+        return true;
+    }
+
+#if OUTBOX_NVS_SPILL
+    // Only the high ring drains the spill (see peek())
+    if ((flags & OUTBOX_FLAG_SPILL) && priority == OUTBOX_PRIORITY_HIGH && spillPush(spill)) {
+        return true;
+    }
+#endif
+    dropped++;
+    LOG(OUTBOX_DROPPED, topicName(topic), (unsigned int)len);
+    return false;
+}
+
+OutboxMessage* Outbox::peek() {
+    for (uint8_t p = 0; p < OUTBOX_PRIORITY_COUNT; p++) {
+        Ring& ring = rings[p];
+        if (ring.count > 0) {
+            peeked = p;
+            uint8_t oldest = (ring.head + ring.capacity - ring.count) % ring.capacity;
+            return &ring.slots[oldest];
+        }
+#if OUTBOX_NVS_SPILL
+        // The spill belongs to the high priority and follows its RAM messages.
+        // Sent from a copy; the record stays in NVS until pop().
+        if (p == OUTBOX_PRIORITY_HIGH) {
+            while (!spillMsgValid && spillHead != spillTail) {
+                if (spillRead(spillMsg)) {
+                    spillMsgValid = true;
+                } else {
+                    spillPop();  // unreadable record, skipped
+                }
+            }
+            if (spillMsgValid) {
+                peeked = PEEKED_SPILL;
+                return &spillMsg;
+            }
+        }
+#endif
+    }
+    peeked = -1;
+    return nullptr;
+}
+
+void Outbox::pop() {
+    if (peeked < 0) {
+        return;
+    }
+#if OUTBOX_NVS_SPILL
+    if (peeked == PEEKED_SPILL) {
+        spillPop();
+        peeked = -1;
+        return;
+    }
+#endif
+    Ring& ring = rings[peeked];
+    if (ring.count > 0) {
+        ring.count--;
+    }
+    peeked = -1;
+}
+
+size_t Outbox::depth() const {
+    size_t n = spillHead - spillTail;
+    for (uint8_t p = 0; p < OUTBOX_PRIORITY_COUNT; p++) {
+        n += rings[p].count;
+    }
+    return n;
+}
+
+uint32_t Outbox::oldestAgeMs(uint32_t nowMs) const {
+    uint32_t age = 0;
+    for (uint8_t p = 0; p < OUTBOX_PRIORITY_COUNT; p++) {
+        const Ring& ring = rings[p];
+        if (ring.count > 0) {
+            uint8_t oldest = (ring.head + ring.capacity - ring.count) % ring.capacity;
+            uint32_t a = nowMs - ring.slots[oldest].enqueuedAt;
+            if (a > age) age = a;
+        }
+    }
+    // Spilled messages are newer than the RAM ones, unless they survived a reboot
+    if (spillHead != spillTail && (int32_t)(nowMs - spillOldestAt) > (int32_t)age) {
+        age = nowMs - spillOldestAt;
+    }
+    return age;
+}
+
+uint32_t Outbox::getDroppedCount() const {
+    return dropped;
+}
+
+uint32_t Outbox::getSpilledCount() const {
+    return spilled;
+}
+
+const char* Outbox::topicName(uint8_t topic) {
+    return topic < OUTBOX_TOPIC_COUNT ? TOPICS[topic] : "?";
+}
+
+#if OUTBOX_NVS_SPILL
+/**
+ * Append to the NVS journal: message key first, then head, so a reset in
+ * between leaves the record outside [tail, head).
+ */
+bool Outbox::spillPush(const OutboxMessage& msg) {
+    if (spillHead - spillTail >= OUTBOX_NVS_SLOTS) {
+        return false;
+    }
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        return false;
+    }
+    char key[8];
+    spillKey(spillHead, key);
+    bool ok = prefs.putBytes(key, &msg, OUTBOX_HEADER_LEN + msg.len) == OUTBOX_HEADER_LEN + msg.len;
+    if (ok) {
+        if (spillHead == spillTail) {
+            spillOldestAt = msg.enqueuedAt;
+        }
+        spillHead++;
+        prefs.putUInt(NVS_KEY_HEAD, spillHead);
+        spilled++;
+        LOG(OUTBOX_SPILLED, topicName(msg.topic), (unsigned int)(spillHead - spillTail));
+    }
+    prefs.end();
+    return ok;
+}
+
+/**
+ * Copy the oldest NVS message without removing it.
+ */
+bool Outbox::spillRead(OutboxMessage& msg) {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {
+        return false;
+    }
+    char key[8];
+    spillKey(spillTail, key);
+    size_t len = prefs.getBytesLength(key);
+    bool ok = len >= OUTBOX_HEADER_LEN && len <= sizeof(OutboxMessage) &&
+              prefs.getBytes(key, &msg, len) == len && OUTBOX_HEADER_LEN + msg.len == len &&
+              msg.topic < OUTBOX_TOPIC_COUNT;
+    prefs.end();
+    return ok;
+}
+
+/**
+ * Drop the oldest NVS message (delivered, given up on, or unreadable): key
+ * first, then tail, so a reset in between only leaves a stale key behind.
+ */
+void Outbox::spillPop() {
+    spillMsgValid = false;
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        spillTail = spillHead;  // NVS unusable: give up on the spill
+        return;
+    }
+    char key[8];
+    spillKey(spillTail, key);
+    prefs.remove(key);
+    spillTail++;
+    prefs.putUInt(NVS_KEY_TAIL, spillTail);
+    prefs.end();
+    if (spillTail != spillHead) {
+        spillOldestAt = millis();  // unknown until read: treat the rest as fresh
+    }
+}
+
+void Outbox::spillLoad() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {
+        return;
+    }
+    spillHead = prefs.getUInt(NVS_KEY_HEAD, 0);
+    spillTail = prefs.getUInt(NVS_KEY_TAIL, 0);
+    prefs.end();
+    if (spillHead - spillTail > OUTBOX_NVS_SLOTS) {
+        spillTail = spillHead - OUTBOX_NVS_SLOTS;
+    }
+    // Timestamps are from the previous boot: report them as queued since boot
+    spillOldestAt = 0;
+    if (spillHead != spillTail) {
+        LOG(OUTBOX_SPILL_RESTORED, (unsigned int)(spillHead - spillTail));
+    }
+}
+
+void Outbox::spillKey(uint32_t seq, char* key) {
+    snprintf(key, 8, "m%02x", (unsigned)(seq % OUTBOX_NVS_SLOTS));
+}
+#endif
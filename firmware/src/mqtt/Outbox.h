@@ -0,0 +1,113 @@
+#ifndef OUTBOX_H
+#define OUTBOX_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "config/config.h"
+
+// Destination of a queued message (stored by index so it can be spilled to NVS)
+enum OutboxTopic : uint8_t {
+    OUTBOX_TOPIC_ACK = 0,
+    OUTBOX_TOPIC_ACK_BIN,
+    OUTBOX_TOPIC_DIAGNOSTICS,
+    OUTBOX_TOPIC_COUNT
+};
+
+// Lower value is sent first
+enum OutboxPriority : uint8_t {
+    OUTBOX_PRIORITY_HIGH = 0,  // ACKs
+    OUTBOX_PRIORITY_LOW,       // diagnostics
+    OUTBOX_PRIORITY_COUNT
+};
+
+// Message may go to NVS when its RAM ring is full (and survives a reboot there)
+#define OUTBOX_FLAG_SPILL 0x01
+
+struct OutboxMessage {
+    uint32_t enqueuedAt;  // millis()
+    uint32_t tag;         // caller data, handed back on delivery
+    uint16_t len;
+    uint8_t topic;        // OutboxTopic
+    uint8_t qos;
+    uint8_t flags;        // OUTBOX_FLAG_*
+    uint8_t attempts;     // failed publishes so far
+    uint8_t payload[OUTBOX_PAYLOAD_MAX];
+};
+
+/**
+ * Outbound publish queue (store-and-forward).
+ * One RAM ring per priority; the oldest message of the highest non-empty
+ * priority is sent first and removed only once its publish is confirmed (for
+ * QoS 1, the modem reports +CMQTTPUB after the broker's PUBACK). With
+ * OUTBOX_NVS_SPILL, messages flagged OUTBOX_FLAG_SPILL that do not fit in RAM
+ * are journaled to NVS instead of dropped, and are sent after the RAM ones.
+ * A spilled message is read from NVS for sending and only deleted there once
+ * delivered, so a reset in between sends it again.
+ * Not thread-safe: used from the network task only.
+ */
+class Outbox {
+public:
+    Outbox();
+
+    /**
+     * Queue a message. Returns false if it was dropped (payload too large, or
+     * the ring and spill are full).
+     */
+    bool push(OutboxTopic topic, const void* payload, size_t len, OutboxPriority priority,
+              uint8_t qos, uint8_t flags = 0, uint32_t tag = 0);
+
+    /**
+     * Next message to send, or nullptr if empty. Valid until pop() or push().
+     */
+    OutboxMessage* peek();
+
+    /**
+     * Remove the message returned by peek() (after it was published).
+     */
+    void pop();
+
+    /** Messages queued (RAM and NVS). */
+    size_t depth() const;
+
+    /** Age of the oldest queued message in ms (0 if empty). */
+    uint32_t oldestAgeMs(uint32_t nowMs) const;
+
+    /** Messages dropped because the queue was full. */
+    uint32_t getDroppedCount() const;
+
+    /** Messages written to NVS because RAM was full. */
+    uint32_t getSpilledCount() const;
+
+    static const char* topicName(uint8_t topic);
+
+private:
+    struct Ring {
+        OutboxMessage* slots;
+        uint8_t capacity;
+        uint8_t head;   // next slot to write
+        uint8_t count;
+    };
+
+    bool spillPush(const OutboxMessage& msg);
+    bool spillRead(OutboxMessage& msg);
+    void spillPop();
+    void spillLoad();
+    static void spillKey(uint32_t seq, char* key);
+
+    OutboxMessage highSlots[OUTBOX_SLOTS_HIGH];
+    OutboxMessage lowSlots[OUTBOX_SLOTS_LOW];
+    Ring rings[OUTBOX_PRIORITY_COUNT];
+    int8_t peeked;             // priority of the message returned by peek(), -1 if none
+                               // (OUTBOX_PRIORITY_COUNT: spillMsg)
+    OutboxMessage spillMsg;    // copy of the oldest NVS message while it is being sent
+    bool spillMsgValid;
+
+    uint32_t spillHead;        // next NVS sequence number to write
+    uint32_t spillTail;        // oldest NVS message
+    uint32_t spillOldestAt;    // enqueuedAt of the oldest NVS message
+    uint32_t dropped;
+    uint32_t spilled;
+};
+
+#endif // OUTBOX_H
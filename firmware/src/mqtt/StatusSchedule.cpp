@@ -0,0 +1,39 @@
+#include "StatusSchedule.h"
+
+StatusSchedule::StatusSchedule()
+    : fullPending(true), lastSentAt(0), publishedRssiBucket(0), publishedErrors(0), publishedOutboxDepth(0) {
+}
+
+void StatusSchedule::requestFull() {
+    fullPending = true;
+}
+
+bool StatusSchedule::due(unsigned long now, int rssi, uint32_t errors, size_t outboxDepth,
+                         StatusPlan& plan) const {
+    plan.full = fullPending;
+    plan.withRssi = fullPending || rssiBucket(rssi) != publishedRssiBucket;
+    plan.withErrors = fullPending || errors != publishedErrors;
+    plan.withOutbox = fullPending || outboxDepth > 0 || publishedOutboxDepth > 0;
+    return plan.withRssi || plan.withErrors || now - lastSentAt >= STATUS_LIVENESS_MS;
+}
+
+void StatusSchedule::sent(const StatusPlan& plan, unsigned long now, int rssi, uint32_t errors,
+                          size_t outboxDepth) {
+    if (plan.full) {
+        fullPending = false;
+    }
+    lastSentAt = now;
+    if (plan.withRssi) {
+        publishedRssiBucket = rssiBucket(rssi);
+    }
+    if (plan.withErrors) {
+        publishedErrors = errors;
+    }
+    if (plan.withOutbox) {
+        publishedOutboxDepth = outboxDepth;
+    }
+}
+
+int StatusSchedule::rssiBucket(int rssi) {
+    return rssi == 0 ? 0 : 1 + (rssi + 113) / STATUS_RSSI_BUCKET_DB;
+}
@@ -0,0 +1,56 @@
+#ifndef STATUS_SCHEDULE_H
+#define STATUS_SCHEDULE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config/config.h"
+
+// Fields one status message carries (deviceId, online and updatedAt always go)
+struct StatusPlan {
+    bool full;        // birth: every field, retained
+    bool withRssi;
+    bool withErrors;
+    bool withOutbox;
+};
+
+/**
+ * Decides what MqttManager::publishStatus() sends: the full document after each
+ * connect, a delta with only the changed fields when the RSSI bucket or error
+ * count changes, otherwise a bare heartbeat every STATUS_LIVENESS_MS. The outbox
+ * backlog rides along while there is one, and once more when it has drained.
+ * Holds no I/O, so the policy runs on the host as well.
+ */
+class StatusSchedule {
+public:
+    StatusSchedule();
+
+    /**
+     * Make the next status the full document (call on every connect).
+     */
+    void requestFull();
+
+    /**
+     * What is due at now. Returns false if nothing changed and the heartbeat is
+     * not due yet.
+     */
+    bool due(unsigned long now, int rssi, uint32_t errors, size_t outboxDepth, StatusPlan& plan) const;
+
+    /**
+     * Record that plan was published at now with these values.
+     */
+    void sent(const StatusPlan& plan, unsigned long now, int rssi, uint32_t errors, size_t outboxDepth);
+
+    /**
+     * STATUS_RSSI_BUCKET_DB wide bucket of an RSSI in dBm; 0 if unknown.
+     */
+    static int rssiBucket(int rssi);
+
+private:
+    bool fullPending;
+    unsigned long lastSentAt;
+    int publishedRssiBucket;
+    uint32_t publishedErrors;
+    size_t publishedOutboxDepth;
+};
+
+#endif // STATUS_SCHEDULE_H
@@ -10,6 +10,7 @@
 #include <HardwareSerial.h>
 #include "config/config.h"
 #include "modem/ModemManager.h"
+#include "PppSession.h"
 
 // Include utilities.h for board pin definitions
 #include "utilities.h"
@@ -20,6 +21,8 @@
 
 /**
  * Manages PPP connection over UART to cellular modem.
+ * Bring-up (registration, APN, data session, IP) is done by a PppSession on
+ * ModemManager's AT queue, so waitForPppUp() never waits for the modem.
  * Tracks failure streak and triggers modem hard reset when threshold exceeded.
  */
 class PppManager {
@@ -38,8 +41,8 @@ public:
     void stop();
 
     /**
-     * Wait for PPP to come up (IP assigned).
-     * Returns true if PPP is up within timeout.
+     * Advance the bring-up (call every loop pass; returns immediately).
+     * Returns true once PPP is up (IP assigned); gives up after timeoutMs.
      */
     bool waitForPppUp(unsigned long timeoutMs);
 
@@ -73,6 +76,12 @@ public:
      */
     TinyGsm* getModem();
 
+    /**
+     * TinyGSM instance for HTTPS (OOB): on the auxiliary CMUX channel when the
+     * multiplexer is up, otherwise the same as getModem().
+     */
+    TinyGsm* getAuxModem();
+
     /**
      * Get TinyGsmClient instance (for use by MqttManager).
      */
@@ -96,12 +105,14 @@ private:
     unsigned long pppStartTime;
     bool pppStarting;
 
+    PppSession session;
+
     // TinyGSM instances
     TinyGsm* tinyGsmModem;
+    TinyGsm* tinyGsmAuxModem;   // only while CMUX is up
     TinyGsmClient* tinyGsmClient;
-    HardwareSerial* modemSerial;
+    Stream* modemStream;
 
-    bool checkIpAssigned();
     bool initializeTinyGsm();
     void deinitializeTinyGsm();
 };
@@ -0,0 +1,255 @@
+#include "PppSession.h"
+#include "util/BootReport.h"
+#include "util/Log.h"
+#include <stdio.h>
+#include <string.h>
+
+PppSession::PppSession(AtQueue& queue, const ModemLinkState& link)
+    : queue(queue), link(link), state(PPP_STATE_WAIT_REGISTRATION), stageStart(0), nextAttemptAt(0),
+      attempts(0), netOpenSeen(0), netAlreadyOpen(false), cmdIssued(false), cmdPending(false),
+      cmdResult(AT_RESULT_PENDING) {
+    ipAddress[0] = '\0';
+}
+
+void PppSession::begin(bool probeExisting, unsigned long now) {
+    cmdIssued = false;
+    cmdPending = false;
+    attempts = 0;
+    ipAddress[0] = '\0';
+    // ModemManager already verified the SIM, so a cold start goes straight to registration
+    enterState(probeExisting ? PPP_STATE_PROBE_EXISTING : PPP_STATE_WAIT_REGISTRATION, now);
+}
+
+void PppSession::cancel() {
+    queue.cancel(this);
+    cmdIssued = false;
+    cmdPending = false;
+}
+
+const char* PppSession::getIpAddress() const {
+    return ipAddress;
+}
+
+bool PppSession::poll(unsigned long now) {
+    switch (state) {
+        case PPP_STATE_PROBE_EXISTING:
+            // The answer goes through the URC router, which caches it
+            if (!runCommand("AT+CREG?", AT_CMD_TIMEOUT_MS)) {
+                break;
+            }
+            if (registered()) {
+                BootReport::mark(BOOT_PHASE_NET_REGISTERED);
+                ipAddress[0] = '\0';
+                enterState(PPP_STATE_PROBE_IP, now);
+            } else {
+                LOG(PPP_WARM_NOT_REGISTERED);
+                enterState(PPP_STATE_WAIT_REGISTRATION, now);
+            }
+            break;
+
+        case PPP_STATE_PROBE_IP:
+            if (!runCommand("AT+IPADDR", AT_CMD_TIMEOUT_MS, onIpLine)) {
+                break;
+            }
+            if (hasIp()) {
+                LOG(PPP_WARM_SESSION_ACTIVE, ipAddress);
+                BootReport::mark(BOOT_PHASE_PDP_ACTIVE);
+                return setUp();
+            }
+            LOG(PPP_WARM_NO_IP);
+            enterState(PPP_STATE_SET_APN, now);
+            break;
+
+        case PPP_STATE_WAIT_REGISTRATION:
+            // +CREG URCs keep the cached status current: no query once registered
+            if (registered()) {
+                LOG(PPP_REGISTERED, link.registration == 5 ? "roaming" : "home network");
+                BootReport::mark(BOOT_PHASE_NET_REGISTERED);
+                enterState(PPP_STATE_SET_APN, now);
+                break;
+            }
+            if (link.registration == 3) {
+                LOG(PPP_REG_DENIED);
+                return false;
+            }
+            if (!cmdIssued && !due(now)) {
+                break;
+            }
+            if (runCommand("AT+CREG?", AT_CMD_TIMEOUT_MS)) {
+                if (!registered()) {
+                    LOG(PPP_REG_WAIT, link.registration);
+                }
+                nextAttemptAt = now + PPP_REG_POLL_MS;
+            }
+            break;
+
+        case PPP_STATE_SET_APN:
+            if (!cmdIssued && !due(now)) {
+                break;
+            }
+            {
+                char cmd[MODEM_AT_CMD_MAX];
+                snprintf(cmd, sizeof(cmd), "AT+CGDCONT=1,\"IP\",\"%s\"", CELLULAR_APN);
+                if (!runCommand(cmd, AT_CMD_TIMEOUT_MS)) {
+                    break;
+                }
+            }
+            if (cmdResult == AT_RESULT_OK) {
+                LOG(PPP_APN_SET, CELLULAR_APN);
+                attempts = 0;
+                enterState(PPP_STATE_ACTIVATE_NETWORK, now);
+            } else {
+                LOG(PPP_APN_FAILED);
+                nextAttemptAt = now + PPP_APN_RETRY_MS;
+            }
+            break;
+
+        case PPP_STATE_ACTIVATE_NETWORK:
+            if (!cmdIssued) {
+                if (!due(now)) {
+                    break;
+                }
+                LOG(PPP_ACTIVATING);
+                netOpenSeen = link.netOpenCount;
+                netAlreadyOpen = false;
+            }
+            if (!runCommand("AT+NETOPEN", AT_CMD_TIMEOUT_MS, onNetOpenLine)) {
+                break;
+            }
+            if (cmdResult != AT_RESULT_OK && !netAlreadyOpen) {
+                return retryActivation(now);
+            }
+            enterState(PPP_STATE_WAIT_NETWORK, now);
+            break;
+
+        case PPP_STATE_WAIT_NETWORK:
+            // The result arrives as a +NETOPEN URC after the command's OK; nothing
+            // else reads the stream before the data session is up
+            queue.readUrcs();
+            if (netAlreadyOpen || (link.netOpenCount != netOpenSeen && link.netOpenError == 0)) {
+                LOG(PPP_ACTIVATED);
+                BootReport::mark(BOOT_PHASE_PDP_ACTIVE);
+                // Poll for IP assignment right away instead of a fixed wait
+                enterState(PPP_STATE_GET_IP, now);
+            } else if (link.netOpenCount != netOpenSeen || now - stageStart > PPP_NETOPEN_TIMEOUT_MS) {
+                return retryActivation(now);
+            }
+            break;
+
+        case PPP_STATE_GET_IP:
+            if (!cmdIssued) {
+                if (!due(now)) {
+                    break;
+                }
+                ipAddress[0] = '\0';
+            }
+            if (!runCommand("AT+IPADDR", AT_CMD_TIMEOUT_MS, onIpLine)) {
+                break;
+            }
+            if (hasIp()) {
+                LOG(PPP_IP_ASSIGNED, ipAddress);
+                return setUp();
+            }
+            if (now - stageStart > PPP_IP_MAX_WAIT_MS) {
+                LOG(PPP_NO_IP, (unsigned long)PPP_IP_MAX_WAIT_MS);
+                enterState(PPP_STATE_GET_IP, now);
+                return false;
+            }
+            LOG(PPP_IP_WAIT);
+            nextAttemptAt = now + PPP_IP_POLL_INTERVAL_MS;
+            break;
+
+        case PPP_STATE_CONNECTED:
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Network activation failed: try again after PPP_ACTIVATE_RETRY_MS, or report
+ * the failure after PPP_ACTIVATE_MAX_ATTEMPTS (and start counting again).
+ */
+bool PppSession::retryActivation(unsigned long now) {
+    attempts++;
+    LOG(PPP_ACTIVATE_RETRY, attempts, (unsigned int)PPP_ACTIVATE_MAX_ATTEMPTS);
+    enterState(PPP_STATE_ACTIVATE_NETWORK, now);
+    if (attempts >= PPP_ACTIVATE_MAX_ATTEMPTS) {
+        LOG(PPP_ACTIVATE_FAILED, (unsigned int)PPP_ACTIVATE_MAX_ATTEMPTS);
+        attempts = 0;
+        return false;
+    }
+    nextAttemptAt = now + PPP_ACTIVATE_RETRY_MS;
+    return false;
+}
+
+void PppSession::enterState(State next, unsigned long now) {
+    state = next;
+    stageStart = now;
+    nextAttemptAt = now;
+}
+
+bool PppSession::due(unsigned long now) const {
+    return (long)(now - nextAttemptAt) >= 0;
+}
+
+bool PppSession::registered() const {
+    return link.registration == 1 || link.registration == 5;
+}
+
+/**
+ * Run one AT command of the current stage through the AT queue.
+ * Returns true once it has completed (outcome in cmdResult), false while it is
+ * queued or in flight, or if the queue is full (queued again on the next call).
+ */
+bool PppSession::runCommand(const char* cmd, unsigned long timeoutMs, AtLineHandler onLine) {
+    if (!cmdIssued) {
+        cmdPending = true;
+        cmdResult = AT_RESULT_PENDING;
+        if (!queue.enqueue(cmd, AT_PRIORITY_HIGH, timeoutMs, onCommandDone, this, onLine)) {
+            cmdPending = false;
+            return false;
+        }
+        cmdIssued = true;
+    }
+    if (cmdPending) {
+        return false;
+    }
+    cmdIssued = false;
+    return true;
+}
+
+bool PppSession::hasIp() const {
+    return ipAddress[0] != '\0' && strcmp(ipAddress, "0.0.0.0") != 0;
+}
+
+bool PppSession::setUp() {
+    BootReport::mark(BOOT_PHASE_IP_ASSIGNED);
+    state = PPP_STATE_CONNECTED;
+    return true;
+}
+
+void PppSession::onCommandDone(AtResult result, void* ctx) {
+    PppSession* self = static_cast<PppSession*>(ctx);
+    self->cmdResult = result;
+    self->cmdPending = false;
+}
+
+// +IPADDR: <ip>
+void PppSession::onIpLine(const char* line, size_t len, void* ctx) {
+    (void)len;
+    if (strncmp(line, "+IPADDR: ", 9) != 0) {
+        return;
+    }
+    PppSession* self = static_cast<PppSession*>(ctx);
+    strncpy(self->ipAddress, line + 9, sizeof(self->ipAddress) - 1);
+    self->ipAddress[sizeof(self->ipAddress) - 1] = '\0';
+}
+
+// "+IP ERROR: Network is already opened" (then ERROR) counts as success
+void PppSession::onNetOpenLine(const char* line, size_t len, void* ctx) {
+    (void)len;
+    if (strstr(line, "already opened") != nullptr) {
+        static_cast<PppSession*>(ctx)->netAlreadyOpen = true;
+    }
+}
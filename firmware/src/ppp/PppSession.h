@@ -0,0 +1,84 @@
+#ifndef PPP_SESSION_H
+#define PPP_SESSION_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "config/config.h"
+#include "modem/AtQueue.h"
+#include "modem/ModemStream.h"
+
+/**
+ * Data session bring-up on the modem: registration, APN, AT+NETOPEN, IP.
+ * A per-instance state machine: every command goes through the AT queue and
+ * each stage ends on its result, a URC (+CREG, +NETOPEN, read from the link
+ * state) or its deadline, so poll() never waits for the modem. Knows nothing
+ * about TinyGSM (PppManager owns this and the TinyGSM instances).
+ * Used from the network task only.
+ */
+class PppSession {
+public:
+    PppSession(AtQueue& queue, const ModemLinkState& link);
+
+    /**
+     * Start over. With probeExisting (warm boot), first check whether the modem
+     * still holds a registered data session.
+     */
+    void begin(bool probeExisting, unsigned long now);
+
+    /**
+     * Advance the bring-up (call every loop pass; returns immediately).
+     * Returns true once an IP address is assigned.
+     */
+    bool poll(unsigned long now);
+
+    /**
+     * Drop the commands this session queued; one in flight completes unseen.
+     */
+    void cancel();
+
+    /**
+     * IP address reported by the modem ("" until assigned).
+     */
+    const char* getIpAddress() const;
+
+private:
+    enum State : uint8_t {
+        PPP_STATE_PROBE_EXISTING,   // warm boot: registered already?
+        PPP_STATE_PROBE_IP,         // warm boot: data session still up?
+        PPP_STATE_WAIT_REGISTRATION,
+        PPP_STATE_SET_APN,
+        PPP_STATE_ACTIVATE_NETWORK,
+        PPP_STATE_WAIT_NETWORK,     // AT+NETOPEN accepted, waiting for +NETOPEN
+        PPP_STATE_GET_IP,
+        PPP_STATE_CONNECTED
+    };
+
+    AtQueue& queue;
+    const ModemLinkState& link;
+
+    State state;
+    unsigned long stageStart;       // deadline base of the current stage
+    unsigned long nextAttemptAt;    // next poll or retry of the current stage
+    uint8_t attempts;
+    uint32_t netOpenSeen;           // link netOpenCount when AT+NETOPEN was sent
+    bool netAlreadyOpen;
+    char ipAddress[16];
+
+    // AT command of the current stage
+    bool cmdIssued;
+    bool cmdPending;
+    AtResult cmdResult;
+
+    void enterState(State next, unsigned long now);
+    bool due(unsigned long now) const;
+    bool registered() const;
+    bool runCommand(const char* cmd, unsigned long timeoutMs, AtLineHandler onLine = nullptr);
+    bool hasIp() const;
+    bool setUp();
+    bool retryActivation(unsigned long now);
+    static void onCommandDone(AtResult result, void* ctx);
+    static void onIpLine(const char* line, size_t len, void* ctx);
+    static void onNetOpenLine(const char* line, size_t len, void* ctx);
+};
+
+#endif // PPP_SESSION_H
@@ -1,95 +1,730 @@
 #include "Protocol.h"
-#include <ArduinoJson.h>
+#include "util/Log.h"
 
-bool Protocol::parseCommand(const char* json, CommandResult& result) {
-    result.valid = false;
+// Cursor over the payload being tokenized
+struct JsonCursor {
+    const char* p;
+    const char* end;
+};
+
+// Max nesting of skipped (unknown) object/array values
+#define PROTOCOL_MAX_NESTING 8
+
+static bool isDigit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+static bool isHexDigit(char ch) {
+    return isDigit(ch) || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+}
+
+static uint8_t hexValue(char ch) {
+    if (ch <= '9') return ch - '0';
+    if (ch <= 'F') return ch - 'A' + 10;
+    return ch - 'a' + 10;
+}
 
-    // Parse JSON
-    StaticJsonDocument<512> doc;
-    DeserializationError error = deserializeJson(doc, json);
+static void skipWhitespace(JsonCursor& c) {
+    while (c.p < c.end && (*c.p == ' ' || *c.p == '\t' || *c.p == '\n' || *c.p == '\r')) {
+        c.p++;
+    }
+}
 
-    if (error) {
-        Serial.print("[Protocol] JSON parse error: ");
-        Serial.println(error.c_str());
+// Scan a string at the opening quote; out (optional) gets the contents without quotes
+static bool scanString(JsonCursor& c, Span* out) {
+    if (c.p >= c.end || *c.p != '"') {
         return false;
     }
+    const char* start = ++c.p;
+    while (c.p < c.end) {
+        char ch = *c.p;
+        if (ch == '"') {
+            if (c.p - start > 0xFFFF) {
+                return false;
+            }
+            if (out != nullptr) {
+                out->ptr = start;
+                out->len = (uint16_t)(c.p - start);
+            }
+            c.p++;
+            return true;
+        }
+        if (ch == '\\') {
+            if (++c.p >= c.end) {
+                return false;
+            }
+            ch = *c.p;
+            if (ch == 'u') {
+                for (uint8_t i = 0; i < 4; i++) {
+                    if (++c.p >= c.end || !isHexDigit(*c.p)) {
+                        return false;
+                    }
+                }
+            } else if (ch != '"' && ch != '\\' && ch != '/' && ch != 'b' &&
+                       ch != 'f' && ch != 'n' && ch != 'r' && ch != 't') {
+                return false;
+            }
+        } else if ((unsigned char)ch < 0x20) {
+            return false;
+        }
+        c.p++;
+    }
+    return false;
+}
 
-    // Validate and extract required fields
-    if (!doc.containsKey("requestId") || !doc["requestId"].is<const char*>()) {
-        Serial.println("[Protocol] Missing or invalid requestId");
+// Scan a number; out gets its value truncated to an integer (negative values wrap, as before)
+static bool scanNumber(JsonCursor& c, unsigned long long* out) {
+    const char* start = c.p;
+    bool negative = false;
+    if (c.p < c.end && *c.p == '-') {
+        negative = true;
+        c.p++;
+    }
+    if (c.p >= c.end || !isDigit(*c.p)) {
         return false;
     }
 
-    if (!doc.containsKey("command") || !doc["command"].is<const char*>()) {
-        Serial.println("[Protocol] Missing or invalid command");
+    unsigned long long value = 0;
+    if (*c.p == '0') {
+        c.p++;
+    } else {
+        while (c.p < c.end && isDigit(*c.p)) {
+            value = value * 10 + (*c.p - '0');
+            c.p++;
+        }
+    }
+
+    bool integral = true;
+    if (c.p < c.end && *c.p == '.') {
+        integral = false;
+        c.p++;
+        if (c.p >= c.end || !isDigit(*c.p)) {
+            return false;
+        }
+        while (c.p < c.end && isDigit(*c.p)) c.p++;
+    }
+    if (c.p < c.end && (*c.p == 'e' || *c.p == 'E')) {
+        integral = false;
+        c.p++;
+        if (c.p < c.end && (*c.p == '+' || *c.p == '-')) c.p++;
+        if (c.p >= c.end || !isDigit(*c.p)) {
+            return false;
+        }
+        while (c.p < c.end && isDigit(*c.p)) c.p++;
+    }
+
+    if (!integral) {
+        // Rare (timestamps are integers): go through double like the JSON library did
+        char buf[32];
+        size_t n = c.p - start;
+        if (n >= sizeof(buf)) {
+            return false;
+        }
+        memcpy(buf, start, n);
+        buf[n] = '\0';
+        double d = strtod(buf, nullptr);
+        value = negative ? static_cast<unsigned long long>(static_cast<long long>(d))
+                         : static_cast<unsigned long long>(d);
+    } else if (negative) {
+        value = static_cast<unsigned long long>(-static_cast<long long>(value));
+    }
+
+    if (out != nullptr) {
+        *out = value;
+    }
+    return true;
+}
+
+static bool scanLiteral(JsonCursor& c, const char* literal) {
+    size_t n = strlen(literal);
+    if ((size_t)(c.end - c.p) < n || memcmp(c.p, literal, n) != 0) {
         return false;
     }
+    c.p += n;
+    return true;
+}
+
+// Skip a string, number or literal
+static bool skipScalar(JsonCursor& c) {
+    char ch = *c.p;
+    if (ch == '"') return scanString(c, nullptr);
+    if (ch == '-' || isDigit(ch)) return scanNumber(c, nullptr);
+    return scanLiteral(c, "true") || scanLiteral(c, "false") || scanLiteral(c, "null");
+}
 
-    if (!doc.containsKey("userId") || !doc["userId"].is<const char*>()) {
-        Serial.println("[Protocol] Missing or invalid userId");
+// Move to the next member's value: past the key and colon inside an object
+static bool skipToMemberValue(JsonCursor& c, char closer) {
+    skipWhitespace(c);
+    if (closer == '}') {
+        if (!scanString(c, nullptr)) {
+            return false;
+        }
+        skipWhitespace(c);
+        if (c.p >= c.end || *c.p != ':') {
+            return false;
+        }
+        c.p++;
+        skipWhitespace(c);
+    }
+    return c.p < c.end;
+}
+
+// Skip an object or array at its opening bracket, validating every nested value
+static bool skipContainer(JsonCursor& c) {
+    char closers[PROTOCOL_MAX_NESTING];
+    uint8_t depth = 0;
+    for (;;) {
+        // At a value: enter a container, or skip a scalar
+        if (*c.p == '{' || *c.p == '[') {
+            if (depth >= PROTOCOL_MAX_NESTING) {
+                return false;
+            }
+            closers[depth++] = (*c.p == '{') ? '}' : ']';
+            c.p++;
+            skipWhitespace(c);
+            if (c.p >= c.end || *c.p != closers[depth - 1]) {
+                if (!skipToMemberValue(c, closers[depth - 1])) {
+                    return false;
+                }
+                continue;
+            }
+            c.p++;
+            depth--;
+        } else if (!skipScalar(c)) {
+            return false;
+        }
+
+        // After a value: a comma moves to the next member, a closer ends the container
+        for (;;) {
+            if (depth == 0) {
+                return true;
+            }
+            skipWhitespace(c);
+            if (c.p >= c.end) {
+                return false;
+            }
+            if (*c.p == ',') {
+                c.p++;
+                if (!skipToMemberValue(c, closers[depth - 1])) {
+                    return false;
+                }
+                break;
+            }
+            if (*c.p != closers[depth - 1]) {
+                return false;
+            }
+            c.p++;
+            depth--;
+        }
+    }
+}
+
+static bool skipValue(JsonCursor& c) {
+    if (c.p >= c.end) {
         return false;
     }
+    if (*c.p == '{' || *c.p == '[') return skipContainer(c);
+    return skipScalar(c);
+}
 
-    // Check issuedAt - accept any numeric type (int64, uint64, or double)
-    if (!doc.containsKey("issuedAt") || !doc["issuedAt"].is<long long>() && !doc["issuedAt"].is<unsigned long long>() && !doc["issuedAt"].is<double>()) {
-        Serial.println("[Protocol] Missing or invalid issuedAt");
+static bool spanEquals(const Span& span, const char* literal) {
+    size_t n = strlen(literal);
+    return span.len == n && memcmp(span.ptr, literal, n) == 0;
+}
+
+// Copy a string span into dst, decoding JSON escapes; truncates to dstSize - 1
+static void copySpan(const Span& span, char* dst, size_t dstSize) {
+    size_t out = 0;
+    const char* p = span.ptr;
+    const char* end = span.ptr + span.len;
+    while (p < end && out + 1 < dstSize) {
+        char ch = *p++;
+        if (ch != '\\' || p >= end) {
+            dst[out++] = ch;
+            continue;
+        }
+        ch = *p++;
+        switch (ch) {
+            case 'b': dst[out++] = '\b'; break;
+            case 'f': dst[out++] = '\f'; break;
+            case 'n': dst[out++] = '\n'; break;
+            case 'r': dst[out++] = '\r'; break;
+            case 't': dst[out++] = '\t'; break;
+            case 'u': {
+                // Tokenizer guarantees 4 hex digits; encode the code unit as UTF-8
+                uint16_t cp = 0;
+                for (uint8_t i = 0; i < 4 && p < end; i++) {
+                    cp = (cp << 4) | hexValue(*p++);
+                }
+                if (cp < 0x80) {
+                    dst[out++] = (char)cp;
+                } else if (cp < 0x800) {
+                    if (out + 2 >= dstSize) { dst[out] = '\0'; return; }
+                    dst[out++] = (char)(0xC0 | (cp >> 6));
+                    dst[out++] = (char)(0x80 | (cp & 0x3F));
+                } else {
+                    if (out + 3 >= dstSize) { dst[out] = '\0'; return; }
+                    dst[out++] = (char)(0xE0 | (cp >> 12));
+                    dst[out++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    dst[out++] = (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default: dst[out++] = ch; break;  // \" \\ \/
+        }
+    }
+    dst[out] = '\0';
+}
+
+bool Protocol::tokenizeCommand(const char* json, size_t len, CommandFields& fields) {
+    fields = CommandFields();
+    if (json == nullptr) {
         return false;
     }
 
-    // Copy fields
-    strncpy(result.requestId, doc["requestId"].as<const char*>(), sizeof(result.requestId) - 1);
-    result.requestId[sizeof(result.requestId) - 1] = '\0';
-
-    strncpy(result.command, doc["command"].as<const char*>(), sizeof(result.command) - 1);
-    result.command[sizeof(result.command) - 1] = '\0';
-
-    strncpy(result.userId, doc["userId"].as<const char*>(), sizeof(result.userId) - 1);
-    result.userId[sizeof(result.userId) - 1] = '\0';
-
-    // Parse issuedAt - handle different numeric types
-    if (doc["issuedAt"].is<unsigned long long>()) {
-        result.issuedAt = doc["issuedAt"].as<unsigned long long>();
-    } else if (doc["issuedAt"].is<long long>()) {
-        result.issuedAt = static_cast<unsigned long long>(doc["issuedAt"].as<long long>());
-    } else if (doc["issuedAt"].is<double>()) {
-        result.issuedAt = static_cast<unsigned long long>(doc["issuedAt"].as<double>());
-    } else {
-        Serial.println("[Protocol] issuedAt is not a valid number");
+    JsonCursor c = { json, json + len };
+    skipWhitespace(c);
+    if (c.p >= c.end || *c.p != '{') {
         return false;
     }
+    c.p++;
+    skipWhitespace(c);
+    if (c.p < c.end && *c.p == '}') {
+        return true;
+    }
+
+    for (;;) {
+        Span key;
+        skipWhitespace(c);
+        if (!scanString(c, &key)) {
+            return false;
+        }
+        skipWhitespace(c);
+        if (c.p >= c.end || *c.p != ':') {
+            return false;
+        }
+        c.p++;
+        skipWhitespace(c);
+        if (c.p >= c.end) {
+            return false;
+        }
+
+        // Known fields of the wrong type clear their bit (a later duplicate wins)
+        uint8_t bit = 0;
+        Span* target = nullptr;
+        if (spanEquals(key, "requestId")) {
+            bit = CMD_FIELD_REQUEST_ID;
+            target = &fields.requestId;
+        } else if (spanEquals(key, "command")) {
+            bit = CMD_FIELD_COMMAND;
+            target = &fields.command;
+        } else if (spanEquals(key, "userId")) {
+            bit = CMD_FIELD_USER_ID;
+            target = &fields.userId;
+        } else if (spanEquals(key, "issuedAt")) {
+            bit = CMD_FIELD_ISSUED_AT;
+        }
+
+        if (target != nullptr && *c.p == '"') {
+            if (!scanString(c, target)) {
+                return false;
+            }
+            fields.found |= bit;
+        } else if (bit == CMD_FIELD_ISSUED_AT && (*c.p == '-' || isDigit(*c.p))) {
+            if (!scanNumber(c, &fields.issuedAt)) {
+                return false;
+            }
+            fields.found |= bit;
+        } else {
+            if (!skipValue(c)) {
+                return false;
+            }
+            fields.found &= ~bit;
+        }
+
+        skipWhitespace(c);
+        if (c.p >= c.end) {
+            return false;
+        }
+        if (*c.p == ',') {
+            c.p++;
+            continue;
+        }
+        if (*c.p == '}') {
+            return true;  // Anything after the object is ignored
+        }
+        return false;
+    }
+}
+
+bool Protocol::parseCommand(const char* json, size_t len, CommandResult& result) {
+    result = CommandResult();
+
+    CommandFields fields;
+    bool wellFormed = tokenizeCommand(json, len, fields);
+
+    // Keep the requestId even when the rest is bad, for the BAD_PAYLOAD ACK
+    if (fields.found & CMD_FIELD_REQUEST_ID) {
+        copySpan(fields.requestId, result.requestId, sizeof(result.requestId));
+    }
+
+    if (!wellFormed) {
+        LOG(PROTOCOL_JSON_ERROR);
+        return false;
+    }
+
+    // Validate required fields
+    if (!(fields.found & CMD_FIELD_REQUEST_ID)) {
+        LOG(PROTOCOL_BAD_REQUEST_ID);
+        return false;
+    }
+
+    if (!(fields.found & CMD_FIELD_COMMAND)) {
+        LOG(PROTOCOL_BAD_COMMAND);
+        return false;
+    }
+
+    if (!(fields.found & CMD_FIELD_USER_ID)) {
+        LOG(PROTOCOL_BAD_USER_ID);
+        return false;
+    }
+
+    if (!(fields.found & CMD_FIELD_ISSUED_AT)) {
+        LOG(PROTOCOL_BAD_ISSUED_AT);
+        return false;
+    }
+
+    // Copy fields
+    copySpan(fields.command, result.command, sizeof(result.command));
+    copySpan(fields.userId, result.userId, sizeof(result.userId));
+    result.issuedAt = fields.issuedAt;
     result.valid = true;
 
     return true;
 }
 
-void Protocol::createAck(const char* requestId, bool ok, const char* errorCode,
-                        char* output, size_t outputSize) {
-    StaticJsonDocument<256> doc;
-    doc["requestId"] = requestId;
-    doc["ok"] = ok;
+bool Protocol::parseCommand(const char* json, CommandResult& result) {
+    return parseCommand(json, json != nullptr ? strlen(json) : 0, result);
+}
+
+// Binary ACK status byte: 0 = ok, otherwise index + 1 into this table
+static const char* const BIN_ERROR_CODES[] = {
+    "BAD_PAYLOAD", "UNKNOWN_COMMAND", "COOLDOWN", "RELAY_FAIL"
+};
+#define BIN_STATUS_OK 0x00
+#define BIN_STATUS_OTHER 0xFF
+
+// Read an unsigned LEB128 varint (max 10 bytes)
+static bool readVarint(const uint8_t*& p, const uint8_t* end, unsigned long long& value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 70; shift += 7) {
+        if (p >= end) {
+            return false;
+        }
+        uint8_t b = *p++;
+        value |= (unsigned long long)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Unsigned LEB128; returns bytes written (at most 10)
+static size_t writeVarint(uint8_t* out, unsigned long long value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+// 16 raw bytes -> canonical 8-4-4-4-12 lowercase UUID text (out must hold 37 bytes)
+static void uuidToText(const uint8_t* bytes, char* out) {
+    static const char hex[] = "0123456789abcdef";
+    size_t o = 0;
+    for (uint8_t i = 0; i < PROTOCOL_BIN_UUID_LEN; i++) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            out[o++] = '-';
+        }
+        out[o++] = hex[bytes[i] >> 4];
+        out[o++] = hex[bytes[i] & 0x0F];
+    }
+    out[o] = '\0';
+}
+
+bool Protocol::parseUuid(const char* text, uint8_t* bytes) {
+    if (text == nullptr) {
+        return false;
+    }
+    uint8_t n = 0;
+    for (const char* p = text; *p; p++) {
+        if (*p == '-') {
+            continue;
+        }
+        if (!isHexDigit(*p) || n >= PROTOCOL_BIN_UUID_LEN * 2) {
+            return false;
+        }
+        uint8_t v = hexValue(*p);
+        if (n % 2 == 0) {
+            bytes[n / 2] = v << 4;
+        } else {
+            bytes[n / 2] |= v;
+        }
+        n++;
+    }
+    return n == PROTOCOL_BIN_UUID_LEN * 2;
+}
+
+bool Protocol::parseCommandBinary(const uint8_t* data, size_t len, CommandResult& result) {
+    result = CommandResult();
+    result.binary = true;
+
+    // requestId sits at a fixed offset in every version: recover it first for BAD_PAYLOAD
+    if (data == nullptr || len < 2 + PROTOCOL_BIN_UUID_LEN) {
+        LOG(PROTOCOL_BIN_TOO_SHORT);
+        return false;
+    }
+    uuidToText(data + 2, result.requestId);
+
+    if (data[0] != PROTOCOL_BIN_VERSION) {
+        LOG(PROTOCOL_BIN_VERSION, data[0]);
+        return false;
+    }
+
+    const uint8_t* p = data + 2 + PROTOCOL_BIN_UUID_LEN;
+    const uint8_t* end = data + len;
+    unsigned long long userIdLen = 0;
+    if (!readVarint(p, end, result.issuedAt)) {
+        LOG(PROTOCOL_BAD_ISSUED_AT);
+        return false;
+    }
+    if (!readVarint(p, end, userIdLen) || userIdLen == 0 || userIdLen > (unsigned long long)(end - p)) {
+        LOG(PROTOCOL_BAD_USER_ID);
+        return false;
+    }
+    size_t copyLen = userIdLen < sizeof(result.userId) ? (size_t)userIdLen : sizeof(result.userId) - 1;
+    memcpy(result.userId, p, copyLen);
+    result.userId[copyLen] = '\0';
+
+    // Unknown codes are passed through by number so the gate task answers UNKNOWN_COMMAND
+    if (data[1] == PROTOCOL_BIN_CMD_OPEN) {
+        strcpy(result.command, "open");
+    } else {
+        snprintf(result.command, sizeof(result.command), "0x%02x", data[1]);
+    }
+    result.valid = true;
+    return true;
+}
+
+size_t Protocol::createAckBinary(const char* requestId, bool ok, const char* errorCode,
+                                 uint8_t* output, size_t outputSize,
+                                 uint32_t retryAfterMs, unsigned long long scheduledAt) {
+    size_t needed = PROTOCOL_BIN_ACK_LEN + (retryAfterMs != 0 ? 1 + 5 : 0) + (scheduledAt != 0 ? 1 + 10 : 0);
+    if (output == nullptr || outputSize < needed) {
+        return 0;
+    }
+
+    output[0] = PROTOCOL_BIN_VERSION;
+    output[1] = BIN_STATUS_OK;
+    if (!ok) {
+        output[1] = BIN_STATUS_OTHER;
+        for (uint8_t i = 0; errorCode != nullptr && i < sizeof(BIN_ERROR_CODES) / sizeof(BIN_ERROR_CODES[0]); i++) {
+            if (strcmp(errorCode, BIN_ERROR_CODES[i]) == 0) {
+                output[1] = i + 1;
+                break;
+            }
+        }
+    }
+
+    // All-zero UUID when the command had no usable requestId
+    if (!parseUuid(requestId, output + 2)) {
+        memset(output + 2, 0, PROTOCOL_BIN_UUID_LEN);
+    }
+
+    size_t len = PROTOCOL_BIN_ACK_LEN;
+    if (retryAfterMs != 0) {
+        output[len++] = PROTOCOL_BIN_TAG_RETRY_AFTER;
+        len += writeVarint(output + len, retryAfterMs);
+    }
+    if (scheduledAt != 0) {
+        output[len++] = PROTOCOL_BIN_TAG_SCHEDULED_AT;
+        len += writeVarint(output + len, scheduledAt);
+    }
+    return len;
+}
+
+/**
+ * Bounded writer for the fixed ACK/status shapes. Skeleton pieces are string
+ * literals whose length is known at compile time; only field values are
+ * formatted. Output matches ArduinoJson's serializeJson byte for byte
+ * (same escaping, same truncation: at most size - 1 bytes, always terminated;
+ * checked by test/host/protocol_json.cpp).
+ */
+class JsonOut {
+public:
+    JsonOut(char* output, size_t outputSize)
+        : buf(output), size(outputSize), len(0) {}
+
+    template<size_t N>
+    void literal(const char (&text)[N]) {
+        raw(text, N - 1);
+    }
+
+    void string(const char* value) {
+        if (value == nullptr) {
+            literal("null");
+            return;
+        }
+        literal("\"");
+        for (const char* p = value; *p; p++) {
+            char escaped = escapeChar(*p);
+            if (escaped) {
+                char pair[2] = { '\\', escaped };
+                raw(pair, 2);
+            } else {
+                raw(p, 1);
+            }
+        }
+        literal("\"");
+    }
+
+    void boolean(bool value) {
+        if (value) {
+            literal("true");
+        } else {
+            literal("false");
+        }
+    }
+
+    void number(unsigned long value) {
+        number((unsigned long long)value);
+    }
+
+    void number(unsigned long long value) {
+        char digits[20];
+        uint8_t n = 0;
+        do {
+            digits[sizeof(digits) - 1 - n++] = '0' + (value % 10);
+            value /= 10;
+        } while (value != 0);
+        raw(digits + sizeof(digits) - n, n);
+    }
+
+    void number(int value) {
+        if (value < 0) {
+            literal("-");
+            number((unsigned long)(-(long)value));
+        } else {
+            number((unsigned long)value);
+        }
+    }
+
+    size_t finish() {
+        if (size > 0) {
+            buf[len] = '\0';
+        }
+        return len;
+    }
+
+private:
+    // Same escape set as ArduinoJson (other control characters are written as-is)
+    static char escapeChar(char c) {
+        switch (c) {
+            case '"': return '"';
+            case '\\': return '\\';
+            case '\b': return 'b';
+            case '\f': return 'f';
+            case '\n': return 'n';
+            case '\r': return 'r';
+            case '\t': return 't';
+            default: return 0;
+        }
+    }
+
+    void raw(const char* data, size_t n) {
+        if (size == 0) {
+            return;
+        }
+        size_t room = size - 1 - len;
+        if (n > room) {
+            n = room;
+        }
+        memcpy(buf + len, data, n);
+        len += n;
+    }
+
+    char* buf;
+    size_t size;
+    size_t len;
+};
+
+size_t Protocol::createAck(const char* requestId, bool ok, const char* errorCode,
+                           char* output, size_t outputSize,
+                           uint32_t retryAfterMs, unsigned long long scheduledAt) {
+    JsonOut out(output, outputSize);
+    out.literal("{\"requestId\":");
+    out.string(requestId);
+    out.literal(",\"ok\":");
+    out.boolean(ok);
 
     if (!ok && errorCode != nullptr) {
-        doc["errorCode"] = errorCode;
+        out.literal(",\"errorCode\":");
+        out.string(errorCode);
+    }
+
+    if (retryAfterMs != 0) {
+        out.literal(",\"retryAfterMs\":");
+        out.number((unsigned long)retryAfterMs);
     }
 
-    serializeJson(doc, output, outputSize);
+    if (scheduledAt != 0) {
+        out.literal(",\"scheduledAt\":");
+        out.number(scheduledAt);
+    }
+
+    out.literal("}");
+    return out.finish();
 }
 
-void Protocol::createStatus(const char* deviceId, bool online, unsigned long updatedAt,
-                          int rssi, const char* fwVersion, char* output, size_t outputSize) {
-    StaticJsonDocument<256> doc;
-    doc["deviceId"] = deviceId;
-    doc["online"] = online;
-    doc["updatedAt"] = updatedAt;
+size_t Protocol::createStatus(const char* deviceId, bool online, unsigned long updatedAt,
+                              int rssi, const char* fwVersion, char* output, size_t outputSize,
+                              long errors, long outboxDepth, long outboxAgeMs) {
+    JsonOut out(output, outputSize);
+    out.literal("{\"deviceId\":");
+    out.string(deviceId);
+    out.literal(",\"online\":");
+    out.boolean(online);
+    out.literal(",\"updatedAt\":");
+    out.number(updatedAt);
 
     if (rssi != 0) {
-        doc["rssi"] = rssi;
+        out.literal(",\"rssi\":");
+        out.number(rssi);
     }
 
     if (fwVersion != nullptr) {
-        doc["fwVersion"] = fwVersion;
+        out.literal(",\"fwVersion\":");
+        out.string(fwVersion);
     }
 
-    serializeJson(doc, output, outputSize);
-}
+    if (errors >= 0) {
+        out.literal(",\"errors\":");
+        out.number((unsigned long)errors);
+    }
 
+    if (outboxDepth >= 0) {
+        out.literal(",\"outboxDepth\":");
+        out.number((unsigned long)outboxDepth);
+    }
+
+    if (outboxAgeMs >= 0) {
+        out.literal(",\"outboxAgeMs\":");
+        out.number((unsigned long)outboxAgeMs);
+    }
+
+    out.literal("}");
+    return out.finish();
+}
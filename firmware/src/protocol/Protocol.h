@@ -2,6 +2,9 @@
 #define PROTOCOL_H
 
 #include <Arduino.h>
+#include "config/config.h"
+#include "util/SpscRing.h"
+#include "util/SlotPool.h"
 
 /**
  * Command parsing result structure.
@@ -12,38 +15,156 @@ struct CommandResult {
     char userId[64];
     unsigned long long issuedAt;  // Use long long for large timestamps (milliseconds)
     bool valid;
+    bool binary;             // arrived as a binary frame; ACK in binary too
 
-    CommandResult() : valid(false), issuedAt(0) {
+    CommandResult() : valid(false), binary(false), issuedAt(0) {
         requestId[0] = '\0';
         command[0] = '\0';
         userId[0] = '\0';
     }
 };
 
+/**
+ * Slice of a caller-owned buffer (not null-terminated; may contain JSON escapes).
+ */
+struct Span {
+    const char* ptr;
+    uint16_t len;
+
+    Span() : ptr(nullptr), len(0) {}
+};
+
+// Field presence bits for CommandFields::found
+#define CMD_FIELD_REQUEST_ID 0x01
+#define CMD_FIELD_COMMAND    0x02
+#define CMD_FIELD_USER_ID    0x04
+#define CMD_FIELD_ISSUED_AT  0x08
+#define CMD_FIELD_ALL        0x0F
+
+/**
+ * Command fields located by the tokenizer, as spans over the payload.
+ * found has a CMD_FIELD_* bit set for each field seen with the right type.
+ */
+struct CommandFields {
+    Span requestId;
+    Span command;
+    Span userId;
+    unsigned long long issuedAt;
+    uint8_t found;
+
+    CommandFields() : issuedAt(0), found(0) {}
+};
+
+/**
+ * ACK to be published for a processed command.
+ * errorCode must point to a string literal (it crosses tasks by pointer).
+ * retryAfterMs / scheduledAt are optional hints (0 = not sent).
+ */
+struct AckRequest {
+    char requestId[37];
+    bool ok;
+    bool binary;
+    const char* errorCode;
+    uint32_t retryAfterMs;          // COOLDOWN: when a retry would be accepted
+    unsigned long long scheduledAt; // ok but deferred: estimated open time (ms, sender's clock)
+
+    AckRequest() : ok(false), binary(false), errorCode(nullptr), retryAfterMs(0), scheduledAt(0) {
+        requestId[0] = '\0';
+    }
+};
+
+// Binary framing (version byte first; requestId always at bytes 2..17)
+#define PROTOCOL_BIN_VERSION 0x01
+#define PROTOCOL_BIN_UUID_LEN 16
+#define PROTOCOL_BIN_ACK_LEN (2 + PROTOCOL_BIN_UUID_LEN)
+// Optional ACK trailer fields: tag byte + unsigned LEB128 varint
+#define PROTOCOL_BIN_TAG_RETRY_AFTER 0x01
+#define PROTOCOL_BIN_TAG_SCHEDULED_AT 0x02
+#define PROTOCOL_BIN_ACK_MAX_LEN (PROTOCOL_BIN_ACK_LEN + 1 + 5 + 1 + 10)
+#define PROTOCOL_BIN_CMD_OPEN 0x01
+
+/**
+ * Raw command payload as received from the broker, held in an RxPool slot
+ * until the gate task has parsed it.
+ */
+struct RxMessage {
+    uint16_t len;
+    bool binary;  // arrived on the binary command topic
+    uint8_t data[MQTT_RX_MAX_PAYLOAD];
+};
+
+typedef SlotPool<RxMessage, MQTT_RX_POOL_SLOTS> RxPool;
+
+// Network task -> gate task: RxPool slot indices (the gate task parses and releases them)
+typedef SpscRing<int8_t, GATE_COMMAND_QUEUE_LEN> CommandRing;
+// Gate task -> network task: ACKs to publish
+typedef SpscRing<AckRequest, GATE_ACK_QUEUE_LEN> AckRing;
+
 /**
  * Protocol handler for MQTT command parsing and ACK generation.
  */
 class Protocol {
 public:
     /**
-     * Parse incoming command JSON message.
+     * Parse incoming command JSON message (len bytes, need not be null-terminated).
      * Returns true if parsing successful and all required fields present.
+     * On failure result.valid is false but result.requestId is still filled in
+     * if it was found, so a BAD_PAYLOAD ACK can reference it.
+     */
+    static bool parseCommand(const char* json, size_t len, CommandResult& result);
+
+    /**
+     * Parse a null-terminated command JSON message.
      */
     static bool parseCommand(const char* json, CommandResult& result);
 
     /**
-     * Create ACK JSON message.
+     * Single-pass tokenizer for the command schema: one scan over the payload,
+     * no allocation, unknown keys skipped. Fields found before an error are
+     * kept in fields. Returns true if the payload is a well-formed JSON object.
+     */
+    static bool tokenizeCommand(const char* json, size_t len, CommandFields& fields);
+
+    /**
+     * Parse a binary command frame (see docs/mqtt-protocol.md).
+     * Same contract as parseCommand: requestId is filled in on failure if present.
+     */
+    static bool parseCommandBinary(const uint8_t* data, size_t len, CommandResult& result);
+
+    /**
+     * Create binary ACK frame (PROTOCOL_BIN_ACK_LEN bytes, plus a trailer field
+     * for each non-zero hint; at most PROTOCOL_BIN_ACK_MAX_LEN).
+     * Returns the frame length, or 0 if outputSize is too small.
+     */
+    static size_t createAckBinary(const char* requestId, bool ok, const char* errorCode,
+                                  uint8_t* output, size_t outputSize,
+                                  uint32_t retryAfterMs = 0, unsigned long long scheduledAt = 0);
+
+    /**
+     * Convert UUID text (dashes optional) to its 16 raw bytes.
+     * Returns false unless text is exactly 32 hex digits.
+     */
+    static bool parseUuid(const char* text, uint8_t* bytes);
+
+    /**
+     * Create ACK JSON message (retryAfterMs / scheduledAt are added when non-zero).
      * Output is written to output buffer (must be at least outputSize bytes).
+     * Returns the JSON length (truncated to outputSize - 1 if the buffer is too small).
      */
-    static void createAck(const char* requestId, bool ok, const char* errorCode,
-                         char* output, size_t outputSize);
+    static size_t createAck(const char* requestId, bool ok, const char* errorCode,
+                            char* output, size_t outputSize,
+                            uint32_t retryAfterMs = 0, unsigned long long scheduledAt = 0);
 
     /**
      * Create status JSON message.
+     * rssi 0, fwVersion nullptr and negative errors/outbox values are left out
+     * (deltas and heartbeats).
      * Output is written to output buffer (must be at least outputSize bytes).
+     * Returns the JSON length (truncated to outputSize - 1 if the buffer is too small).
      */
-    static void createStatus(const char* deviceId, bool online, unsigned long updatedAt,
-                           int rssi, const char* fwVersion, char* output, size_t outputSize);
+    static size_t createStatus(const char* deviceId, bool online, unsigned long updatedAt,
+                               int rssi, const char* fwVersion, char* output, size_t outputSize,
+                               long errors = -1, long outboxDepth = -1, long outboxAgeMs = -1);
 };
 
 #endif // PROTOCOL_H
@@ -1,26 +1,72 @@
 #include "relay.h"
+#include "util/Log.h"
+
+esp_timer_handle_t Relay::pulseTimer = nullptr;
+volatile bool Relay::active = false;
+volatile uint32_t Relay::pulseStartedAtMs = 0;
+Relay::PulseCompleteCallback Relay::pulseCompleteCallback = nullptr;
 
 void Relay::init() {
     pinMode(RELAY_PIN, OUTPUT);
     digitalWrite(RELAY_PIN, LOW);
-    Serial.print("[Relay] Initialized GPIO ");
-    Serial.print(RELAY_PIN);
-    Serial.println(" (LOW - safe state)");
+    active = false;
+
+    if (pulseTimer == nullptr) {
+        esp_timer_create_args_t args = {};
+        args.callback = &Relay::onPulseTimer;
+        args.arg = nullptr;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "relay_pulse";
+        if (esp_timer_create(&args, &pulseTimer) != ESP_OK) {
+            pulseTimer = nullptr;
+            LOG(RELAY_TIMER_CREATE_FAILED);
+        }
+    }
+
+    LOG(RELAY_INITIALIZED, RELAY_PIN);
 }
 
 bool Relay::activatePulse() {
-    Serial.print("[Relay] Activating pulse on GPIO ");
-    Serial.print(RELAY_PIN);
-    Serial.print(" for ");
-    Serial.print(RELAY_PULSE_MS);
-    Serial.println("ms");
+    if (pulseTimer == nullptr) {
+        LOG(RELAY_TIMER_UNAVAILABLE);
+        return false;
+    }
+    if (active) {
+        LOG(RELAY_PULSE_BUSY);
+        return false;
+    }
 
+    LOG(RELAY_PULSE_START, RELAY_PIN, RELAY_PULSE_MS);
+
+    pulseStartedAtMs = millis();
+    active = true;
     digitalWrite(RELAY_PIN, HIGH);
-    delay(RELAY_PULSE_MS);
-    digitalWrite(RELAY_PIN, LOW);
 
-    Serial.println("[Relay] Pulse completed, pin set to LOW");
+    if (esp_timer_start_once(pulseTimer, (uint64_t)RELAY_PULSE_MS * 1000ULL) != ESP_OK) {
+        // Never leave the relay energized without a timer to release it
+        digitalWrite(RELAY_PIN, LOW);
+        active = false;
+        LOG(RELAY_TIMER_ARM_FAILED);
+        return false;
+    }
 
     return true;
 }
 
+bool Relay::isActive() {
+    return active;
+}
+
+void Relay::setPulseCompleteCallback(PulseCompleteCallback callback) {
+    pulseCompleteCallback = callback;
+}
+
+void Relay::onPulseTimer(void* arg) {
+    (void)arg;
+    digitalWrite(RELAY_PIN, LOW);
+    active = false;
+
+    if (pulseCompleteCallback != nullptr) {
+        pulseCompleteCallback(pulseStartedAtMs, millis());
+    }
+}
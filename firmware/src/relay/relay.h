@@ -2,29 +2,58 @@
 #define RELAY_H
 
 #include <Arduino.h>
+#include <stdint.h>
+#include "esp_timer.h"
 #include "config/config.h"
 
 /**
  * Relay control module for gate actuator.
  * Controls GPIO pin for relay pulse activation.
+ *
+ * The pulse is timer-driven: activatePulse() energizes the pin and returns
+ * immediately; an esp_timer one-shot de-energizes it after RELAY_PULSE_MS.
  */
 class Relay {
 public:
     /**
-     * Initialize relay GPIO pin.
+     * Pulse completion callback.
+     * Runs in esp_timer task context - keep it short and non-blocking.
+     */
+    typedef void (*PulseCompleteCallback)(uint32_t startedAtMs, uint32_t endedAtMs);
+
+    /**
+     * Initialize relay GPIO pin and pulse timer.
      * Sets pin as OUTPUT and ensures it starts LOW (safe state).
      */
     static void init();
 
     /**
      * Activate relay pulse.
-     * Sets pin HIGH for RELAY_PULSE_MS, then sets LOW.
-     * This is a blocking operation.
+     * Sets pin HIGH and arms the pulse timer, which sets it LOW after
+     * RELAY_PULSE_MS. Non-blocking.
      *
-     * @return true if pulse completed successfully
+     * @return true if pulse was started, false if the timer is unavailable
+     *         or a pulse is already in progress
      */
     static bool activatePulse();
+
+    /**
+     * Check if a pulse is currently in progress (pin HIGH).
+     */
+    static bool isActive();
+
+    /**
+     * Set callback invoked when a pulse completes (pin back LOW).
+     */
+    static void setPulseCompleteCallback(PulseCompleteCallback callback);
+
+private:
+    static void onPulseTimer(void* arg);
+
+    static esp_timer_handle_t pulseTimer;
+    static volatile bool active;
+    static volatile uint32_t pulseStartedAtMs;
+    static PulseCompleteCallback pulseCompleteCallback;
 };
 
 #endif // RELAY_H
-
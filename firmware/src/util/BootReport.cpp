@@ -0,0 +1,74 @@
+#include "BootReport.h"
+#include <stdio.h>
+#include "esp_system.h"
+#include "WarmBoot.h"
+#include "Log.h"
+
+uint32_t BootReport::phaseMs[BOOT_PHASE_COUNT] = {0};
+bool BootReport::published = false;
+
+void BootReport::mark(BootPhase phase) {
+    if (phase >= BOOT_PHASE_COUNT || phaseMs[phase] != 0) {
+        return;
+    }
+    uint32_t now = millis();
+    phaseMs[phase] = now > 0 ? now : 1;  // 0 means "not reached"
+
+    LOG(BOOT_PHASE, phaseName(phase), (unsigned long)phaseMs[phase]);
+}
+
+uint32_t BootReport::getPhaseMs(BootPhase phase) {
+    if (phase >= BOOT_PHASE_COUNT) {
+        return 0;
+    }
+    return phaseMs[phase];
+}
+
+bool BootReport::isPublished() {
+    return published;
+}
+
+void BootReport::setPublished() {
+    published = true;
+}
+
+void BootReport::toJson(char* output, size_t outputSize) {
+    if (output == nullptr || outputSize == 0) {
+        return;
+    }
+
+    int len = snprintf(output, outputSize,
+                       "{\"deviceId\":\"%s\",\"fwVersion\":\"%s\",\"resetReason\":%d,\"warmBoot\":%s,\"phases\":{",
+                       DEVICE_ID, FW_VERSION, (int)esp_reset_reason(),
+                       WarmBoot::isWarmBoot() ? "true" : "false");
+    bool first = true;
+    for (uint8_t i = 0; i < BOOT_PHASE_COUNT && len > 0 && (size_t)len < outputSize; i++) {
+        if (phaseMs[i] == 0) {
+            continue;
+        }
+        len += snprintf(output + len, outputSize - len, "%s\"%s\":%lu",
+                        first ? "" : ",", phaseName((BootPhase)i), (unsigned long)phaseMs[i]);
+        first = false;
+    }
+    if (len > 0 && (size_t)len < outputSize) {
+        snprintf(output + len, outputSize - len, "}}");
+    }
+}
+
+const char* BootReport::phaseName(BootPhase phase) {
+    switch (phase) {
+        case BOOT_PHASE_SETUP_DONE: return "setup";
+        case BOOT_PHASE_UART_READY: return "uart";
+        case BOOT_PHASE_MODEM_POWER_ON: return "modemPowerOn";
+        case BOOT_PHASE_MODEM_RDY: return "modemRdy";
+        case BOOT_PHASE_SIM_READY: return "simReady";
+        case BOOT_PHASE_MODEM_AT_OK: return "atOk";
+        case BOOT_PHASE_MODEM_READY: return "modemReady";
+        case BOOT_PHASE_NET_REGISTERED: return "registered";
+        case BOOT_PHASE_PDP_ACTIVE: return "pdpActive";
+        case BOOT_PHASE_IP_ASSIGNED: return "ipAssigned";
+        case BOOT_PHASE_MQTT_CONNECTED: return "mqttConnected";
+        case BOOT_PHASE_MQTT_SUBSCRIBED: return "mqttSubscribed";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef BOOT_REPORT_H
+#define BOOT_REPORT_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "config/config.h"
+
+// Boot phases, in the order they normally complete
+enum BootPhase : uint8_t {
+    BOOT_PHASE_SETUP_DONE = 0,
+    BOOT_PHASE_UART_READY,
+    BOOT_PHASE_MODEM_POWER_ON,
+    BOOT_PHASE_MODEM_RDY,
+    BOOT_PHASE_SIM_READY,
+    BOOT_PHASE_MODEM_AT_OK,
+    BOOT_PHASE_MODEM_READY,
+    BOOT_PHASE_NET_REGISTERED,
+    BOOT_PHASE_PDP_ACTIVE,
+    BOOT_PHASE_IP_ASSIGNED,
+    BOOT_PHASE_MQTT_CONNECTED,
+    BOOT_PHASE_MQTT_SUBSCRIBED,
+    BOOT_PHASE_COUNT
+};
+
+/**
+ * Boot-phase timing report. Each phase is timestamped (millis since power-on)
+ * the first time it is reached; the report is published once on first connect.
+ * Only used from setup() and the network task.
+ */
+class BootReport {
+public:
+    /**
+     * Record that a phase was reached (first occurrence per boot wins).
+     */
+    static void mark(BootPhase phase);
+
+    /**
+     * Time the phase was reached, or 0 if not reached yet.
+     */
+    static uint32_t getPhaseMs(BootPhase phase);
+
+    /**
+     * True once the report was published (publish only once per boot).
+     */
+    static bool isPublished();
+
+    static void setPublished();
+
+    /**
+     * Create boot report JSON message.
+     * Output is written to output buffer (must be at least outputSize bytes).
+     */
+    static void toJson(char* output, size_t outputSize);
+
+private:
+    static const char* phaseName(BootPhase phase);
+
+    static uint32_t phaseMs[BOOT_PHASE_COUNT];
+    static bool published;
+};
+
+#endif // BOOT_REPORT_H
@@ -0,0 +1,27 @@
+#ifndef DIAGNOSTIC_EVENTS_H
+#define DIAGNOSTIC_EVENTS_H
+
+/**
+ * Event dictionary for the diagnostic log: X(NAME, level, "event", "message").
+ * Entries are stored as the position in this list plus numeric arguments; the
+ * upload expands them back to the event name and the message, where %d
+ * (signed) and %u (unsigned) take the arguments in order (at most
+ * DIAG_MAX_ARGS). Several entries may share an event name.
+ *
+ * IDs persist in NVS across firmware updates: append new events at the end,
+ * never reorder or remove entries.
+ */
+#define DIAG_EVENTS(X) \
+    X(OOB_REBOOT, Warn, "oob_reboot", "") \
+    X(OOB_PPP_REBUILD, Warn, "oob_ppp_rebuild", "") \
+    X(INIT_RETRY, Warn, "init_retry", "retry=%u") \
+    X(BACKOFF, Warn, "backoff", "backoff=%u") \
+    X(MODEM_RESET, Warn, "modem_reset", "n=%d") \
+    X(MQTT_STUCK, Warn, "mqtt_stuck", "ms=%u") \
+    X(PPP_REBUILD_MQTT_STUCK, Warn, "ppp_rebuild", "reason=mqtt_stuck") \
+    X(PPP_REBUILD, Warn, "ppp_rebuild", "n=%d") \
+    X(CONNECTION_RESTORED, Info, "connection_restored", "") \
+    X(CONNECTION_LOST, Warn, "connection_lost", "") \
+    X(RELAY_FAIL, Error, "relay_fail", "n=%u")
+
+#endif // DIAGNOSTIC_EVENTS_H
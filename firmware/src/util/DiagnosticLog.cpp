@@ -4,113 +4,459 @@
 
 #include <Preferences.h>
 #include <cstring>
+#include <cstdlib>
+
+static_assert(DIAG_EVENT_COUNT <= 255, "Diagnostic event ID must fit in one byte");
+static_assert(DIAG_BLOCK_BYTES <= 255, "Block fill must fit in one byte");
 
 const char* DiagnosticLog::NVS_NAMESPACE = "pgr_diag";
-const char* DiagnosticLog::NVS_KEY_COUNT = "cnt";
-const char* DiagnosticLog::NVS_KEY_DATA = "buf";
+const char* DiagnosticLog::NVS_KEY_HEAD = "bhead";
+const char* DiagnosticLog::NVS_KEY_TAIL = "etail";
+
+// Largest encoded record: ID, timestamp delta, arguments (5-byte varints)
+#define DIAG_RECORD_MAX_LEN (1 + 5 + 5 * DIAG_MAX_ARGS)
+
+struct DiagnosticEventInfo {
+    uint8_t level;
+    const char* event;
+    const char* message;
+};
+
+static const DiagnosticEventInfo EVENTS[] = {
+#define DIAG_EVENT_INFO(name, level, event, message) \
+    { static_cast<uint8_t>(DiagnosticLevel::level), event, message },
+    DIAG_EVENTS(DIAG_EVENT_INFO)
+#undef DIAG_EVENT_INFO
+};
+
+// Pre-compact layouts: string entries, imported once on load
+#define LEGACY_SLOTS 32
+#define LEGACY_EVENT_LEN 20
+#define LEGACY_MESSAGE_LEN 32
+
+struct LegacyEntry {
+    uint32_t ts;
+    uint8_t level;
+    char event[LEGACY_EVENT_LEN];
+    char message[LEGACY_MESSAGE_LEN];
+};
+
+struct LegacyJournalRecord {
+    uint32_t seq;
+    LegacyEntry entry;
+};
+
+static const char* NVS_KEY_LEGACY_HEAD = "head";
+static const char* NVS_KEY_LEGACY_TAIL = "tail";
+static const char* NVS_KEY_LEGACY_COUNT = "cnt";
+static const char* NVS_KEY_LEGACY_DATA = "buf";
+
+// %d or %u: one argument (at most DIAG_MAX_ARGS per message)
+static bool isField(const char* p) {
+    return p[0] == '%' && (p[1] == 'd' || p[1] == 'u');
+}
+
+static uint8_t putVarint(uint8_t* out, uint32_t value) {
+    uint8_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static bool getVarint(const uint8_t* data, uint8_t len, uint8_t& pos, uint32_t& value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 35 && pos < len; shift += 7) {
+        uint8_t b = data[pos++];
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/**
+ * Expand message with args for its %d/%u fields.
+ */
+static void formatMessage(const char* format, const uint32_t* args, char* out, size_t outLen) {
+    size_t n = 0;
+    uint8_t arg = 0;
+    for (const char* p = format; *p && n + 1 < outLen; p++) {
+        if (isField(p) && arg < DIAG_MAX_ARGS) {
+            char num[12];
+            if (p[1] == 'd') {
+                snprintf(num, sizeof(num), "%ld", (long)(int32_t)args[arg]);
+            } else {
+                snprintf(num, sizeof(num), "%lu", (unsigned long)args[arg]);
+            }
+            arg++;
+            p++;
+            for (const char* q = num; *q && n + 1 < outLen; q++) {
+                out[n++] = *q;
+            }
+        } else {
+            out[n++] = *p;
+        }
+    }
+    out[n] = '\0';
+}
+
+/**
+ * Inverse of formatMessage, for importing legacy string entries.
+ */
+static bool parseMessage(const char* format, const char* message, uint32_t* args) {
+    const char* m = message;
+    uint8_t arg = 0;
+    for (const char* p = format; *p; p++) {
+        if (isField(p) && arg < DIAG_MAX_ARGS) {
+            char* end;
+            long v = strtol(m, &end, 10);
+            if (end == m) {
+                return false;
+            }
+            args[arg++] = (uint32_t)v;
+            m = end;
+            p++;
+        } else if (*m++ != *p) {
+            return false;
+        }
+    }
+    return *m == '\0';
+}
 
 DiagnosticLog::DiagnosticLog()
-    : count_(0), head_(0) {
-    memset(entries_, 0, sizeof(entries_));
+    : headBlock_(0), tailBlock_(0), tailSeq_(0), committedSeq_(0),
+      savedHeadBlock_(0), savedTailSeq_(0), firstPendingAt_(0) {
+    memset(blocks_, 0, sizeof(blocks_));
     load();
 }
 
-void DiagnosticLog::append(DiagnosticLevel level, const char* event, const char* message) {
-    if (event == nullptr) return;
+void DiagnosticLog::appendAt(uint32_t ts, uint8_t id, const uint32_t* args, uint8_t argc) {
+    if (id >= DIAG_EVENT_COUNT) return;
 
-    DiagnosticEntry e;
-    e.ts = millis();
-    e.level = static_cast<uint8_t>(level);
-    strncpy(e.event, event, DIAG_EVENT_LEN - 1);
-    e.event[DIAG_EVENT_LEN - 1] = '\0';
-    if (message != nullptr) {
-        strncpy(e.message, message, DIAG_MESSAGE_LEN - 1);
-        e.message[DIAG_MESSAGE_LEN - 1] = '\0';
-    } else {
-        e.message[0] = '\0';
+    Block* b = &blocks_[headBlock_ % DIAG_BLOCK_COUNT];
+    if (b->count == 255 || b->used + DIAG_RECORD_MAX_LEN > DIAG_BLOCK_BYTES) {
+        openBlock(ts);
+        b = &blocks_[headBlock_ % DIAG_BLOCK_COUNT];
+    }
+    if (b->count == 0) {
+        b->baseTs = ts;
+    }
+
+    // Timestamp relative to the previous record (signed: millis() restarts on reboot)
+    uint32_t prevTs = b->baseTs;
+    if (b->count > 0) {
+        uint8_t lastId;
+        uint32_t lastArgs[DIAG_MAX_ARGS];
+        decode(b->firstEntry + b->count - 1, &prevTs, &lastId, lastArgs);
+    }
+
+    uint8_t* out = b->data + b->used;
+    uint8_t n = 0;
+    out[n++] = id;
+    n += putVarint(out + n, zigzag((int32_t)(ts - prevTs)));
+    uint8_t arg = 0;
+    for (const char* p = EVENTS[id].message; *p; p++) {
+        if (isField(p) && arg < DIAG_MAX_ARGS) {
+            uint32_t v = arg < argc ? args[arg] : 0;
+            n += putVarint(out + n, p[1] == 'd' ? zigzag((int32_t)v) : v);
+            arg++;
+            p++;
+        }
+    }
+    b->used += n;
+
+    if (headSeq() == committedSeq_) {
+        firstPendingAt_ = millis();
+    }
+    b->count++;
+
+    if (headSeq() - committedSeq_ >= DIAG_COMMIT_BATCH) {
+        commit();
+    }
+}
+
+void DiagnosticLog::openBlock(uint32_t ts) {
+    uint32_t firstEntry = headSeq();
+    if (headBlock_ + 1 - tailBlock_ >= DIAG_BLOCK_COUNT) {
+        // Ring full: the oldest block is overwritten
+        tailBlock_++;
+        const Block& oldest = blocks_[tailBlock_ % DIAG_BLOCK_COUNT];
+        if ((int32_t)(oldest.firstEntry - tailSeq_) > 0) {
+            tailSeq_ = oldest.firstEntry;
+        }
+    }
+    headBlock_++;
+    Block& b = blocks_[headBlock_ % DIAG_BLOCK_COUNT];
+    b.seq = headBlock_;
+    b.firstEntry = firstEntry;
+    b.baseTs = ts;
+    b.count = 0;
+    b.used = 0;
+}
+
+uint32_t DiagnosticLog::headSeq() const {
+    const Block& b = blocks_[headBlock_ % DIAG_BLOCK_COUNT];
+    return b.firstEntry + b.count;
+}
+
+bool DiagnosticLog::decode(uint32_t seq, uint32_t* outTs, uint8_t* outId, uint32_t* outArgs) const {
+    for (uint32_t s = tailBlock_; s != headBlock_ + 1; s++) {
+        const Block& b = blocks_[s % DIAG_BLOCK_COUNT];
+        if (seq - b.firstEntry >= b.count) {
+            continue;
+        }
+        uint32_t ts = b.baseTs;
+        uint8_t pos = 0;
+        for (uint32_t i = 0; i <= seq - b.firstEntry; i++) {
+            if (pos >= b.used) return false;
+            uint8_t id = b.data[pos++];
+            if (id >= DIAG_EVENT_COUNT) return false;
+            uint32_t delta;
+            if (!getVarint(b.data, b.used, pos, delta)) return false;
+            ts += (uint32_t)unzigzag(delta);
+            uint8_t arg = 0;
+            for (const char* p = EVENTS[id].message; *p; p++) {
+                if (isField(p) && arg < DIAG_MAX_ARGS) {
+                    uint32_t v;
+                    if (!getVarint(b.data, b.used, pos, v)) return false;
+                    outArgs[arg++] = p[1] == 'd' ? (uint32_t)unzigzag(v) : v;
+                    p++;
+                }
+            }
+            *outId = id;
+        }
+        *outTs = ts;
+        return true;
     }
+    return false;
+}
 
-    entries_[head_] = e;
-    head_ = (head_ + 1) % DIAGNOSTIC_LOG_MAX_ENTRIES;
-    if (count_ < DIAGNOSTIC_LOG_MAX_ENTRIES) {
-        count_++;
+void DiagnosticLog::commit() {
+    uint32_t head = headSeq();
+    if (committedSeq_ == head && savedHeadBlock_ == headBlock_ && savedTailSeq_ == tailSeq_) {
+        return;
+    }
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) return;
+
+    // Blocks first, then head: a reset in between leaves a new block outside [tail, head]
+    for (uint32_t s = tailBlock_; s != headBlock_ + 1; s++) {
+        const Block& b = blocks_[s % DIAG_BLOCK_COUNT];
+        if (b.count == 0 || (int32_t)(b.firstEntry + b.count - committedSeq_) <= 0) {
+            continue;  // empty, or every record already written
+        }
+        char key[8];
+        blockKey(s, key);
+        prefs.putBytes(key, &b, offsetof(Block, data) + b.used);
+    }
+    committedSeq_ = head;
+    if (savedHeadBlock_ != headBlock_) {
+        prefs.putUInt(NVS_KEY_HEAD, headBlock_);
+        savedHeadBlock_ = headBlock_;
+    }
+    if (savedTailSeq_ != tailSeq_) {
+        prefs.putUInt(NVS_KEY_TAIL, tailSeq_);
+        savedTailSeq_ = tailSeq_;
+    }
+    prefs.end();
+}
+
+void DiagnosticLog::commitIfDue(unsigned long nowMs) {
+    if (committedSeq_ != headSeq() && nowMs - firstPendingAt_ >= DIAG_COMMIT_INTERVAL_MS) {
+        commit();
     }
-    save();
 }
 
 size_t DiagnosticLog::getEntryCount() const {
-    return count_;
+    return headSeq() - tailSeq_;
 }
 
 bool DiagnosticLog::getEntry(size_t index, uint32_t* outTs, uint8_t* outLevel,
                              char* outEvent, size_t eventLen,
                              char* outMessage, size_t messageLen) const {
-    if (index >= count_ || outTs == nullptr || outLevel == nullptr ||
+    if (index >= getEntryCount() || outTs == nullptr || outLevel == nullptr ||
         outEvent == nullptr || outMessage == nullptr) {
         return false;
     }
-    // Oldest is at (head_ - count_ + DIAGNOSTIC_LOG_MAX_ENTRIES) % DIAGNOSTIC_LOG_MAX_ENTRIES
-    size_t pos = (head_ + DIAGNOSTIC_LOG_MAX_ENTRIES - count_ + index) % DIAGNOSTIC_LOG_MAX_ENTRIES;
-    const DiagnosticEntry& e = entries_[pos];
-    *outTs = e.ts;
-    *outLevel = e.level;
-    strncpy(outEvent, e.event, eventLen - 1);
+    uint8_t id;
+    uint32_t args[DIAG_MAX_ARGS] = {0};
+    if (!decode(tailSeq_ + index, outTs, &id, args)) {
+        return false;
+    }
+    const DiagnosticEventInfo& info = EVENTS[id];
+    *outLevel = info.level;
+    strncpy(outEvent, info.event, eventLen - 1);
     outEvent[eventLen - 1] = '\0';
-    strncpy(outMessage, e.message, messageLen - 1);
-    outMessage[messageLen - 1] = '\0';
+    formatMessage(info.message, args, outMessage, messageLen);
     return true;
 }
 
 void DiagnosticLog::clear() {
-    count_ = 0;
-    head_ = 0;
-    memset(entries_, 0, sizeof(entries_));
-    save();
+    removeFirst(getEntryCount());
 }
 
 void DiagnosticLog::removeFirst(size_t n) {
-    if (n >= count_) {
-        clear();
+    if (n > getEntryCount()) {
+        n = getEntryCount();
+    }
+    if (n == 0) {
         return;
     }
-    count_ -= n;
-    save();
+    tailSeq_ += n;
+    while (tailBlock_ != headBlock_) {
+        const Block& b = blocks_[tailBlock_ % DIAG_BLOCK_COUNT];
+        if (tailSeq_ - b.firstEntry < b.count) {
+            break;
+        }
+        tailBlock_++;
+    }
+    // Pending entries go out with the new tail, so NVS never holds tail > head
+    commit();
+}
+
+uint32_t DiagnosticLog::getFirstSeq() const {
+    return tailSeq_;
+}
+
+void DiagnosticLog::removeBefore(uint32_t seq) {
+    int32_t n = (int32_t)(seq - tailSeq_);
+    if (n > 0) {
+        removeFirst((size_t)n);
+    }
 }
 
 bool DiagnosticLog::hasEntries() const {
-    return count_ > 0;
+    return headSeq() != tailSeq_;
 }
 
 void DiagnosticLog::load() {
     Preferences prefs;
     if (!prefs.begin(NVS_NAMESPACE, true)) return;
-    count_ = prefs.getUChar(NVS_KEY_COUNT, 0);
-    if (count_ > DIAGNOSTIC_LOG_MAX_ENTRIES) count_ = DIAGNOSTIC_LOG_MAX_ENTRIES;
-    if (count_ > 0) {
-        DiagnosticEntry tmp[DIAGNOSTIC_LOG_MAX_ENTRIES];
-        size_t len = count_ * sizeof(DiagnosticEntry);
-        prefs.getBytes(NVS_KEY_DATA, tmp, len);
-        for (size_t i = 0; i < count_; i++) {
-            entries_[i] = tmp[i];
+    bool legacy = prefs.isKey(NVS_KEY_LEGACY_HEAD) || prefs.isKey(NVS_KEY_LEGACY_DATA);
+    uint32_t head = prefs.getUInt(NVS_KEY_HEAD, 0);
+    uint32_t tail = prefs.getUInt(NVS_KEY_TAIL, 0);
+
+    // Keep the longest run of intact blocks ending at head
+    uint32_t s = head + 1;
+    while (head + 1 - s < DIAG_BLOCK_COUNT) {
+        Block& b = blocks_[(s - 1) % DIAG_BLOCK_COUNT];
+        char key[8];
+        blockKey(s - 1, key);
+        size_t len = prefs.getBytesLength(key);
+        if (len < offsetof(Block, data) || len > sizeof(Block) ||
+            prefs.getBytes(key, &b, len) != len || b.seq != s - 1 ||
+            b.used != len - offsetof(Block, data) ||
+            (s != head + 1 && b.firstEntry + b.count != blocks_[s % DIAG_BLOCK_COUNT].firstEntry)) {
+            break;
+        }
+        s--;
+    }
+
+    headBlock_ = head;
+    if (s == head + 1) {
+        // Head block missing: start empty, numbering entries on from the tail
+        Block& b = blocks_[head % DIAG_BLOCK_COUNT];
+        memset(&b, 0, sizeof(b));
+        b.seq = head;
+        b.firstEntry = tail;
+        tailBlock_ = head;
+        tailSeq_ = tail;
+    } else {
+        tailBlock_ = s;
+        const Block& oldest = blocks_[s % DIAG_BLOCK_COUNT];
+        tailSeq_ = tail - oldest.firstEntry <= headSeq() - oldest.firstEntry ? tail : oldest.firstEntry;
+        while (tailBlock_ != headBlock_ &&
+               tailSeq_ - blocks_[tailBlock_ % DIAG_BLOCK_COUNT].firstEntry >=
+                   blocks_[tailBlock_ % DIAG_BLOCK_COUNT].count) {
+            tailBlock_++;
         }
     }
+    committedSeq_ = headSeq();
+    savedHeadBlock_ = head;
+    savedTailSeq_ = tail;
+    firstPendingAt_ = millis();
     prefs.end();
-    head_ = count_;
+
+    if (legacy) {
+        importLegacy();
+        commit();
+    }
 }
 
-void DiagnosticLog::save() {
+/**
+ * Move string entries from the pre-compact layouts (per-entry journal, or the
+ * single "buf" blob before it) into the log, then delete them. Entries whose
+ * event and message do not match the dictionary are dropped.
+ */
+void DiagnosticLog::importLegacy() {
     Preferences prefs;
     if (!prefs.begin(NVS_NAMESPACE, false)) return;
-    prefs.putUChar(NVS_KEY_COUNT, count_);
-    if (count_ > 0) {
-        DiagnosticEntry tmp[DIAGNOSTIC_LOG_MAX_ENTRIES];
-        for (size_t i = 0; i < count_; i++) {
-            size_t pos = (head_ + DIAGNOSTIC_LOG_MAX_ENTRIES - count_ + i) % DIAGNOSTIC_LOG_MAX_ENTRIES;
-            tmp[i] = entries_[pos];
+    LegacyEntry entries[LEGACY_SLOTS];
+    uint8_t count = 0;
+
+    if (prefs.isKey(NVS_KEY_LEGACY_HEAD)) {
+        uint32_t head = prefs.getUInt(NVS_KEY_LEGACY_HEAD, 0);
+        uint32_t tail = prefs.getUInt(NVS_KEY_LEGACY_TAIL, 0);
+        if (head - tail > LEGACY_SLOTS) {
+            tail = head - LEGACY_SLOTS;
+        }
+        for (uint32_t seq = tail; seq != head; seq++) {
+            LegacyJournalRecord rec;
+            char key[8];
+            snprintf(key, sizeof(key), "e%02x", (unsigned)(seq % LEGACY_SLOTS));
+            if (prefs.getBytes(key, &rec, sizeof(rec)) != sizeof(rec) || rec.seq != seq) {
+                count = 0;  // keep only the intact run ending at head
+                continue;
+            }
+            entries[count++] = rec.entry;
+        }
+        for (uint8_t i = 0; i < LEGACY_SLOTS; i++) {
+            char key[8];
+            snprintf(key, sizeof(key), "e%02x", (unsigned)i);
+            prefs.remove(key);
+        }
+        prefs.remove(NVS_KEY_LEGACY_HEAD);
+        prefs.remove(NVS_KEY_LEGACY_TAIL);
+    } else {
+        uint8_t n = prefs.getUChar(NVS_KEY_LEGACY_COUNT, 0);
+        if (n > LEGACY_SLOTS) n = LEGACY_SLOTS;
+        if (n > 0 && prefs.getBytes(NVS_KEY_LEGACY_DATA, entries, n * sizeof(LegacyEntry)) == n * sizeof(LegacyEntry)) {
+            count = n;
         }
-        prefs.putBytes(NVS_KEY_DATA, tmp, count_ * sizeof(DiagnosticEntry));
     }
+    prefs.remove(NVS_KEY_LEGACY_COUNT);
+    prefs.remove(NVS_KEY_LEGACY_DATA);
     prefs.end();
+
+    for (uint8_t i = 0; i < count; i++) {
+        LegacyEntry& e = entries[i];
+        e.event[LEGACY_EVENT_LEN - 1] = '\0';
+        e.message[LEGACY_MESSAGE_LEN - 1] = '\0';
+        for (uint8_t id = 0; id < DIAG_EVENT_COUNT; id++) {
+            uint32_t args[DIAG_MAX_ARGS] = {0};
+            if (strcmp(EVENTS[id].event, e.event) == 0 && parseMessage(EVENTS[id].message, e.message, args)) {
+                appendAt(e.ts, id, args, DIAG_MAX_ARGS);
+                break;
+            }
+        }
+    }
+}
+
+void DiagnosticLog::blockKey(uint32_t seq, char* key) {
+    snprintf(key, 8, "b%02x", (unsigned)(seq % DIAG_BLOCK_COUNT));
 }
 
 #endif // DIAGNOSTIC_LOG_ENABLED
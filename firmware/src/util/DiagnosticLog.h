@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "config/config.h"
+#include "DiagnosticEvents.h"
 
 #if DIAGNOSTIC_LOG_ENABLED
 
@@ -15,32 +16,66 @@ enum class DiagnosticLevel : uint8_t {
     Error = 2
 };
 
-// Fixed-size entry for NVS ring buffer (keep small to fit many entries)
+// Buffer sizes for expanded entries (getEntry)
 #define DIAG_EVENT_LEN 20
 #define DIAG_MESSAGE_LEN 32
 
-struct DiagnosticEntry {
-    uint32_t ts;
-    uint8_t level;
-    char event[DIAG_EVENT_LEN];
-    char message[DIAG_MESSAGE_LEN];
+// Numeric arguments per entry
+#define DIAG_MAX_ARGS 2
+
+enum DiagnosticEvent : uint8_t {
+#define DIAG_EVENT_ID(name, level, event, message) DIAG_EVENT_##name,
+    DIAG_EVENTS(DIAG_EVENT_ID)
+#undef DIAG_EVENT_ID
+    DIAG_EVENT_COUNT
 };
 
 /**
- * Persistent diagnostic log for recovery events. Stored in NVS so entries
- * survive reboot. After reconnect, upload to backend then clear.
+ * Persistent diagnostic log for recovery events. After reconnect, upload to
+ * backend then remove the uploaded entries.
+ *
+ * Entries are compact: event ID (see util/DiagnosticEvents.h), timestamp as a
+ * varint delta from the previous entry, then the numeric arguments as varints;
+ * a few bytes each instead of the expanded strings. They are packed into
+ * blocks of DIAG_BLOCK_BYTES, kept in a ring of DIAG_BLOCK_COUNT.
+ *
+ * Stored in NVS as an append-only journal: block seq lives in its own key
+ * (slot seq % DIAG_BLOCK_COUNT, tagged with seq), plus the newest block and the
+ * tail entry sequence number. Appends are batched and committed together (only
+ * the blocks that changed, never the whole log); removeFirst() only moves the
+ * tail. NVS writes every update to a fresh location, which spreads wear over
+ * the partition. A RAM copy serves reads.
  */
 class DiagnosticLog {
 public:
     DiagnosticLog();
 
-    /** Append an entry (ring buffer, overwrites oldest when full). */
-    void append(DiagnosticLevel level, const char* event, const char* message = nullptr);
+    /**
+     * Append an entry with up to DIAG_MAX_ARGS integer arguments for the %d/%u
+     * fields of its message (overwrites the oldest block when full). Written to
+     * NVS by the next commit: once DIAG_COMMIT_BATCH entries are pending, or
+     * from commitIfDue().
+     */
+    template <typename... Args>
+    void append(DiagnosticEvent event, Args... args) {
+        static_assert(sizeof...(Args) <= DIAG_MAX_ARGS, "Too many diagnostic arguments");
+        uint32_t values[] = {0, static_cast<uint32_t>(args)...};  // leading 0: valid without args
+        appendAt(millis(), event, values + 1, sizeof...(Args));
+    }
+
+    /** Write pending entries and the head/tail pointers to NVS now. */
+    void commit();
+
+    /** Commit if entries have been pending for DIAG_COMMIT_INTERVAL_MS. */
+    void commitIfDue(unsigned long nowMs);
 
     /** Number of entries currently stored. */
     size_t getEntryCount() const;
 
-    /** Copy entry at index into provided buffers. Returns false if index out of range. */
+    /**
+     * Expand entry at index into provided buffers (event name, formatted message).
+     * Returns false if index out of range.
+     */
     bool getEntry(size_t index, uint32_t* outTs, uint8_t* outLevel,
                   char* outEvent, size_t eventLen,
                   char* outMessage, size_t messageLen) const;
@@ -48,23 +83,53 @@ public:
     /** Remove all entries (call after successful upload). */
     void clear();
 
-    /** Remove the first n entries (e.g. after uploading a batch). */
+    /** Remove the first n entries. */
     void removeFirst(size_t n);
 
+    /** Sequence number of the entry at index 0 (see removeBefore()). */
+    uint32_t getFirstSeq() const;
+
+    /**
+     * Remove the entries numbered below seq (e.g. after uploading a batch).
+     * Entries the journal already dropped to make room are not counted, so
+     * newer entries are never removed in their place.
+     */
+    void removeBefore(uint32_t seq);
+
     /** True if there is at least one entry to upload. */
     bool hasEntries() const;
 
 private:
+    // One journal slot; stored in NVS up to data[used]
+    struct Block {
+        uint32_t seq;         // block sequence number
+        uint32_t firstEntry;  // entry sequence number of the first record
+        uint32_t baseTs;      // the first record's delta is relative to this
+        uint8_t count;        // records in data
+        uint8_t used;         // bytes of data in use
+        uint8_t data[DIAG_BLOCK_BYTES];
+    };
+
+    void appendAt(uint32_t ts, uint8_t id, const uint32_t* args, uint8_t argc);
+    bool decode(uint32_t seq, uint32_t* outTs, uint8_t* outId, uint32_t* outArgs) const;
+    void openBlock(uint32_t ts);
+    uint32_t headSeq() const;
     void load();
-    void save();
+    void importLegacy();
+    static void blockKey(uint32_t seq, char* key);
 
     static const char* NVS_NAMESPACE;
-    static const char* NVS_KEY_COUNT;
-    static const char* NVS_KEY_DATA;
-
-    uint8_t count_;
-    DiagnosticEntry entries_[DIAGNOSTIC_LOG_MAX_ENTRIES];
-    uint8_t head_;  // next write position (ring buffer)
+    static const char* NVS_KEY_HEAD;
+    static const char* NVS_KEY_TAIL;
+
+    Block blocks_[DIAG_BLOCK_COUNT];  // block seq at seq % DIAG_BLOCK_COUNT
+    uint32_t headBlock_;       // block appended to
+    uint32_t tailBlock_;       // oldest block with live entries
+    uint32_t tailSeq_;         // oldest live entry
+    uint32_t committedSeq_;    // entries below this are in NVS
+    uint32_t savedHeadBlock_;  // head block as last written to NVS
+    uint32_t savedTailSeq_;    // tail as last written to NVS
+    unsigned long firstPendingAt_;
 };
 
 #endif // DIAGNOSTIC_LOG_ENABLED
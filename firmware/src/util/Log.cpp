@@ -0,0 +1,212 @@
+#include "Log.h"
+#include <string.h>
+
+static_assert((LOG_RING_RECORDS & (LOG_RING_RECORDS - 1)) == 0, "LOG_RING_RECORDS must be a power of two");
+static_assert(LOG_RECORD_PAYLOAD <= 255, "Record payload length must fit in one byte");
+
+/**
+ * Bounded MPMC ring (Vyukov): each cell carries a sequence number, so producers
+ * only contend on one CAS for the write position and fill their cell in place.
+ * seq == pos: free for the producer of pos; seq == pos + 1: ready for the consumer.
+ */
+struct LogCell {
+    std::atomic<uint32_t> seq;
+    LogRecord rec;
+};
+
+static LogCell cells[LOG_RING_RECORDS];
+static std::atomic<uint32_t> enqueuePos(0);
+static uint32_t dequeuePos = 0;
+static std::atomic<bool> ringReady(false);
+static std::atomic_flag draining = ATOMIC_FLAG_INIT;  // single consumer at a time
+static uint32_t reportedDropped = 0;
+
+std::atomic<uint32_t> Log::dropped(0);
+TaskHandle_t Log::taskHandle = nullptr;
+
+static void initRing() {
+    // Runs on the first claim (before setup() there is only one task)
+    if (ringReady.load(std::memory_order_acquire)) {
+        return;
+    }
+    for (uint32_t i = 0; i < LOG_RING_RECORDS; i++) {
+        cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+    ringReady.store(true, std::memory_order_release);
+}
+
+bool Log::start() {
+    if (taskHandle != nullptr) {
+        return true;
+    }
+    initRing();
+
+    BaseType_t created = xTaskCreatePinnedToCore(
+        Log::run, "log", LOG_TASK_STACK, nullptr,
+        LOG_TASK_PRIORITY, &taskHandle, LOG_TASK_CORE);
+    if (created != pdPASS) {
+        taskHandle = nullptr;
+        Serial.println("[Log] ERROR: Failed to create log task");
+        return false;
+    }
+
+    // First frame tells the decoder which format table the firmware was built with
+    LOG(LOG_STARTED, (unsigned int)LOG_ID_COUNT);
+    return true;
+}
+
+LogRecord* Log::claim(uint32_t& pos) {
+    initRing();
+    pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        LogCell& cell = cells[pos & (LOG_RING_RECORDS - 1)];
+        uint32_t seq = cell.seq.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                return &cell.rec;
+            }
+        } else if (diff < 0) {
+            // Full: the drain task has not caught up
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Log::publish(uint32_t pos) {
+    cells[pos & (LOG_RING_RECORDS - 1)].seq.store(pos + 1, std::memory_order_release);
+}
+
+/**
+ * Send every ready record. Returns false if another caller is already draining.
+ */
+bool Log::drain() {
+    if (draining.test_and_set(std::memory_order_acquire)) {
+        return false;
+    }
+
+    for (;;) {
+        LogCell& cell = cells[dequeuePos & (LOG_RING_RECORDS - 1)];
+        if (cell.seq.load(std::memory_order_acquire) != dequeuePos + 1) {
+            break;
+        }
+        send(cell.rec);
+        cell.seq.store(dequeuePos + LOG_RING_RECORDS, std::memory_order_release);
+        dequeuePos++;
+    }
+
+    uint32_t droppedNow = dropped.load(std::memory_order_relaxed);
+    if (droppedNow != reportedDropped) {
+        // Sent directly: the ring may still be full
+        LogRecord rec;
+        rec.timestampMs = millis();
+        rec.id = LOG_ID_LOG_DROPPED;
+        rec.len = 0;
+        rec.flags = 0;
+        put(rec, (unsigned int)(droppedNow - reportedDropped));
+        send(rec);
+        reportedDropped = droppedNow;
+    }
+
+    draining.clear(std::memory_order_release);
+    return true;
+}
+
+void Log::flush() {
+    if (!ringReady.load(std::memory_order_acquire)) {
+        return;
+    }
+    while (!drain()) {
+        delay(1);
+    }
+    Serial.flush();
+}
+
+uint32_t Log::getDroppedCount() {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+void Log::run(void* arg) {
+    (void)arg;
+    for (;;) {
+        drain();
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL_MS));
+    }
+}
+
+void Log::send(const LogRecord& rec) {
+    uint8_t frame[LOG_FRAME_HEADER_LEN + LOG_RECORD_PAYLOAD];
+    frame[0] = LOG_FRAME_SYNC;
+    frame[1] = rec.len;
+    frame[2] = rec.flags;
+    memcpy(frame + 3, &rec.timestampMs, 4);
+    memcpy(frame + 7, &rec.id, 2);
+    memcpy(frame + LOG_FRAME_HEADER_LEN, rec.payload, rec.len);
+    // One write per frame: the Serial driver keeps it contiguous
+    Serial.write(frame, LOG_FRAME_HEADER_LEN + rec.len);
+}
+
+void Log::putRaw(LogRecord& rec, uint8_t tag, const void* data, uint8_t size) {
+    if ((rec.flags & LOG_FLAG_TRUNCATED) || rec.len + 1 + size > LOG_RECORD_PAYLOAD) {
+        rec.flags |= LOG_FLAG_TRUNCATED;  // keep later arguments out too, so positions stay right
+        return;
+    }
+    rec.payload[rec.len++] = tag;
+    memcpy(rec.payload + rec.len, data, size);
+    rec.len += size;
+}
+
+void Log::put(LogRecord& rec, int value) {
+    int32_t v = value;
+    putRaw(rec, LOG_ARG_I32, &v, sizeof(v));
+}
+
+void Log::put(LogRecord& rec, unsigned int value) {
+    uint32_t v = value;
+    putRaw(rec, LOG_ARG_U32, &v, sizeof(v));
+}
+
+void Log::put(LogRecord& rec, long value) {
+    put(rec, (long long)value);
+}
+
+void Log::put(LogRecord& rec, unsigned long value) {
+    put(rec, (unsigned long long)value);
+}
+
+void Log::put(LogRecord& rec, long long value) {
+    if (value >= INT32_MIN && value <= INT32_MAX) {
+        put(rec, (int)value);
+        return;
+    }
+    int64_t v = value;
+    putRaw(rec, LOG_ARG_I64, &v, sizeof(v));
+}
+
+void Log::put(LogRecord& rec, unsigned long long value) {
+    if (value <= UINT32_MAX) {
+        put(rec, (unsigned int)value);
+        return;
+    }
+    uint64_t v = value;
+    putRaw(rec, LOG_ARG_U64, &v, sizeof(v));
+}
+
+void Log::put(LogRecord& rec, const char* value) {
+    if (value == nullptr) {
+        value = "(null)";
+    }
+    size_t room = LOG_RECORD_PAYLOAD - rec.len;
+    if ((rec.flags & LOG_FLAG_TRUNCATED) || room < 2) {
+        rec.flags |= LOG_FLAG_TRUNCATED;
+        return;
+    }
+    size_t n = strnlen(value, room - 2);  // cut to fit
+    rec.payload[rec.len++] = LOG_ARG_STR;
+    rec.payload[rec.len++] = (uint8_t)n;
+    memcpy(rec.payload + rec.len, value, n);
+    rec.len += n;
+}
@@ -0,0 +1,139 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <atomic>
+#include "config/config.h"
+#include "LogFormats.h"
+
+/**
+ * Deferred binary logger.
+ * LOG(NAME, args...) copies the format ID of NAME (see util/LogFormats.h) and its
+ * arguments into a lock-free RAM ring; it never blocks and may be called from any
+ * task. A low-priority task drains the ring to Serial as binary frames, so UART
+ * TX time is spent when the CPU is otherwise idle. Format strings are not stored
+ * on the device: tools/log_decode.py turns frames back into text, and passes
+ * plain Serial text (boot output) through unchanged.
+ *
+ * Entries below LOG_MIN_LEVEL are removed at compile time.
+ * Arguments: integers (up to 64-bit) and C strings (truncated to fit the record).
+ */
+#define LOG(name, ...)                                                  \
+    do {                                                                \
+        if (Log::enabled(LOG_LEVEL_OF_##name)) {                        \
+            Log::write(LOG_ID_##name, ##__VA_ARGS__);                   \
+        }                                                               \
+    } while (0)
+
+enum LogId : uint16_t {
+#define LOG_FORMAT_ID(name, level, format) LOG_ID_##name,
+    LOG_FORMATS(LOG_FORMAT_ID)
+#undef LOG_FORMAT_ID
+    LOG_ID_COUNT
+};
+
+enum LogLevelOf {
+#define LOG_FORMAT_LEVEL(name, level, format) LOG_LEVEL_OF_##name = level,
+    LOG_FORMATS(LOG_FORMAT_LEVEL)
+#undef LOG_FORMAT_LEVEL
+};
+
+/**
+ * One log entry as queued and as sent (after the frame header).
+ * payload holds the arguments: a type tag byte then the value, little-endian.
+ */
+struct LogRecord {
+    uint32_t timestampMs;
+    uint16_t id;
+    uint8_t len;    // payload bytes used
+    uint8_t flags;  // LOG_FLAG_*
+    uint8_t payload[LOG_RECORD_PAYLOAD];
+};
+
+// Argument type tags (mirrored in tools/log_decode.py)
+#define LOG_ARG_I32 0x01
+#define LOG_ARG_U32 0x02
+#define LOG_ARG_I64 0x03
+#define LOG_ARG_U64 0x04
+#define LOG_ARG_STR 0x05  // length byte + bytes, no terminator
+
+// An argument did not fit: it and all later ones were left out
+#define LOG_FLAG_TRUNCATED 0x01
+
+// Wire frame: LOG_FRAME_SYNC, payload length, flags, timestamp (4), id (2), payload.
+// 0xFE never occurs in ASCII or UTF-8 text, so frames and plain text can share the UART.
+#define LOG_FRAME_SYNC 0xFE
+#define LOG_FRAME_HEADER_LEN 9
+
+class Log {
+public:
+    /**
+     * Start the drain task. Entries logged before this are kept in the ring.
+     * Returns true if the task was created.
+     */
+    static bool start();
+
+    static constexpr bool enabled(int level) {
+        return level >= LOG_MIN_LEVEL;
+    }
+
+    /**
+     * Queue one entry (use the LOG macro). Dropped and counted if the ring is full.
+     */
+    template <typename... Args>
+    static void write(uint16_t id, Args... args) {
+        uint32_t pos;
+        LogRecord* rec = claim(pos);
+        if (rec == nullptr) {
+            return;
+        }
+        rec->timestampMs = millis();
+        rec->id = id;
+        rec->len = 0;
+        rec->flags = 0;
+        pack(*rec, args...);
+        publish(pos);
+    }
+
+    /**
+     * Drain the ring synchronously (e.g. right before esp_restart()).
+     */
+    static void flush();
+
+    /**
+     * Number of entries dropped because the ring was full.
+     */
+    static uint32_t getDroppedCount();
+
+private:
+    static LogRecord* claim(uint32_t& pos);
+    static void publish(uint32_t pos);
+    static bool drain();
+    static void run(void* arg);
+    static void send(const LogRecord& rec);
+
+    static void pack(LogRecord& rec) {
+        (void)rec;
+    }
+
+    template <typename T, typename... Rest>
+    static void pack(LogRecord& rec, T value, Rest... rest) {
+        put(rec, value);
+        pack(rec, rest...);
+    }
+
+    static void put(LogRecord& rec, int value);
+    static void put(LogRecord& rec, unsigned int value);
+    static void put(LogRecord& rec, long value);
+    static void put(LogRecord& rec, unsigned long value);
+    static void put(LogRecord& rec, long long value);
+    static void put(LogRecord& rec, unsigned long long value);
+    static void put(LogRecord& rec, const char* value);
+    static void putRaw(LogRecord& rec, uint8_t tag, const void* data, uint8_t size);
+
+    static std::atomic<uint32_t> dropped;
+    static TaskHandle_t taskHandle;
+};
+
+#endif // LOG_H
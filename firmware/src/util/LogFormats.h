@@ -0,0 +1,220 @@
+#ifndef LOG_FORMATS_H
+#define LOG_FORMATS_H
+
+// Log levels (entries below LOG_MIN_LEVEL are compiled out)
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_ALWAYS 4  // not filterable (logger bookkeeping)
+
+/**
+ * Format table for the deferred logger: X(NAME, level, "printf format").
+ * The record ID is the position in this list. tools/log_decode.py reads this
+ * file to turn records back into text, so keep one entry per line and decode
+ * with the revision the firmware was built from (LOG_STARTED carries the count).
+ */
+#define LOG_FORMATS(X) \
+    X(LOG_DROPPED, LOG_LEVEL_ALWAYS, "[Log] %u entries dropped (ring full)") \
+    X(LOG_STARTED, LOG_LEVEL_ALWAYS, "[Log] Started (%u formats)") \
+    X(MODEM_UART_INIT, LOG_LEVEL_INFO, "[Modem] Initializing UART (Serial1): TX %d, RX %d, Baud %u") \
+    X(MODEM_WARM_RUNNING, LOG_LEVEL_INFO, "[Modem] Warm boot: modem session still running") \
+    X(MODEM_WARM_NOT_RESPONDING, LOG_LEVEL_WARN, "[Modem] Warm boot: modem not responding, full init") \
+    X(MODEM_ALREADY_ON, LOG_LEVEL_INFO, "[Modem] Modem already powered and responsive, skipping power-on") \
+    X(MODEM_HW_INIT, LOG_LEVEL_INFO, "[Modem] Initializing hardware...") \
+    X(MODEM_POWERON_PIN, LOG_LEVEL_DEBUG, "[Modem] Setting BOARD_POWERON_PIN HIGH...") \
+    X(MODEM_RESETTING, LOG_LEVEL_INFO, "[Modem] Resetting modem...") \
+    X(MODEM_POWERING_ON, LOG_LEVEL_INFO, "[Modem] Powering on modem...") \
+    X(MODEM_WAIT_BOOT, LOG_LEVEL_INFO, "[Modem] Hardware initialized, waiting for modem to boot (RDY/AT)...") \
+    X(MODEM_RDY, LOG_LEVEL_INFO, "[Modem] Modem reported RDY, starting AT handshake...") \
+    X(MODEM_AT_OK_BEFORE_RDY, LOG_LEVEL_INFO, "[Modem] AT handshake OK (modem responsive before RDY)") \
+    X(MODEM_NO_RDY, LOG_LEVEL_WARN, "[Modem] No RDY from modem, starting AT handshake...") \
+    X(MODEM_AT_OK, LOG_LEVEL_INFO, "[Modem] AT handshake OK") \
+    X(MODEM_AT_TIMEOUT, LOG_LEVEL_WARN, "[Modem] AT handshake timeout") \
+    X(MODEM_ECHO_OFF, LOG_LEVEL_DEBUG, "[Modem] Echo disabled") \
+    X(MODEM_ECHO_OFF_FAILED, LOG_LEVEL_WARN, "[Modem] Failed to disable echo") \
+    X(MODEM_SIM_OK, LOG_LEVEL_DEBUG, "[Modem] SIM query OK") \
+    X(MODEM_SIM_FAILED, LOG_LEVEL_WARN, "[Modem] SIM query failed (non-critical)") \
+    X(MODEM_REG_OK, LOG_LEVEL_DEBUG, "[Modem] Network registration query OK") \
+    X(MODEM_REG_FAILED, LOG_LEVEL_WARN, "[Modem] Network query failed (non-critical)") \
+    X(MODEM_URCS_ON, LOG_LEVEL_DEBUG, "[Modem] Registration and PDP event reports enabled") \
+    X(MODEM_URCS_FAILED, LOG_LEVEL_WARN, "[Modem] Failed to enable event reports (non-critical)") \
+    X(MODEM_RSSI_OK, LOG_LEVEL_DEBUG, "[Modem] Signal strength query OK") \
+    X(MODEM_RSSI_FAILED, LOG_LEVEL_WARN, "[Modem] RSSI query failed (non-critical)") \
+    X(MODEM_READY, LOG_LEVEL_INFO, "[Modem] Initialization complete") \
+    X(MODEM_POWER_CYCLE, LOG_LEVEL_WARN, "[Modem] Power cycling...") \
+    X(MODEM_HARD_RESET, LOG_LEVEL_WARN, "[Modem] Hard reset...") \
+    X(MODEM_AT_RESPONSE, LOG_LEVEL_DEBUG, "[Modem] Response: %s") \
+    X(MODEM_AT_ERROR, LOG_LEVEL_WARN, "[Modem] Error response: %s") \
+    X(MODEM_AT_RESPONSE_TIMEOUT, LOG_LEVEL_WARN, "[Modem] Timeout waiting for response to %s") \
+    X(MODEM_AT_QUEUE_FULL, LOG_LEVEL_ERROR, "[Modem] ERROR: AT queue full, dropping %s") \
+    X(MODEM_BAUD_SWITCH, LOG_LEVEL_INFO, "[Modem] Switching UART to %lu baud") \
+    X(MODEM_BAUD_OK, LOG_LEVEL_INFO, "[Modem] UART running at %lu baud") \
+    X(MODEM_BAUD_REJECTED, LOG_LEVEL_WARN, "[Modem] %lu baud rejected, staying at %lu") \
+    X(MODEM_BAUD_VERIFY_FAILED, LOG_LEVEL_WARN, "[Modem] Round trip failed at %lu baud, restarting modem at %lu") \
+    X(MODEM_BAUD_ERRORS, LOG_LEVEL_WARN, "[Modem] %lu UART errors at %lu baud, falling back to %lu") \
+    X(MODEM_BAUD_PROBE_FALLBACK, LOG_LEVEL_INFO, "[Modem] No answer at %lu baud, probing at %lu") \
+    X(MODEM_CMUX_STALE_CLOSE, LOG_LEVEL_INFO, "[Modem] No answer to AT, closing a leftover CMUX session") \
+    X(MODEM_CMUX_OPEN, LOG_LEVEL_INFO, "[Modem] CMUX up, %u channels") \
+    X(MODEM_CMUX_REJECTED, LOG_LEVEL_WARN, "[Modem] AT+CMUX rejected, staying on a single channel") \
+    X(MODEM_CMUX_FAILED, LOG_LEVEL_WARN, "[Modem] CMUX channels did not open, restarting modem without CMUX") \
+    X(CMUX_CHANNEL_OPEN, LOG_LEVEL_DEBUG, "[CMUX] Channel %u open") \
+    X(CMUX_CHANNEL_REFUSED, LOG_LEVEL_WARN, "[CMUX] Channel %u refused by modem") \
+    X(CMUX_CHANNEL_CLOSED, LOG_LEVEL_WARN, "[CMUX] Channel %u closed by modem") \
+    X(CMUX_BAD_FRAME, LOG_LEVEL_WARN, "[CMUX] Bad frame on channel %u dropped") \
+    X(CMUX_RX_OVERFLOW, LOG_LEVEL_WARN, "[CMUX] Channel %u receive buffer full, dropped %u bytes") \
+    X(MODEM_URC_MQTT_LOST, LOG_LEVEL_WARN, "[Modem] URC: MQTT client %d connection lost (cause %d)") \
+    X(MODEM_URC_MQTT_NONET, LOG_LEVEL_WARN, "[Modem] URC: MQTT network closed") \
+    X(MODEM_URC_REGISTRATION, LOG_LEVEL_INFO, "[Modem] URC: registration status %d") \
+    X(MODEM_URC_PDP, LOG_LEVEL_INFO, "[Modem] URC: packet domain event %s") \
+    X(PPP_STARTING, LOG_LEVEL_INFO, "[PPP] Starting PPP session with TinyGSM...") \
+    X(PPP_TINYGSM_FAILED, LOG_LEVEL_ERROR, "[PPP] Failed to initialize TinyGSM") \
+    X(PPP_INITIATED, LOG_LEVEL_INFO, "[PPP] PPP connection initiated") \
+    X(PPP_STOPPING, LOG_LEVEL_INFO, "[PPP] Stopping PPP session...") \
+    X(PPP_NET_CLOSING, LOG_LEVEL_INFO, "[PPP] Disconnecting network...") \
+    X(PPP_STOPPED, LOG_LEVEL_INFO, "[PPP] PPP session stopped") \
+    X(PPP_TIMEOUT, LOG_LEVEL_WARN, "[PPP] Timeout waiting for PPP to come up") \
+    X(PPP_WARM_NOT_REGISTERED, LOG_LEVEL_INFO, "[PPP] Warm boot: not registered, full connect") \
+    X(PPP_WARM_SESSION_ACTIVE, LOG_LEVEL_INFO, "[PPP] Warm boot: data session still active, IP %s") \
+    X(PPP_WARM_NO_IP, LOG_LEVEL_INFO, "[PPP] Warm boot: registered but no IP, activating network") \
+    X(PPP_REGISTERED, LOG_LEVEL_INFO, "[PPP] Registered (%s)") \
+    X(PPP_REG_DENIED, LOG_LEVEL_ERROR, "[PPP] Network registration denied!") \
+    X(PPP_REG_WAIT, LOG_LEVEL_DEBUG, "[PPP] Waiting for network registration... status %d") \
+    X(PPP_APN_SET, LOG_LEVEL_INFO, "[PPP] APN set: %s") \
+    X(PPP_APN_FAILED, LOG_LEVEL_WARN, "[PPP] Failed to set APN, retrying...") \
+    X(PPP_ACTIVATING, LOG_LEVEL_INFO, "[PPP] Activating network...") \
+    X(PPP_ACTIVATED, LOG_LEVEL_INFO, "[PPP] Network activated") \
+    X(PPP_IP_ASSIGNED, LOG_LEVEL_INFO, "[PPP] IP address: %s") \
+    X(PPP_NO_IP, LOG_LEVEL_WARN, "[PPP] No IP assigned after %lums") \
+    X(PPP_IP_WAIT, LOG_LEVEL_DEBUG, "[PPP] Waiting for IP...") \
+    X(PPP_ACTIVATE_RETRY, LOG_LEVEL_WARN, "[PPP] Network activation failed, retry %u/%u...") \
+    X(PPP_ACTIVATE_FAILED, LOG_LEVEL_ERROR, "[PPP] Network activation failed after %u retries") \
+    X(PPP_UP, LOG_LEVEL_INFO, "[PPP] PPP is UP") \
+    X(PPP_FAIL_STREAK_RESET, LOG_LEVEL_INFO, "[PPP] Resetting failure streak (was %u)") \
+    X(PPP_FAIL_STREAK, LOG_LEVEL_WARN, "[PPP] Failure streak: %u") \
+    X(PPP_HARD_RESET_NEEDED, LOG_LEVEL_WARN, "[PPP] Failure threshold exceeded, will trigger modem hard reset") \
+    X(PPP_TINYGSM_INIT, LOG_LEVEL_INFO, "[PPP] Initializing TinyGSM...") \
+    X(PPP_TINYGSM_MODEM_FAILED, LOG_LEVEL_ERROR, "[PPP] ERROR: Failed to create TinyGSM modem") \
+    X(PPP_TINYGSM_CLIENT_FAILED, LOG_LEVEL_ERROR, "[PPP] ERROR: Failed to create TinyGsmClient") \
+    X(PPP_TINYGSM_READY, LOG_LEVEL_INFO, "[PPP] TinyGSM initialized") \
+    X(MQTT_USING_MODEM_CLIENT, LOG_LEVEL_INFO, "[MQTT] Using modem's built-in MQTT client (supports TLS/SSL)") \
+    X(MQTT_MODEM_MISSING_WARN, LOG_LEVEL_WARN, "[MQTT] WARNING: Modem not available") \
+    X(MQTT_MODEM_MISSING, LOG_LEVEL_ERROR, "[MQTT] ERROR: Modem not available") \
+    X(MQTT_INIT, LOG_LEVEL_INFO, "[MQTT] Initializing modem MQTT client (SSL: %s, SNI: %s)...") \
+    X(MQTT_SET_ROOT_CA, LOG_LEVEL_INFO, "[MQTT] Setting root CA certificate...") \
+    X(MQTT_INITIALIZED, LOG_LEVEL_INFO, "[MQTT] Modem MQTT initialized") \
+    X(MQTT_MODEM_NOT_SET, LOG_LEVEL_ERROR, "[MQTT] ERROR: Modem not initialized. Call setPppManager() first!") \
+    X(MQTT_CONNECTING, LOG_LEVEL_INFO, "[MQTT] Connecting to broker %s:%u...") \
+    X(MQTT_CONNECTED, LOG_LEVEL_INFO, "[MQTT] Connected to broker") \
+    X(MQTT_SUBSCRIBED, LOG_LEVEL_INFO, "[MQTT] Subscribed to %s") \
+    X(MQTT_SUBSCRIBE_BIN_FAILED, LOG_LEVEL_WARN, "[MQTT] WARNING: Failed to subscribe to binary command topic") \
+    X(MQTT_SUBSCRIBE_FAILED, LOG_LEVEL_ERROR, "[MQTT] Failed to subscribe to command topic") \
+    X(MQTT_CONNECT_FAILED, LOG_LEVEL_WARN, "[MQTT] Connection failed") \
+    X(MQTT_SESSION_STEP_FAILED, LOG_LEVEL_WARN, "[MQTT] Session setup failed at %s") \
+    X(MQTT_NEXT_RETRY, LOG_LEVEL_INFO, "[MQTT] Next retry in %lums") \
+    X(MQTT_WARM_SESSION_GONE, LOG_LEVEL_INFO, "[MQTT] Warm boot: previous session gone") \
+    X(MQTT_WARM_ADOPTED, LOG_LEVEL_INFO, "[MQTT] Warm boot: adopted connected client %u") \
+    X(MQTT_DISCONNECTING, LOG_LEVEL_INFO, "[MQTT] Disconnecting...") \
+    X(MQTT_PUBLISH_NOT_CONNECTED, LOG_LEVEL_WARN, "[MQTT] Cannot publish: not connected") \
+    X(MQTT_PUBLISH_FAILED, LOG_LEVEL_WARN, "[MQTT] Failed to publish to %s") \
+    X(MQTT_ACK_NOT_CONNECTED, LOG_LEVEL_WARN, "[MQTT] Cannot publish ACK: not connected") \
+    X(MQTT_ACK_PREPARED, LOG_LEVEL_DEBUG, "[MQTT] ACK prepared for requestId: %s") \
+    X(MQTT_STATUS_PUBLISHED, LOG_LEVEL_INFO, "[MQTT] Status published: %s") \
+    X(MQTT_STATUS_FAILED, LOG_LEVEL_WARN, "[MQTT] Failed to publish status") \
+    X(MQTT_CONNECTION_LOST, LOG_LEVEL_WARN, "[MQTT] Connection lost") \
+    X(MQTT_RECEIVED, LOG_LEVEL_INFO, "[MQTT] Message received on topic: %s (%u bytes)") \
+    X(MQTT_NO_COMMAND_QUEUE, LOG_LEVEL_ERROR, "[MQTT] No command queue set, dropping message") \
+    X(MQTT_PAYLOAD_OVERSIZE, LOG_LEVEL_ERROR, "[MQTT] ERROR: Payload of %u bytes exceeds %u bytes, dropping") \
+    X(MQTT_NO_RX_SLOT, LOG_LEVEL_ERROR, "[MQTT] ERROR: No free receive slot, dropping command") \
+    X(MQTT_COMMAND_QUEUE_FULL, LOG_LEVEL_ERROR, "[MQTT] ERROR: Command queue full, dropping command") \
+    X(MQTT_FAIL_STREAK_RESET, LOG_LEVEL_INFO, "[MQTT] Resetting failure streak (was %u)") \
+    X(MQTT_FAIL_STREAK, LOG_LEVEL_WARN, "[MQTT] Failure streak: %u") \
+    X(MQTT_REBUILD_PPP, LOG_LEVEL_WARN, "[MQTT] Failure threshold exceeded, will rebuild PPP") \
+    X(OUTBOX_DROPPED, LOG_LEVEL_ERROR, "[Outbox] ERROR: Queue full, dropping %s message (%u bytes)") \
+    X(OUTBOX_SPILLED, LOG_LEVEL_WARN, "[Outbox] RAM full, %s message written to NVS (%u spilled)") \
+    X(OUTBOX_SPILL_RESTORED, LOG_LEVEL_INFO, "[Outbox] %u message(s) restored from NVS") \
+    X(OUTBOX_PUBLISHED, LOG_LEVEL_INFO, "[Outbox] Published to %s after %lums in queue") \
+    X(OUTBOX_PUBLISH_FAILED, LOG_LEVEL_WARN, "[Outbox] Publish to %s failed (attempt %u)") \
+    X(OUTBOX_GAVE_UP, LOG_LEVEL_ERROR, "[Outbox] ERROR: Dropping %s message after %u attempts") \
+    X(PROTOCOL_JSON_ERROR, LOG_LEVEL_WARN, "[Protocol] JSON parse error") \
+    X(PROTOCOL_BAD_REQUEST_ID, LOG_LEVEL_WARN, "[Protocol] Missing or invalid requestId") \
+    X(PROTOCOL_BAD_COMMAND, LOG_LEVEL_WARN, "[Protocol] Missing or invalid command") \
+    X(PROTOCOL_BAD_USER_ID, LOG_LEVEL_WARN, "[Protocol] Missing or invalid userId") \
+    X(PROTOCOL_BAD_ISSUED_AT, LOG_LEVEL_WARN, "[Protocol] Missing or invalid issuedAt") \
+    X(PROTOCOL_BIN_TOO_SHORT, LOG_LEVEL_WARN, "[Protocol] Binary frame too short") \
+    X(PROTOCOL_BIN_VERSION, LOG_LEVEL_WARN, "[Protocol] Unsupported binary version %u") \
+    X(DEDUPE_RESTORED, LOG_LEVEL_INFO, "[GateControl] Dedupe cache restored (%u entries)") \
+    X(GATECTL_INITIALIZED, LOG_LEVEL_INFO, "[GateControl] Initialized (cooldown and dedupe ready)") \
+    X(GATECTL_OPEN_RECORDED, LOG_LEVEL_INFO, "[GateControl] Recorded gate open at %lums (cooldown: %ums)") \
+    X(GATECTL_OPEN_SCHEDULED, LOG_LEVEL_INFO, "[GateControl] Deferred open scheduled in %lums") \
+    X(GATECTL_DEDUPE_HIT, LOG_LEVEL_DEBUG, "[GateControl] Dedupe hit: requestId %s already processed") \
+    X(GATECTL_MARKED_PROCESSED, LOG_LEVEL_DEBUG, "[GateControl] Marked requestId %s as processed (%u cached)") \
+    X(GATECTL_PULSE_COMPLETED, LOG_LEVEL_INFO, "[GateControl] Pulse completed after %lums") \
+    X(GATE_TASK_CREATE_FAILED, LOG_LEVEL_ERROR, "[GateTask] ERROR: Failed to create gate task") \
+    X(GATE_TASK_STARTED, LOG_LEVEL_INFO, "[GateTask] Started on core %d") \
+    X(GATE_PARSE_FAILED, LOG_LEVEL_WARN, "[Gate] Payload did not parse") \
+    X(GATE_DEFERRED_OPEN, LOG_LEVEL_INFO, "[Gate] Running deferred open for %u request(s)") \
+    X(GATE_DEFERRED_RELAY_FAIL, LOG_LEVEL_ERROR, "[Gate] ERROR: Deferred relay activation failed - publishing RELAY_FAIL ACKs") \
+    X(GATE_ACK_QUEUE_FULL, LOG_LEVEL_ERROR, "[Gate] ERROR: ACK queue full, dropping ACK for requestId %s") \
+    X(GATE_INVALID_PAYLOAD, LOG_LEVEL_WARN, "[Gate] Invalid payload - publishing BAD_PAYLOAD ACK") \
+    X(GATE_EMPTY_REQUEST_ID, LOG_LEVEL_WARN, "[Gate] Empty requestId - publishing BAD_PAYLOAD ACK") \
+    X(GATE_COMMAND, LOG_LEVEL_INFO, "[Gate] Parsed command: requestId=%s, command=%s, userId=%s, issuedAt=%llu") \
+    X(GATE_UNKNOWN_COMMAND, LOG_LEVEL_WARN, "[Gate] Unknown command: %s - publishing UNKNOWN_COMMAND ACK") \
+    X(GATE_DEDUPE_HIT, LOG_LEVEL_INFO, "[Gate] Dedupe hit for requestId: %s - publishing idempotent success ACK") \
+    X(GATE_DEFER_PENDING, LOG_LEVEL_INFO, "[Gate] requestId %s already waiting for the deferred open") \
+    X(GATE_COALESCED, LOG_LEVEL_INFO, "[Gate] Relay pulse in progress - coalescing, publishing success ACK") \
+    X(GATE_DEFERRED, LOG_LEVEL_INFO, "[Gate] Cooldown tail - deferring open by %lums, ACK once it has run") \
+    X(GATE_COOLDOWN, LOG_LEVEL_INFO, "[Gate] Cooldown active - remaining: %lums - publishing COOLDOWN ACK") \
+    X(GATE_ACTIVATING, LOG_LEVEL_INFO, "[Gate] Activating relay pulse...") \
+    X(GATE_RELAY_FAIL, LOG_LEVEL_ERROR, "[Gate] Relay activation failed - publishing RELAY_FAIL ACK") \
+    X(RELAY_TIMER_CREATE_FAILED, LOG_LEVEL_ERROR, "[Relay] ERROR: Failed to create pulse timer") \
+    X(RELAY_INITIALIZED, LOG_LEVEL_INFO, "[Relay] Initialized GPIO %d (LOW - safe state)") \
+    X(RELAY_TIMER_UNAVAILABLE, LOG_LEVEL_ERROR, "[Relay] ERROR: Pulse timer not available") \
+    X(RELAY_PULSE_BUSY, LOG_LEVEL_WARN, "[Relay] Pulse already in progress") \
+    X(RELAY_PULSE_START, LOG_LEVEL_INFO, "[Relay] Activating pulse on GPIO %d for %ums") \
+    X(RELAY_TIMER_ARM_FAILED, LOG_LEVEL_ERROR, "[Relay] ERROR: Failed to arm pulse timer, pin set to LOW") \
+    X(GATE_ACK_QUEUED, LOG_LEVEL_INFO, "[Gate] ACK queued: ok=true for requestId %s") \
+    X(GATE_ACK_QUEUED_ERROR, LOG_LEVEL_INFO, "[Gate] ACK queued: ok=false, errorCode=%s for requestId %s") \
+    X(GATE_ACK_ENQUEUE_FAILED, LOG_LEVEL_ERROR, "[Gate] ERROR: Failed to queue ACK for requestId %s") \
+    X(SCHEDULER_TABLE_FULL, LOG_LEVEL_ERROR, "[Scheduler] ERROR: Task table full") \
+    X(BOOT_PHASE, LOG_LEVEL_INFO, "[Boot] %s at %lums") \
+    X(WARMBOOT_COLD, LOG_LEVEL_INFO, "[WarmBoot] Reset reason %u, cold boot") \
+    X(WARMBOOT_WARM, LOG_LEVEL_INFO, "[WarmBoot] Reset reason %u, warm boot #%lu (modem=%s, ppp=%s, mqtt=%s)") \
+    X(OOB_ACTION, LOG_LEVEL_WARN, "[OOB] Action received: %s") \
+    X(OOB_POLLING, LOG_LEVEL_DEBUG, "[OOB] Polling pending-command via built-in HTTPS...") \
+    X(OOB_SET_URL_FAILED, LOG_LEVEL_WARN, "[OOB] https_set_url failed") \
+    X(OOB_RESPONSE, LOG_LEVEL_DEBUG, "[OOB] https_get code %d, response size hint %lu") \
+    X(OOB_STATUS_ACTION, LOG_LEVEL_INFO, "[OOB] status %d => %s") \
+    X(OOB_NON_COMMAND_STATUS, LOG_LEVEL_WARN, "[OOB] Status %d is not a command, skipping body parse") \
+    X(DEVICE_BANNER, LOG_LEVEL_INFO, "[Device] Parking Gate Remote %s, firmware %s") \
+    X(DEVICE_CONFIG_CELLULAR, LOG_LEVEL_INFO, "[Config] APN %s, user %s, password %s, PPP timeout %lums") \
+    X(DEVICE_CONFIG_MODEM, LOG_LEVEL_INFO, "[Config] Modem Serial1 %lu baud, TX %d, RX %d, POWERON %d, RESET %d (active %s), PWRKEY %d, DTR %d") \
+    X(DEVICE_CONFIG_AT, LOG_LEVEL_INFO, "[Config] AT init timeout %lums, command timeout %lums") \
+    X(DEVICE_CONFIG_MQTT, LOG_LEVEL_INFO, "[Config] MQTT %s:%d, user %s, password %s, status every %lums") \
+    X(DEVICE_CONFIG_TOPICS, LOG_LEVEL_INFO, "[Config] Topics: %s, %s, %s") \
+    X(DEVICE_CONFIG_RECOVERY, LOG_LEVEL_INFO, "[Config] MQTT fails before PPP rebuild %d, PPP fails before modem reset %d, backoff %lu-%lums") \
+    X(DEVICE_CONFIG_BOOT, LOG_LEVEL_INFO, "[Config] Cold boot delay %lums, modem init retries %d, init backoff %lums") \
+    X(DEVICE_MANAGERS_CREATED, LOG_LEVEL_INFO, "[Device] Managers created") \
+    X(DEVICE_GATE_READY, LOG_LEVEL_INFO, "[Device] Relay and gate control initialized") \
+    X(DEVICE_COLD_BOOT_DELAY, LOG_LEVEL_INFO, "[Device] Cold boot delay %lums (scheduled)") \
+    X(DEVICE_NETWORK_TASK, LOG_LEVEL_INFO, "[Device] Network task started on core %d, state MODEM_INIT") \
+    X(DEVICE_MANAGERS_MISSING, LOG_LEVEL_ERROR, "[Device] ERROR: Managers not initialized!") \
+    X(DEVICE_COLD_BOOT_DONE, LOG_LEVEL_INFO, "[Device] Cold boot delay complete") \
+    X(DEVICE_INIT_BACKOFF_DONE, LOG_LEVEL_INFO, "[Device] Modem init backoff complete, retrying init") \
+    X(DEVICE_MODEM_READY, LOG_LEVEL_INFO, "[Device] Modem initialized, starting PPP...") \
+    X(DEVICE_MODEM_INIT_TIMEOUT, LOG_LEVEL_WARN, "[Device] Modem init timeout, power cycle retry %d...") \
+    X(DEVICE_MODEM_INIT_BACKOFF, LOG_LEVEL_WARN, "[Device] Modem init max retries reached, backing off %lums...") \
+    X(DEVICE_PPP_CONNECTED, LOG_LEVEL_INFO, "[Device] PPP connected, setting up MQTT...") \
+    X(DEVICE_PPP_TIMEOUT, LOG_LEVEL_WARN, "[Device] PPP connection timeout, retrying...") \
+    X(DEVICE_PPP_HARD_RESET, LOG_LEVEL_WARN, "[Device] PPP failure threshold exceeded, modem hard reset...") \
+    X(DEVICE_MODEM_MQTT_INIT, LOG_LEVEL_INFO, "[Device] Initializing modem MQTT with TLS...") \
+    X(DEVICE_MODEM_MQTT_READY, LOG_LEVEL_INFO, "[Device] Modem MQTT initialized with TLS, connecting to MQTT...") \
+    X(DEVICE_MODEM_MQTT_FAILED, LOG_LEVEL_ERROR, "[Device] ERROR: Failed to initialize modem MQTT") \
+    X(DEVICE_MQTT_STUCK, LOG_LEVEL_WARN, "[Device] MQTT connect taking too long (%lums), forcing PPP rebuild...") \
+    X(DEVICE_MQTT_FAIL_THRESHOLD, LOG_LEVEL_WARN, "[Device] MQTT fail threshold exceeded, rebuilding PPP...") \
+    X(DEVICE_MQTT_CONNECTED, LOG_LEVEL_INFO, "[Device] MQTT connected!") \
+    X(DEVICE_BOOT_REPORT, LOG_LEVEL_INFO, "[Device] Boot report published (%u bytes)") \
+    X(DEVICE_MQTT_LOST, LOG_LEVEL_WARN, "[Device] MQTT connection lost, reconnecting...") \
+    X(DEVICE_DIAG_BATCH_PUBLISHED, LOG_LEVEL_DEBUG, "[Device] Diagnostic log batch published")
+
+#endif // LOG_FORMATS_H
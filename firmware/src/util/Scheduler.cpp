@@ -0,0 +1,196 @@
+#include "Scheduler.h"
+#include "Log.h"
+
+Scheduler::Scheduler()
+    : currentTick(0), lastNowMs(0), started(false) {
+    for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        tasks[i].fn = nullptr;
+        tasks[i].ctx = nullptr;
+        tasks[i].periodMs = 0;
+        tasks[i].dueMs = 0;
+        tasks[i].rounds = 0;
+        tasks[i].generation = 0;
+        tasks[i].next = -1;
+        tasks[i].active = false;
+    }
+    for (uint16_t s = 0; s < SCHEDULER_WHEEL_SLOTS; s++) {
+        wheel[s] = -1;
+    }
+}
+
+Scheduler::TaskId Scheduler::scheduleOnce(unsigned long delayMs, TaskFn fn, void* ctx) {
+    return schedule(delayMs, 0, fn, ctx);
+}
+
+Scheduler::TaskId Scheduler::schedulePeriodic(unsigned long periodMs, TaskFn fn, void* ctx,
+                                              unsigned long firstDelayMs) {
+    if (periodMs == 0) {
+        return INVALID_TASK;
+    }
+    return schedule(firstDelayMs, periodMs, fn, ctx);
+}
+
+Scheduler::TaskId Scheduler::schedule(unsigned long delayMs, unsigned long periodMs, TaskFn fn, void* ctx) {
+    if (fn == nullptr) {
+        return INVALID_TASK;
+    }
+
+    unsigned long now = millis();
+    if (!started) {
+        lastNowMs = now;
+        started = true;
+    }
+
+    for (int8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        Task& t = tasks[i];
+        if (t.active) {
+            continue;
+        }
+        t.fn = fn;
+        t.ctx = ctx;
+        t.periodMs = periodMs;
+        t.dueMs = now + delayMs;
+        t.active = true;
+        insert(i, (int32_t)(t.dueMs - lastNowMs));
+        return (TaskId)(((uint16_t)t.generation << 8) | (uint16_t)(i + 1));
+    }
+
+    LOG(SCHEDULER_TABLE_FULL);
+    return INVALID_TASK;
+}
+
+bool Scheduler::cancel(TaskId id) {
+    int8_t i = indexOf(id);
+    if (i < 0) {
+        return false;
+    }
+    unlink(i);
+    tasks[i].active = false;
+    tasks[i].generation++;
+    return true;
+}
+
+bool Scheduler::isScheduled(TaskId id) const {
+    return indexOf(id) >= 0;
+}
+
+void Scheduler::tick(unsigned long nowMs) {
+    if (!started) {
+        lastNowMs = nowMs;
+        started = true;
+        return;
+    }
+
+    // Whole ticks elapsed since the last one processed; the remainder carries over.
+    // Unsigned difference, so the wheel keeps turning across the millis() wrap.
+    while ((uint32_t)(nowMs - lastNowMs) >= SCHEDULER_TICK_MS) {
+        currentTick++;
+        lastNowMs += SCHEDULER_TICK_MS;
+        uint16_t slot = currentTick % SCHEDULER_WHEEL_SLOTS;
+
+        // Pass 1: detach due tasks from the slot, count down the rest.
+        // Due tasks are run in pass 2 so callbacks may freely (re)schedule and cancel.
+        int8_t due[SCHEDULER_MAX_TASKS];
+        uint8_t dueGeneration[SCHEDULER_MAX_TASKS];
+        uint8_t dueCount = 0;
+
+        int8_t* link = &wheel[slot];
+        while (*link >= 0) {
+            Task& t = tasks[*link];
+            if (t.rounds > 0) {
+                t.rounds--;
+                link = &t.next;
+                continue;
+            }
+            due[dueCount] = *link;
+            dueGeneration[dueCount] = t.generation;
+            dueCount++;
+            *link = t.next;
+            t.next = -1;
+        }
+
+        // Pass 2: run due tasks
+        for (uint8_t k = 0; k < dueCount; k++) {
+            Task& t = tasks[due[k]];
+            if (!t.active || t.generation != dueGeneration[k]) {
+                continue;  // cancelled or reused by an earlier callback
+            }
+            TaskFn fn = t.fn;
+            void* ctx = t.ctx;
+            if (t.periodMs > 0) {
+                uint32_t nextDue = t.dueMs + t.periodMs;
+                if ((int32_t)(nextDue - (uint32_t)nowMs) <= 0) {
+                    nextDue = nowMs + t.periodMs;  // fell behind: skip missed periods
+                }
+                t.dueMs = nextDue;
+                insert(due[k], (int32_t)(nextDue - lastNowMs));
+            } else {
+                t.active = false;
+                t.generation++;
+            }
+            fn(ctx);
+        }
+    }
+}
+
+unsigned long Scheduler::msUntilNextDue(unsigned long nowMs, unsigned long maxMs) const {
+    unsigned long best = maxMs;
+    for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        const Task& t = tasks[i];
+        if (!t.active) {
+            continue;
+        }
+        int32_t remaining = (int32_t)(t.dueMs - (uint32_t)nowMs);
+        if (remaining <= 0) {
+            return 0;
+        }
+        if ((unsigned long)remaining < best) {
+            best = (unsigned long)remaining;
+        }
+    }
+    return best;
+}
+
+void Scheduler::insert(int8_t index, int32_t delayMs) {
+    Task& t = tasks[index];
+    uint32_t ticks = delayMs > 0 ? (uint32_t)delayMs / SCHEDULER_TICK_MS : 0;
+    if (ticks == 0) {
+        ticks = 1;  // already due: run on the next tick
+    }
+    uint32_t target = currentTick + ticks;
+    t.rounds = (uint16_t)((ticks - 1) / SCHEDULER_WHEEL_SLOTS);
+
+    uint16_t slot = target % SCHEDULER_WHEEL_SLOTS;
+    t.next = wheel[slot];
+    wheel[slot] = index;
+}
+
+void Scheduler::unlink(int8_t index) {
+    // The task may sit in any slot after catch-up; wheels are small, so scan.
+    for (uint16_t s = 0; s < SCHEDULER_WHEEL_SLOTS; s++) {
+        int8_t* link = &wheel[s];
+        while (*link >= 0) {
+            if (*link == index) {
+                *link = tasks[index].next;
+                tasks[index].next = -1;
+                return;
+            }
+            link = &tasks[*link].next;
+        }
+    }
+}
+
+int8_t Scheduler::indexOf(TaskId id) const {
+    if (id == INVALID_TASK) {
+        return -1;
+    }
+    int16_t index = (int16_t)(id & 0xFF) - 1;
+    if (index < 0 || index >= SCHEDULER_MAX_TASKS) {
+        return -1;
+    }
+    const Task& t = tasks[index];
+    if (!t.active || t.generation != (uint8_t)(id >> 8)) {
+        return -1;
+    }
+    return (int8_t)index;
+}
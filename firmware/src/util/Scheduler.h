@@ -0,0 +1,83 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "config/config.h"
+
+/**
+ * Cooperative scheduler backed by a hashed timer wheel.
+ * One-shot and periodic tasks run from tick(), on the caller's task, so task
+ * functions must not block. Not thread-safe: use from a single task.
+ */
+class Scheduler {
+public:
+    typedef void (*TaskFn)(void* ctx);
+
+    // Task handle (slot index + generation); INVALID_TASK is never returned for a scheduled task
+    typedef uint16_t TaskId;
+    static const TaskId INVALID_TASK = 0;
+
+    Scheduler();
+
+    /**
+     * Run fn once, delayMs from now.
+     * Returns INVALID_TASK if the task table is full.
+     */
+    TaskId scheduleOnce(unsigned long delayMs, TaskFn fn, void* ctx = nullptr);
+
+    /**
+     * Run fn every periodMs; first run is firstDelayMs from now.
+     * Returns INVALID_TASK if the task table is full.
+     */
+    TaskId schedulePeriodic(unsigned long periodMs, TaskFn fn, void* ctx = nullptr,
+                            unsigned long firstDelayMs = 0);
+
+    /**
+     * Cancel a task. Safe to call with a stale or INVALID_TASK id.
+     * Returns true if a scheduled task was removed.
+     */
+    bool cancel(TaskId id);
+
+    /**
+     * Check if a task is still scheduled (one-shot tasks stop being scheduled once they run).
+     */
+    bool isScheduled(TaskId id) const;
+
+    /**
+     * Advance the wheel to nowMs and run every task that became due.
+     * Call this from the owning task's loop.
+     */
+    void tick(unsigned long nowMs);
+
+    /**
+     * Milliseconds until the next task is due (0 if one is already due),
+     * capped at maxMs. Use to sleep/yield between loop passes.
+     */
+    unsigned long msUntilNextDue(unsigned long nowMs, unsigned long maxMs) const;
+
+private:
+    struct Task {
+        TaskFn fn;
+        void* ctx;
+        uint32_t periodMs;   // 0 for one-shot
+        uint32_t dueMs;
+        uint16_t rounds;     // full wheel revolutions left before the task is due
+        uint8_t generation;
+        int8_t next;         // next task in the same wheel slot (-1 = end)
+        bool active;
+    };
+
+    TaskId schedule(unsigned long delayMs, unsigned long periodMs, TaskFn fn, void* ctx);
+    void insert(int8_t index, int32_t delayMs);  // delayMs from the last tick processed
+    void unlink(int8_t index);
+    int8_t indexOf(TaskId id) const;
+
+    Task tasks[SCHEDULER_MAX_TASKS];
+    int8_t wheel[SCHEDULER_WHEEL_SLOTS];  // head of the task list for each slot
+    uint32_t currentTick;                  // ticks processed (free-running, only used modulo the wheel)
+    uint32_t lastNowMs;                    // millis() at which currentTick was reached
+    bool started;
+};
+
+#endif // SCHEDULER_H
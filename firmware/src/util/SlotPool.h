@@ -0,0 +1,70 @@
+#ifndef SLOT_POOL_H
+#define SLOT_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * Fixed pool of preallocated slots with lock-free acquire/release.
+ * Any task may acquire or release; a slot is owned by whoever holds its index
+ * until it is released (hand it between tasks through a ring). At most 32 slots.
+ */
+template <typename T, size_t N>
+class SlotPool {
+    static_assert(N >= 1 && N <= 32, "SlotPool supports 1..32 slots");
+
+public:
+    static const int8_t NO_SLOT = -1;
+
+    SlotPool() : used(0) {}
+
+    /**
+     * Take a free slot. Returns its index, or NO_SLOT if the pool is exhausted.
+     */
+    int8_t acquire() {
+        uint32_t mask = used.load(std::memory_order_relaxed);
+        for (;;) {
+            uint32_t freeBits = ~mask & ALL_SLOTS;
+            if (freeBits == 0) {
+                return NO_SLOT;
+            }
+            int8_t index = (int8_t)__builtin_ctz(freeBits);
+            if (used.compare_exchange_weak(mask, mask | (1UL << index),
+                                           std::memory_order_acquire, std::memory_order_relaxed)) {
+                return index;
+            }
+        }
+    }
+
+    /**
+     * Return a slot to the pool. The caller must own it.
+     */
+    void release(int8_t index) {
+        if (index < 0 || (size_t)index >= N) {
+            return;
+        }
+        used.fetch_and(~(1UL << index), std::memory_order_release);
+    }
+
+    T& get(int8_t index) {
+        return slots[index];
+    }
+
+    /** Number of slots currently acquired. */
+    size_t inUse() const {
+        return __builtin_popcount(used.load(std::memory_order_relaxed));
+    }
+
+    static size_t capacity() {
+        return N;
+    }
+
+private:
+    static const uint32_t ALL_SLOTS = (uint32_t)(0xFFFFFFFFULL >> (32 - N));
+
+    T slots[N];
+    std::atomic<uint32_t> used;  // bit i set = slot i acquired
+};
+
+#endif // SLOT_POOL_H
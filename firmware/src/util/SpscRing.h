@@ -0,0 +1,69 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+/**
+ * Lock-free single-producer / single-consumer ring buffer.
+ * Exactly one task may call push() and exactly one (other) task may call pop().
+ * Capacity must be a power of two; items are copied in and out by value.
+ */
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    /**
+     * Producer side: copy item into the ring.
+     * Returns false if the ring is full (item not queued).
+     */
+    bool push(const T& item) {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        const uint32_t t = tail.load(std::memory_order_acquire);
+        if (h - t >= N) {
+            return false;
+        }
+        slots[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer side: copy the oldest item out of the ring.
+     * Returns false if the ring is empty.
+     */
+    bool pop(T& out) {
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        const uint32_t h = head.load(std::memory_order_acquire);
+        if (h == t) {
+            return false;
+        }
+        out = slots[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Approximate number of queued items (exact when called from either endpoint). */
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    static size_t capacity() {
+        return N;
+    }
+
+private:
+    T slots[N];
+    std::atomic<uint32_t> head;  // next write position (producer-owned)
+    std::atomic<uint32_t> tail;  // next read position (consumer-owned)
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,118 @@
+#include "WarmBoot.h"
+#include <stddef.h>
+#include <string.h>
+#include "esp_system.h"
+#include "Log.h"
+
+#define WARM_BOOT_MAGIC 0x50475257UL  // "PGRW"
+
+// Handoff record layout (RTC_NOINIT_ATTR: not cleared by the bootloader on soft resets)
+struct WarmBootRecord {
+    uint32_t magic;
+    uint32_t bootCount;
+    uint8_t lastResetReason;
+    uint8_t modemReady;
+    uint8_t pppUp;
+    uint8_t mqttConnected;
+    uint8_t mqttClientIndex;
+    uint8_t reserved[3];
+    uint32_t checksum;
+};
+
+static RTC_NOINIT_ATTR WarmBootRecord record;
+
+static bool warmBoot = false;
+static uint8_t resetReason = 0;
+static bool reuseModem = false;
+static bool reusePpp = false;
+static bool reuseMqtt = false;
+static uint8_t reuseMqttClientIndex = 0;
+
+uint32_t WarmBoot::checksum() {
+    // FNV-1a over everything but the checksum field
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&record);
+    uint32_t h = 2166136261UL;
+    for (size_t i = 0; i < offsetof(WarmBootRecord, checksum); i++) {
+        h ^= p[i];
+        h *= 16777619UL;
+    }
+    return h;
+}
+
+void WarmBoot::begin() {
+    resetReason = (uint8_t)esp_reset_reason();
+
+    bool valid = record.magic == WARM_BOOT_MAGIC && record.checksum == checksum();
+    bool softReset = resetReason != ESP_RST_POWERON &&
+                     resetReason != ESP_RST_BROWNOUT &&
+                     resetReason != ESP_RST_UNKNOWN;
+
+    warmBoot = WARM_BOOT_ENABLED && valid && softReset;
+    if (warmBoot) {
+        reuseModem = record.modemReady != 0;
+        reusePpp = reuseModem && record.pppUp != 0;
+        reuseMqtt = reusePpp && record.mqttConnected != 0;
+        reuseMqttClientIndex = record.mqttClientIndex;
+        record.bootCount++;
+    } else {
+        record.magic = WARM_BOOT_MAGIC;
+        record.bootCount = 0;
+    }
+
+    // Until this boot reports otherwise, nothing is known to be up
+    record.lastResetReason = resetReason;
+    record.modemReady = 0;
+    record.pppUp = 0;
+    record.mqttConnected = 0;
+    record.mqttClientIndex = 0;
+    memset(record.reserved, 0, sizeof(record.reserved));
+    record.checksum = checksum();
+
+    if (warmBoot) {
+        LOG(WARMBOOT_WARM, (unsigned)resetReason, (unsigned long)record.bootCount, reuseModem ? "up" : "down",
+            reusePpp ? "up" : "down", reuseMqtt ? "up" : "down");
+    } else {
+        LOG(WARMBOOT_COLD, (unsigned)resetReason);
+    }
+}
+
+bool WarmBoot::isWarmBoot() {
+    return warmBoot;
+}
+
+uint8_t WarmBoot::getResetReason() {
+    return resetReason;
+}
+
+bool WarmBoot::takeModemReuse() {
+    bool r = reuseModem;
+    reuseModem = false;
+    return r;
+}
+
+bool WarmBoot::takePppReuse() {
+    bool r = reusePpp;
+    reusePpp = false;
+    return r;
+}
+
+bool WarmBoot::takeMqttReuse(uint8_t& clientIndex) {
+    bool r = reuseMqtt;
+    reuseMqtt = false;
+    clientIndex = reuseMqttClientIndex;
+    return r;
+}
+
+void WarmBoot::recordState(bool modemReady, bool pppUp, bool mqttConnected, uint8_t mqttClientIndex) {
+    if (record.modemReady == (uint8_t)modemReady &&
+        record.pppUp == (uint8_t)pppUp &&
+        record.mqttConnected == (uint8_t)mqttConnected &&
+        record.mqttClientIndex == mqttClientIndex) {
+        return;
+    }
+    record.modemReady = modemReady;
+    record.pppUp = pppUp;
+    record.mqttConnected = mqttConnected;
+    record.mqttClientIndex = mqttClientIndex;
+    record.checksum = checksum();
+}
@@ -0,0 +1,50 @@
+#ifndef WARM_BOOT_H
+#define WARM_BOOT_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "config/config.h"
+
+/**
+ * Warm-reboot handoff record kept in RTC slow memory (survives esp_restart,
+ * panics and watchdog resets, lost on power-on/brownout).
+ * Lets the next boot reuse a modem / data session / modem MQTT client that
+ * is still up instead of power-cycling the modem and re-registering.
+ * Only used from setup() and the network task.
+ */
+class WarmBoot {
+public:
+    /**
+     * Validate the handoff record and decide what can be reused (call once, early in setup).
+     */
+    static void begin();
+
+    /**
+     * True if this boot followed an ESP32-only reset with a valid handoff record.
+     */
+    static bool isWarmBoot();
+
+    /**
+     * Reset reason of the current boot (esp_reset_reason()).
+     */
+    static uint8_t getResetReason();
+
+    /**
+     * One-shot reuse hints: return true at most once per boot, and only if the
+     * previous boot recorded that layer as up. Callers must still probe the modem.
+     */
+    static bool takeModemReuse();
+    static bool takePppReuse();
+    static bool takeMqttReuse(uint8_t& clientIndex);
+
+    /**
+     * Record the current connectivity state for the next boot.
+     * Cheap when nothing changed; call every network loop pass.
+     */
+    static void recordState(bool modemReady, bool pppUp, bool mqttConnected, uint8_t mqttClientIndex);
+
+private:
+    static uint32_t checksum();
+};
+
+#endif // WARM_BOOT_H
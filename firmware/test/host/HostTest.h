@@ -0,0 +1,36 @@
+// Tiny assertion helpers shared by the host tests (no framework dependency).
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            hostTestFailures++;                                             \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_EQ(expected, actual)                                                  \
+    do {                                                                            \
+        long long e_ = (long long)(expected), a_ = (long long)(actual);             \
+        if (e_ != a_) {                                                             \
+            printf("%s:%d: CHECK_EQ failed: %s == %s (%lld != %lld)\n", __FILE__,   \
+                   __LINE__, #expected, #actual, e_, a_);                           \
+            hostTestFailures++;                                                     \
+        }                                                                           \
+    } while (0)
+
+static inline int hostTestResult(const char* name) {
+    if (hostTestFailures == 0) {
+        printf("%s: OK\n", name);
+        return 0;
+    }
+    printf("%s: %d failure(s)\n", name, hostTestFailures);
+    return 1;
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,233 @@
+// Cmux against a scripted 27.010 peer: SABM/UA, UIH demux, MSC, DISC, close-down.
+#include "HostTest.h"
+#include "modem/Cmux.h"
+#include "modem/ModemStream.h"
+#include <string>
+#include <vector>
+
+// Bytes the peer (modem) sends are read from `in`; bytes Cmux sends land in `out`
+class PeerSerial : public HardwareSerial {
+public:
+    PeerSerial() : HardwareSerial(1), pos(0) {}
+    int available() override { return (int)(in.size() - pos); }
+    int read() override { return pos < in.size() ? (uint8_t)in[pos++] : -1; }
+    size_t read(uint8_t* buffer, size_t size) override {
+        size_t n = std::min(size, in.size() - pos);
+        memcpy(buffer, in.data() + pos, n);
+        pos += n;
+        return n;
+    }
+    size_t write(uint8_t c) override {
+        out += (char)c;
+        return 1;
+    }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        out.append((const char*)buffer, size);
+        return size;
+    }
+    using Print::write;
+
+    std::string in;
+    std::string out;
+
+private:
+    size_t pos;
+};
+
+struct Frame {
+    uint8_t dlci;
+    uint8_t control;  // P/F included
+    bool command;     // C/R bit
+    std::string data;
+};
+
+static const uint8_t SABM = 0x3F;  // with P/F
+static const uint8_t UA = 0x73;
+static const uint8_t DM = 0x1F;
+static const uint8_t DISC = 0x53;
+static const uint8_t UIH = 0xEF;
+
+static uint8_t crc8(uint8_t crc, uint8_t b) {
+    crc ^= b;
+    for (int i = 0; i < 8; i++) {
+        crc = (crc & 1) ? (crc >> 1) ^ 0xE0 : crc >> 1;
+    }
+    return crc;
+}
+
+// A frame as the modem sends it: C/R set for its commands, cleared for responses
+static std::string frame(uint8_t dlci, uint8_t control, const std::string& data = "", bool command = false) {
+    std::string f(1, (char)0xF9);
+    f += (char)((dlci << 2) | (command ? 2 : 0) | 1);
+    f += (char)control;
+    f += (char)((data.size() << 1) | 1);
+    uint8_t fcs = 0xFF;
+    for (size_t i = 1; i < f.size(); i++) {
+        fcs = crc8(fcs, (uint8_t)f[i]);
+    }
+    f += data;
+    f += (char)(0xFF - fcs);
+    f += (char)0xF9;
+    return f;
+}
+
+// Split what Cmux sent into frames, checking flags, length and FCS of each
+static std::vector<Frame> takeFrames(PeerSerial& peer) {
+    std::vector<Frame> frames;
+    const std::string& s = peer.out;
+    size_t i = 0;
+    while (i < s.size()) {
+        CHECK_EQ(0xF9, (uint8_t)s[i]);
+        if (i + 5 >= s.size()) {
+            CHECK(false);
+            break;
+        }
+        Frame f;
+        uint8_t address = s[i + 1];
+        f.dlci = address >> 2;
+        f.command = (address & 2) != 0;
+        f.control = s[i + 2];
+        size_t len = (uint8_t)s[i + 3] >> 1;
+        CHECK((uint8_t)s[i + 3] & 1);
+        f.data = s.substr(i + 4, len);
+        uint8_t fcs = 0xFF;
+        for (size_t k = i + 1; k < i + 4; k++) {
+            fcs = crc8(fcs, (uint8_t)s[k]);
+        }
+        CHECK_EQ(0xCF, crc8(fcs, (uint8_t)s[i + 4 + len]));
+        CHECK_EQ(0xF9, (uint8_t)s[i + 5 + len]);
+        frames.push_back(f);
+        i += 6 + len;
+    }
+    peer.out.clear();
+    return frames;
+}
+
+static std::string readAll(Stream& stream) {
+    std::string s;
+    int c;
+    while ((c = stream.read()) >= 0) {
+        s += (char)c;
+    }
+    return s;
+}
+
+int main() {
+    PeerSerial peer;
+    Cmux mux(peer);
+
+    // Control channel first, data channels once it is acknowledged
+    mux.begin();
+    std::vector<Frame> sent = takeFrames(peer);
+    CHECK_EQ(1, sent.size());
+    CHECK(sent[0].dlci == 0 && sent[0].control == SABM && sent[0].command);
+
+    peer.in += frame(0, UA);
+    mux.poll();
+    sent = takeFrames(peer);
+    CHECK_EQ(CMUX_CHANNELS, sent.size());
+    for (size_t k = 0; k < sent.size(); k++) {
+        CHECK(sent[k].dlci == k + 1 && sent[k].control == SABM);
+    }
+    CHECK(!mux.isOpen());
+
+    // One channel refused, then both accepted; each open channel announces its V.24 state
+    peer.in += frame(CMUX_DLCI_MAIN, UA) + frame(CMUX_DLCI_AUX, DM);
+    mux.poll();
+    CHECK(!mux.isOpen());
+    takeFrames(peer);
+    peer.in += frame(CMUX_DLCI_AUX, UA);
+    mux.poll();
+    CHECK(mux.isOpen());
+    sent = takeFrames(peer);
+    CHECK_EQ(1, sent.size());
+    CHECK(sent[0].dlci == 0 && sent[0].control == UIH && sent[0].data.size() == 4);
+    CHECK_EQ(0xE3, (uint8_t)sent[0].data[0]);  // MSC command
+
+    // The modem's MSC is answered with the same values as a response
+    std::string msc = std::string("\xE3\x05", 2) + (char)((CMUX_DLCI_MAIN << 2) | 3) + (char)0x0D;
+    peer.in += frame(0, UIH, msc, true);
+    mux.poll();
+    sent = takeFrames(peer);
+    CHECK_EQ(1, sent.size());
+    CHECK(sent[0].data.size() == 4 && (uint8_t)sent[0].data[0] == 0xE1 && sent[0].data.substr(1) == msc.substr(1));
+
+    // Writes go out as UIH frames on their own DLCI
+    ModemLinkState link;
+    ModemStream main(peer, link);
+    ModemStream aux(peer, link);
+    main.setChannel(&mux.channel(CMUX_DLCI_MAIN));
+    aux.setChannel(&mux.channel(CMUX_DLCI_AUX));
+    aux.print("AT+CSQ\r\n");
+    mux.poll();
+    sent = takeFrames(peer);
+    CHECK_EQ(1, sent.size());
+    CHECK(sent[0].dlci == CMUX_DLCI_AUX && sent[0].control == UIH && sent[0].data == "AT+CSQ\r\n");
+
+    // Interleaved frames reach their channel; a frame with a bad FCS is dropped
+    std::string bad = frame(CMUX_DLCI_MAIN, UIH, "junk");
+    bad[bad.size() - 2] ^= 1;
+    peer.in += frame(CMUX_DLCI_AUX, UIH, "\r\n+CSQ: 20,99\r\n") +
+               frame(CMUX_DLCI_MAIN, UIH, "\r\n+CMQTTCONNLOST: 0,1\r\n") + bad +
+               frame(CMUX_DLCI_AUX, UIH, "\r\nOK\r\n");
+    aux.beginResponse(nullptr);
+    while (aux.responseResult() == AT_RESULT_PENDING && aux.read() >= 0) {
+    }
+    CHECK_EQ(AT_RESULT_OK, aux.responseResult());
+    aux.endResponse();
+    CHECK_EQ(0, link.mqttConnLost);  // main channel not read yet
+    CHECK(readAll(main) == "\r\n+CMQTTCONNLOST: 0,1\r\n");
+    CHECK_EQ(1, link.mqttConnLost);
+
+    // A long write is split into frames of at most CMUX_FRAME_MAX bytes
+    std::string payload(2 * CMUX_FRAME_MAX + 8, 'y');
+    mux.channel(CMUX_DLCI_MAIN).write((const uint8_t*)payload.data(), payload.size());
+    mux.channel(CMUX_DLCI_MAIN).flush();
+    sent = takeFrames(peer);
+    CHECK_EQ(3, sent.size());
+    std::string joined;
+    for (size_t k = 0; k < sent.size(); k++) {
+        CHECK(sent[k].data.size() <= CMUX_FRAME_MAX);
+        joined += sent[k].data;
+    }
+    CHECK(joined == payload);
+
+    // Filling a channel's ring asks the modem to stop (MSC FC), draining it resumes
+    std::string chunk(100, 'x');
+    for (size_t total = 0; total < CMUX_CHANNEL_RX * 3 / 4; total += chunk.size()) {
+        peer.in += frame(CMUX_DLCI_MAIN, UIH, chunk);
+    }
+    mux.poll();
+    sent = takeFrames(peer);
+    CHECK_EQ(1, sent.size());
+    CHECK(sent[0].dlci == 0 && sent[0].data.size() == 4 && ((uint8_t)sent[0].data[3] & 0x02));
+    readAll(mux.channel(CMUX_DLCI_MAIN));
+    sent = takeFrames(peer);
+    CHECK_EQ(1, sent.size());
+    CHECK(sent[0].data.size() == 4 && ((uint8_t)sent[0].data[3] & 0x02) == 0);
+    CHECK_EQ(0, mux.channel(CMUX_DLCI_MAIN).getDroppedCount());
+
+    // DISC on a data channel: acknowledged, channel closed
+    peer.in += frame(CMUX_DLCI_AUX, DISC, "", true);
+    mux.poll();
+    sent = takeFrames(peer);
+    CHECK_EQ(1, sent.size());
+    CHECK(sent[0].dlci == CMUX_DLCI_AUX && sent[0].control == UA);
+    CHECK(!mux.channel(CMUX_DLCI_AUX).isOpen());
+    CHECK(!mux.isOpen());
+
+    // DISC on the control channel closes everything
+    peer.in += frame(0, DISC, "", true);
+    mux.poll();
+    sent = takeFrames(peer);
+    CHECK_EQ(1, sent.size());
+    CHECK(sent[0].dlci == 0 && sent[0].control == UA);
+    CHECK(!mux.channel(CMUX_DLCI_MAIN).isOpen());
+
+    // Close-down is the fixed CLD frame
+    mux.close();
+    const uint8_t cld[] = {0xF9, 0x03, 0xEF, 0x05, 0xC3, 0x01, 0xF2, 0xF9};
+    CHECK(peer.out == std::string((const char*)cld, sizeof(cld)));
+
+    return hostTestResult("cmux_loopback");
+}
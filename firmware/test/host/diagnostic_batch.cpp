@@ -0,0 +1,55 @@
+// Diagnostic upload batches: delivery removes only the uploaded entries, even
+// when the journal dropped old entries to make room in the meantime.
+#include "HostTest.h"
+#include "util/DiagnosticLog.h"
+#include <Preferences.h>
+
+static uint32_t argOf(DiagnosticLog& log, size_t index) {
+    uint32_t ts;
+    uint8_t level;
+    char event[DIAG_EVENT_LEN];
+    char message[DIAG_MESSAGE_LEN];
+    if (!log.getEntry(index, &ts, &level, event, sizeof(event), message, sizeof(message))) {
+        return 0;
+    }
+    const char* eq = strchr(message, '=');
+    return eq != nullptr ? (uint32_t)strtoul(eq + 1, nullptr, 10) : 0;
+}
+
+int main() {
+    Preferences::hostErase();
+    hostSetMillis(1000);
+    DiagnosticLog log;
+
+    uint32_t next = 1;
+    for (int i = 0; i < 20; i++) {
+        log.append(DIAG_EVENT_INIT_RETRY, next++);
+    }
+
+    // Batch of the first 10 entries, as the upload timer builds it
+    uint32_t end = log.getFirstSeq() + 10;
+
+    // Before its PUBACK, enough is logged for the journal to drop its oldest blocks
+    while (argOf(log, 0) <= 10) {
+        hostSetMillis(millis() + 1000);
+        log.append(DIAG_EVENT_INIT_RETRY, next++);
+    }
+    uint32_t oldest = argOf(log, 0);
+    size_t count = log.getEntryCount();
+
+    log.removeBefore(end);
+    CHECK_EQ(count, log.getEntryCount());
+    CHECK_EQ(oldest, argOf(log, 0));
+
+    // Normal case: exactly the batch goes
+    end = log.getFirstSeq() + 3;
+    log.removeBefore(end);
+    CHECK_EQ(count - 3, log.getEntryCount());
+    CHECK_EQ(oldest + 3, argOf(log, 0));
+
+    // Delivered twice (or a stale tag): nothing more is removed
+    log.removeBefore(end);
+    CHECK_EQ(count - 3, log.getEntryCount());
+
+    return hostTestResult("diagnostic_batch");
+}
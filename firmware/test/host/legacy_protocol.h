@@ -0,0 +1,99 @@
+// The ArduinoJson implementation Protocol replaced, kept as the reference for
+// the host benchmark and the output comparison. Needs ArduinoJson 6 (see Makefile).
+#ifndef LEGACY_PROTOCOL_H
+#define LEGACY_PROTOCOL_H
+
+#include <ArduinoJson.h>
+#include "protocol/Protocol.h"
+
+namespace legacy {
+
+inline bool parseCommand(const char* json, size_t len, CommandResult& result) {
+    result = CommandResult();
+
+    StaticJsonDocument<512> doc;
+    DeserializationError error = deserializeJson(doc, json, len);
+    if (error) {
+        return false;
+    }
+
+    if (!doc.containsKey("requestId") || !doc["requestId"].is<const char*>()) {
+        return false;
+    }
+    strncpy(result.requestId, doc["requestId"].as<const char*>(), sizeof(result.requestId) - 1);
+    result.requestId[sizeof(result.requestId) - 1] = '\0';
+
+    if (!doc.containsKey("command") || !doc["command"].is<const char*>()) {
+        return false;
+    }
+    if (!doc.containsKey("userId") || !doc["userId"].is<const char*>()) {
+        return false;
+    }
+    if (!doc.containsKey("issuedAt") || (!doc["issuedAt"].is<long long>() &&
+                                         !doc["issuedAt"].is<unsigned long long>() &&
+                                         !doc["issuedAt"].is<double>())) {
+        return false;
+    }
+
+    strncpy(result.command, doc["command"].as<const char*>(), sizeof(result.command) - 1);
+    result.command[sizeof(result.command) - 1] = '\0';
+    strncpy(result.userId, doc["userId"].as<const char*>(), sizeof(result.userId) - 1);
+    result.userId[sizeof(result.userId) - 1] = '\0';
+
+    if (doc["issuedAt"].is<unsigned long long>()) {
+        result.issuedAt = doc["issuedAt"].as<unsigned long long>();
+    } else if (doc["issuedAt"].is<long long>()) {
+        result.issuedAt = static_cast<unsigned long long>(doc["issuedAt"].as<long long>());
+    } else {
+        result.issuedAt = static_cast<unsigned long long>(doc["issuedAt"].as<double>());
+    }
+    result.valid = true;
+    return true;
+}
+
+inline size_t createAck(const char* requestId, bool ok, const char* errorCode,
+                        char* output, size_t outputSize,
+                        uint32_t retryAfterMs = 0, unsigned long long scheduledAt = 0) {
+    StaticJsonDocument<256> doc;
+    doc["requestId"] = requestId;
+    doc["ok"] = ok;
+    if (!ok && errorCode != nullptr) {
+        doc["errorCode"] = errorCode;
+    }
+    if (retryAfterMs != 0) {
+        doc["retryAfterMs"] = retryAfterMs;
+    }
+    if (scheduledAt != 0) {
+        doc["scheduledAt"] = scheduledAt;
+    }
+    return serializeJson(doc, output, outputSize);
+}
+
+inline size_t createStatus(const char* deviceId, bool online, unsigned long updatedAt,
+                           int rssi, const char* fwVersion, char* output, size_t outputSize,
+                           long errors = -1, long outboxDepth = -1, long outboxAgeMs = -1) {
+    StaticJsonDocument<256> doc;
+    doc["deviceId"] = deviceId;
+    doc["online"] = online;
+    doc["updatedAt"] = updatedAt;
+    if (rssi != 0) {
+        doc["rssi"] = rssi;
+    }
+    if (fwVersion != nullptr) {
+        doc["fwVersion"] = fwVersion;
+    }
+    if (errors >= 0) {
+        doc["errors"] = errors;
+    }
+    if (outboxDepth >= 0) {
+        doc["outboxDepth"] = outboxDepth;
+    }
+    if (outboxAgeMs >= 0) {
+        doc["outboxAgeMs"] = outboxAgeMs;
+    }
+    return serializeJson(doc, output, outputSize);
+}
+
+}  // namespace legacy
+
+#endif // LEGACY_PROTOCOL_H
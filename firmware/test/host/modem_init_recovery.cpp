@@ -0,0 +1,167 @@
+// ModemManager init recovering a running modem: a failed ATE0 and a CMUX that never
+// opens both restart it with the reset pin before the power key pulse.
+#include "HostTest.h"
+#include "modem/ModemManager.h"
+#include "util/BootReport.h"
+#include "util/WarmBoot.h"
+#include <Preferences.h>
+#include <string>
+#include <vector>
+
+void BootReport::mark(BootPhase phase) {
+    (void)phase;
+}
+
+bool WarmBoot::takeModemReuse() {
+    return true;
+}
+
+/**
+ * A7670 as seen from its UART and control pins. The power key toggles it on or
+ * off; the reset pin restarts it (off until the power key, as on the board).
+ * Answers AT commands while on and not multiplexing; never answers CMUX frames.
+ */
+class FakeModem : public HostUartPeer {
+public:
+    FakeModem() : on(true), failEcho(false), muxing(false), pos(0) {}
+
+    int pending() override { return (int)(in.size() - pos); }
+    int receive() override { return pos < in.size() ? (uint8_t)in[pos++] : -1; }
+    int peekNext() override { return pos < in.size() ? (uint8_t)in[pos] : -1; }
+    void transmit(uint8_t c) override {
+        if (!on || muxing) {
+            return;
+        }
+        if (c != '\n') {
+            line += (char)c;
+            return;
+        }
+        if (!line.empty() && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1);
+        }
+        answer(line);
+        line.clear();
+    }
+
+    void pin(int pin, int value) {
+        if (pin == MODEM_RESET_PIN || pin == BOARD_PWRKEY_PIN) {
+            events.push_back(pin);
+        }
+        if (pin == MODEM_RESET_PIN && value == MODEM_RESET_LEVEL) {
+            on = false;
+            muxing = false;
+        } else if (pin == BOARD_PWRKEY_PIN && value == HIGH) {
+            on = !on;
+            muxing = false;
+            if (on) {
+                in += "\r\nRDY\r\n";
+            }
+        }
+    }
+
+    bool on;
+    bool failEcho;
+    bool muxing;
+    std::vector<int> events;    // reset and power key writes, in order
+
+private:
+    void answer(const std::string& cmd) {
+        if (cmd == "ATE0" && failEcho) {
+            in += "\r\nERROR\r\n";
+            return;
+        }
+        in += "\r\nOK\r\n";
+        if (cmd == "AT+CMUX=0") {
+            muxing = true;
+        }
+    }
+
+    std::string in;
+    std::string line;
+    size_t pos;
+};
+
+static FakeModem* modem = nullptr;
+
+static void onPin(int pin, int value) {
+    modem->pin(pin, value);
+}
+
+// Index of the first write to pin, -1 if none
+static int firstWrite(int pin) {
+    for (size_t i = 0; i < modem->events.size(); i++) {
+        if (modem->events[i] == pin) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// Run init until it reports ready or limitMs passes; returns the time it took
+static unsigned long runInit(ModemManager& mm, unsigned long limitMs) {
+    unsigned long start = millis();
+    while (millis() - start < limitMs) {
+        if (mm.init()) {
+            return millis() - start;
+        }
+        mm.poll();
+        hostSetMillis(millis() + 10);
+    }
+    return limitMs;
+}
+
+// Warm boot on a running modem; the first init attempt fails as set up by the caller
+static void recovers(const char* name, bool failEcho, bool failCmux) {
+    FakeModem fake;
+    modem = &fake;
+    fake.failEcho = failEcho;
+    hostAttachUart(1, &fake);
+    hostOnDigitalWrite(onPin);
+    hostSetMillis(1000);
+
+    // Negotiation has given up on every faster rate: stay at the default
+    Preferences prefs;
+    prefs.begin("pgr_modem", false);
+    prefs.putUChar("step", 3);
+    prefs.end();
+
+    ModemManager mm;
+
+    // Up to the first failure neither the reset pin nor the power key is touched
+    unsigned long start = millis();
+    while (millis() - start < 20000 && fake.events.empty()) {
+        mm.init();
+        mm.poll();
+        hostSetMillis(millis() + 10);
+    }
+    CHECK(!fake.events.empty());
+    fake.failEcho = false;  // works once the modem has restarted
+
+    unsigned long took = runInit(mm, 60000);
+    if (!mm.isReady()) {
+        printf("%s: not ready after recovery\n", name);
+        hostTestFailures++;
+    }
+    // Reset first: the power key pulse alone would switch the running modem off
+    int reset = firstWrite(MODEM_RESET_PIN);
+    int pwrkey = firstWrite(BOARD_PWRKEY_PIN);
+    CHECK(reset >= 0 && pwrkey >= 0 && reset < pwrkey);
+    CHECK(fake.on);
+    // Without the reset the modem stays off until the AT handshake gives up
+    CHECK(took < AT_INIT_TIMEOUT_MS);
+    if (failCmux) {
+        CHECK(!mm.isMuxOpen());
+    }
+
+    hostOnDigitalWrite(nullptr);
+    hostAttachUart(1, nullptr);
+    Preferences::hostErase();
+}
+
+int main() {
+    recovers("ATE0 failed", true, false);
+    #if MODEM_CMUX_ENABLED
+    recovers("CMUX did not open", false, true);
+    #endif
+    return hostTestResult("modem_init_recovery");
+}
@@ -0,0 +1,84 @@
+// Outbox NVS spill: delivery order, and no loss across a reset before PUBACK.
+#include "HostTest.h"
+#include "mqtt/Outbox.h"
+#include <Preferences.h>
+
+static bool pushAck(Outbox& outbox, const char* text, uint8_t flags = OUTBOX_FLAG_SPILL) {
+    return outbox.push(OUTBOX_TOPIC_ACK, text, strlen(text), OUTBOX_PRIORITY_HIGH, 1, flags);
+}
+
+static bool peekIs(Outbox& outbox, const char* text) {
+    OutboxMessage* msg = outbox.peek();
+    return msg != nullptr && msg->len == strlen(text) && memcmp(msg->payload, text, msg->len) == 0;
+}
+
+int main() {
+    char text[8];
+    const int total = OUTBOX_SLOTS_HIGH + 4;
+
+    {
+        Outbox outbox;
+        for (int i = 0; i < total; i++) {
+            snprintf(text, sizeof(text), "a%d", i);
+            CHECK(pushAck(outbox, text));
+        }
+        CHECK_EQ(4, outbox.getSpilledCount());
+        CHECK_EQ(total, outbox.depth());
+
+        // Deliver the RAM messages, then peek the first spilled one and "reset"
+        for (int i = 0; i < OUTBOX_SLOTS_HIGH; i++) {
+            snprintf(text, sizeof(text), "a%d", i);
+            CHECK(peekIs(outbox, text));
+            outbox.pop();
+        }
+        snprintf(text, sizeof(text), "a%d", OUTBOX_SLOTS_HIGH);
+        CHECK(peekIs(outbox, text));
+        outbox.peek()->attempts++;
+        CHECK(peekIs(outbox, text));  // the same copy until pop()
+        CHECK_EQ(1, outbox.peek()->attempts);
+    }
+
+    {
+        // After the reset every spilled message is still there, in order
+        Outbox outbox;
+        CHECK_EQ(4, outbox.depth());
+        for (int i = OUTBOX_SLOTS_HIGH; i < total; i++) {
+            snprintf(text, sizeof(text), "a%d", i);
+            CHECK(peekIs(outbox, text));
+            outbox.pop();
+        }
+        CHECK(outbox.peek() == nullptr);
+        CHECK_EQ(0, outbox.depth());
+    }
+
+    {
+        // While the spill is non-empty, messages that may not spill still use free RAM
+        Outbox outbox;
+        for (int i = 0; i < total; i++) {
+            snprintf(text, sizeof(text), "b%d", i);
+            pushAck(outbox, text);
+        }
+        outbox.peek();
+        outbox.pop();
+        CHECK(pushAck(outbox, "plain", 0));
+        CHECK_EQ(0, outbox.getDroppedCount());
+        // Spillable ones still queue behind the spill
+        CHECK(pushAck(outbox, "late"));
+        CHECK_EQ(5, outbox.getSpilledCount());
+
+        const char* last = nullptr;
+        OutboxMessage* msg;
+        int n = 0;
+        while ((msg = outbox.peek()) != nullptr) {
+            last = (msg->len == 4 && memcmp(msg->payload, "late", 4) == 0) ? "late" : nullptr;
+            outbox.pop();
+            n++;
+        }
+        CHECK_EQ(total + 1, n);
+        CHECK(last != nullptr);
+    }
+
+    // Nothing left behind but the journal head/tail
+    CHECK_EQ(2, Preferences::hostKeyCount());
+    return hostTestResult("outbox_spill");
+}
@@ -0,0 +1,218 @@
+// PppSession bring-up: two sessions, each on its own AT queue and scripted modem, stepped interleaved.
+#include "HostTest.h"
+#include "ppp/PppSession.h"
+#include "util/BootReport.h"
+#include <string>
+#include <vector>
+
+void BootReport::mark(BootPhase phase) {
+    (void)phase;
+}
+
+// Answers the bring-up commands like an A7670 would; replies are queued until
+// the next read, so they arrive on a later AtQueue::poll()
+class FakeModem : public HardwareSerial {
+public:
+    FakeModem(const char* ip)
+        : HardwareSerial(1), ip(ip), registration(2), netOpen(false), netOpenFailures(0), ipPolls(0), pos(0) {}
+
+    int available() override { return (int)(in.size() - pos); }
+    int read() override { return pos < in.size() ? (uint8_t)in[pos++] : -1; }
+    int peek() override { return pos < in.size() ? (uint8_t)in[pos] : -1; }
+    size_t read(uint8_t* buffer, size_t size) override {
+        size_t n = std::min(size, in.size() - pos);
+        memcpy(buffer, in.data() + pos, n);
+        pos += n;
+        return n;
+    }
+    size_t write(uint8_t c) override {
+        if (c == '\n') {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            commands.push_back(line);
+            answer(line);
+            line.clear();
+        } else {
+            line += (char)c;
+        }
+        return 1;
+    }
+    using Print::write;
+
+    void urc(const std::string& text) { in += "\r\n" + text + "\r\n"; }
+
+    std::string ip;
+    int registration;
+    bool netOpen;
+    int netOpenFailures;    // +NETOPEN results with an error before one succeeds
+    int ipPolls;            // AT+IPADDR answered 0.0.0.0 this many times first
+    std::vector<std::string> commands;
+
+private:
+    void answer(const std::string& cmd) {
+        if (cmd == "AT+CREG?") {
+            in += "\r\n+CREG: 0," + std::to_string(registration) + "\r\n\r\nOK\r\n";
+        } else if (cmd.compare(0, 11, "AT+CGDCONT=") == 0) {
+            in += "\r\nOK\r\n";
+        } else if (cmd == "AT+NETOPEN") {
+            if (netOpen) {
+                in += "\r\n+IP ERROR: Network is already opened\r\n\r\nERROR\r\n";
+            } else if (netOpenFailures > 0) {
+                netOpenFailures--;
+                in += "\r\nOK\r\n\r\n+NETOPEN: 1\r\n";
+            } else {
+                netOpen = true;
+                in += "\r\nOK\r\n\r\n+NETOPEN: 0\r\n";
+            }
+        } else if (cmd == "AT+IPADDR") {
+            if (!netOpen) {
+                in += "\r\nERROR\r\n";
+            } else if (ipPolls > 0) {
+                ipPolls--;
+                in += "\r\n+IPADDR: 0.0.0.0\r\n\r\nOK\r\n";
+            } else {
+                in += "\r\n+IPADDR: " + ip + "\r\n\r\nOK\r\n";
+            }
+        } else {
+            in += "\r\nERROR\r\n";
+        }
+    }
+
+    std::string in;
+    std::string line;
+    size_t pos;
+};
+
+struct Rig {
+    explicit Rig(const char* ip) : modem(ip), stream(modem, link), queue(stream), session(queue, link) {}
+
+    // One network loop pass: session first, then the queue (as PppManager and ModemManager run)
+    bool step(unsigned long now) {
+        bool up = session.poll(now);
+        queue.poll(now);
+        return up;
+    }
+
+    size_t count(const char* cmd) const {
+        size_t n = 0;
+        for (size_t i = 0; i < modem.commands.size(); i++) {
+            n += modem.commands[i] == cmd;
+        }
+        return n;
+    }
+
+    FakeModem modem;
+    ModemLinkState link;
+    ModemStream stream;
+    AtQueue queue;
+    PppSession session;
+};
+
+int main() {
+    // Cold start: a registers late (URC), b at once and needs two IP polls
+    {
+        Rig a("10.0.0.1");
+        Rig b("10.0.0.2");
+        b.modem.registration = 1;
+        b.modem.ipPolls = 2;
+        unsigned long now = 1000;
+        a.session.begin(false, now);
+        b.session.begin(false, now);
+
+        bool upA = false, upB = false;
+        unsigned long upAAt = 0, upBAt = 0;
+        for (; now < 60000 && !(upA && upB); now += 10) {
+            if (now == 4000) {
+                a.modem.registration = 1;
+                a.modem.urc("+CREG: 1");
+            }
+            if (!upA && a.step(now)) {
+                upA = true;
+                upAAt = now;
+            }
+            if (!upB && b.step(now)) {
+                upB = true;
+                upBAt = now;
+            }
+        }
+        CHECK(upA && upB);
+        CHECK(upBAt < 4000);
+        CHECK(upAAt >= 4000);
+        CHECK(std::string(a.session.getIpAddress()) == "10.0.0.1");
+        CHECK(std::string(b.session.getIpAddress()) == "10.0.0.2");
+        CHECK_EQ(1, a.link.registration);
+        // Each session talks to its own modem only
+        CHECK_EQ(1, a.count("AT+NETOPEN"));
+        CHECK_EQ(1, b.count("AT+NETOPEN"));
+        CHECK_EQ(1, a.count("AT+IPADDR"));
+        CHECK_EQ(3, b.count("AT+IPADDR"));
+        // a polled registration every PPP_REG_POLL_MS while waiting, no faster
+        CHECK(a.count("AT+CREG?") >= 2 && a.count("AT+CREG?") <= 3000 / PPP_REG_POLL_MS + 1);
+        // Up stays up
+        CHECK(a.step(now) && b.step(now));
+    }
+
+    // Warm boot with the data session still open: no APN or NETOPEN
+    {
+        Rig a("10.0.0.3");
+        Rig b("10.0.0.4");
+        a.modem.registration = 1;
+        a.modem.netOpen = true;
+        b.modem.registration = 2;
+        unsigned long now = 0;
+        a.session.begin(true, now);
+        b.session.begin(true, now);
+        bool upA = false;
+        for (; now < 2000; now += 10) {
+            upA = upA || a.step(now);
+            CHECK(!b.step(now));
+        }
+        CHECK(upA);
+        CHECK(std::string(a.session.getIpAddress()) == "10.0.0.3");
+        CHECK_EQ(0, a.count("AT+NETOPEN"));
+        CHECK_EQ(0, a.count("AT+CGDCONT=1,\"IP\",\"" CELLULAR_APN "\""));
+        // Not registered: b fell back to the full connect and waits
+        CHECK_EQ(0, b.count("AT+IPADDR"));
+        CHECK(b.count("AT+CREG?") >= 2);
+    }
+
+    // +NETOPEN with an error: retried after PPP_ACTIVATE_RETRY_MS; "already opened" counts as open
+    {
+        Rig a("10.0.0.5");
+        a.modem.registration = 5;
+        a.modem.netOpenFailures = 1;
+        unsigned long now = 0;
+        a.session.begin(false, now);
+        bool up = false;
+        for (; now < 30000 && !up; now += 10) {
+            up = a.step(now);
+        }
+        CHECK(up);
+        CHECK(now >= PPP_ACTIVATE_RETRY_MS);
+        CHECK_EQ(2, a.count("AT+NETOPEN"));
+
+        a.session.begin(false, now);
+        up = false;
+        for (unsigned long end = now + 5000; now < end && !up; now += 10) {
+            up = a.step(now);
+        }
+        CHECK(up);
+        CHECK_EQ(3, a.count("AT+NETOPEN"));
+    }
+
+    // Cancelled while a command waits: the queue forgets it, nothing more is sent
+    {
+        Rig a("10.0.0.6");
+        a.modem.registration = 1;
+        a.session.begin(false, 0);
+        a.session.poll(0);
+        CHECK_EQ(1, a.queue.pending());
+        a.session.cancel();
+        CHECK_EQ(0, a.queue.pending());
+        a.queue.poll(10);
+        CHECK_EQ(0, a.modem.commands.size());
+    }
+
+    return hostTestResult("ppp_session");
+}
@@ -0,0 +1,77 @@
+// Protocol parse/serialize cost: the single-pass tokenizer and JsonOut against
+// the ArduinoJson path they replaced. Host timings only show the ratio; run
+// with `make bench`.
+#include "legacy_protocol.h"
+#include <chrono>
+
+static const char* const PAYLOADS[] = {
+    // What the backend sends
+    "{\"requestId\":\"3f2b8c1e-9a4d-4e7b-b1c2-5d6e7f8a9b0c\",\"command\":\"open\","
+    "\"userId\":\"user-8b1f2c3d\",\"issuedAt\":1760600000123}",
+    // Extra keys the firmware ignores, with nesting and escapes
+    "{\"version\":2,\"requestId\":\"3f2b8c1e-9a4d-4e7b-b1c2-5d6e7f8a9b0c\",\"meta\":{\"source\":\"app\","
+    "\"tags\":[\"a\",\"b\",{\"c\":null}],\"note\":\"line\\nbreak \\\"quoted\\\"\"},\"command\":\"open\","
+    "\"userId\":\"user \\u00e9\\u4e2d\",\"issuedAt\":1760600000123,\"trace\":true}",
+};
+
+static const unsigned long ITERATIONS = 200000;
+
+// Keeps results observable so the loops are not optimized away
+static volatile unsigned long sink;
+
+template <typename F>
+static double nsPerCall(F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < ITERATIONS; i++) {
+        f();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+}
+
+static void report(const char* name, double oldNs, double newNs) {
+    printf("%-24s ArduinoJson %8.1f ns   Protocol %8.1f ns   %5.1fx\n", name, oldNs, newNs, oldNs / newNs);
+}
+
+int main() {
+    char out[256];
+
+    for (size_t k = 0; k < sizeof(PAYLOADS) / sizeof(PAYLOADS[0]); k++) {
+        const char* json = PAYLOADS[k];
+        size_t len = strlen(json);
+
+        // Both must agree before their cost is worth comparing
+        CommandResult a, b;
+        if (!legacy::parseCommand(json, len, a) || !Protocol::parseCommand(json, len, b) ||
+            strcmp(a.requestId, b.requestId) != 0 || strcmp(a.command, b.command) != 0 ||
+            strcmp(a.userId, b.userId) != 0 || a.issuedAt != b.issuedAt) {
+            printf("parse mismatch on payload %u\n", (unsigned int)k);
+            return 1;
+        }
+
+        char name[24];
+        snprintf(name, sizeof(name), "parseCommand #%u", (unsigned int)k);
+        double oldNs = nsPerCall([&] {
+            CommandResult r;
+            sink += legacy::parseCommand(json, len, r);
+        });
+        double newNs = nsPerCall([&] {
+            CommandResult r;
+            sink += Protocol::parseCommand(json, len, r);
+        });
+        report(name, oldNs, newNs);
+    }
+
+    const char* id = "3f2b8c1e-9a4d-4e7b-b1c2-5d6e7f8a9b0c";
+    report("createAck",
+           nsPerCall([&] { sink += legacy::createAck(id, false, "COOLDOWN", out, sizeof(out), 4500); }),
+           nsPerCall([&] { sink += Protocol::createAck(id, false, "COOLDOWN", out, sizeof(out), 4500); }));
+    report("createStatus",
+           nsPerCall([&] {
+               sink += legacy::createStatus("gate-01", true, 123456789UL, -71, "1.4.2", out, sizeof(out), 3, 0, 0);
+           }),
+           nsPerCall([&] {
+               sink += Protocol::createStatus("gate-01", true, 123456789UL, -71, "1.4.2", out, sizeof(out), 3, 0, 0);
+           }));
+    return 0;
+}
@@ -0,0 +1,90 @@
+// createAck / createStatus against ArduinoJson's serializeJson: same bytes and
+// same return value for escapes, optional fields and every truncation length.
+#include "HostTest.h"
+#include "legacy_protocol.h"
+#include <limits.h>
+#include <string>
+
+static const size_t BUF = 320;
+static const uint8_t FILL = 0xA5;
+
+// Serialize with both into buffers of every size up to BUF and compare them whole
+template <typename Old, typename New>
+static void compare(const char* what, Old oldFn, New newFn) {
+    char oldOut[BUF], newOut[BUF];
+    for (size_t size = 1; size <= BUF; size++) {
+        memset(oldOut, FILL, sizeof(oldOut));
+        memset(newOut, FILL, sizeof(newOut));
+        size_t oldLen = oldFn(oldOut, size);
+        size_t newLen = newFn(newOut, size);
+        if (oldLen != newLen || memcmp(oldOut, newOut, sizeof(oldOut)) != 0) {
+            printf("%s: differs at buffer size %u\n  ArduinoJson: %.*s\n  Protocol:    %.*s\n", what,
+                   (unsigned int)size, (int)oldLen, oldOut, (int)newLen, newOut);
+            hostTestFailures++;
+            return;
+        }
+        if (size == BUF) {
+            CHECK(newLen + 1 < BUF);  // the largest buffer holds the whole message
+        }
+    }
+}
+
+static void ack(const char* what, const char* requestId, bool ok, const char* errorCode,
+                uint32_t retryAfterMs = 0, unsigned long long scheduledAt = 0) {
+    compare(what,
+            [&](char* out, size_t size) {
+                return legacy::createAck(requestId, ok, errorCode, out, size, retryAfterMs, scheduledAt);
+            },
+            [&](char* out, size_t size) {
+                return Protocol::createAck(requestId, ok, errorCode, out, size, retryAfterMs, scheduledAt);
+            });
+}
+
+static void status(const char* what, const char* deviceId, bool online, unsigned long updatedAt, int rssi,
+                   const char* fwVersion, long errors = -1, long outboxDepth = -1, long outboxAgeMs = -1) {
+    compare(what,
+            [&](char* out, size_t size) {
+                return legacy::createStatus(deviceId, online, updatedAt, rssi, fwVersion, out, size,
+                                            errors, outboxDepth, outboxAgeMs);
+            },
+            [&](char* out, size_t size) {
+                return Protocol::createStatus(deviceId, online, updatedAt, rssi, fwVersion, out, size,
+                                              errors, outboxDepth, outboxAgeMs);
+            });
+}
+
+int main() {
+    const char* id = "3f2b8c1e-9a4d-4e7b-b1c2-5d6e7f8a9b0c";
+
+    // Optional fields
+    ack("ack ok", id, true, nullptr);
+    ack("ack ok ignores errorCode", id, true, "COOLDOWN");
+    ack("ack error", id, false, "RELAY_FAIL");
+    ack("ack error without code", id, false, nullptr);
+    ack("ack cooldown", id, false, "COOLDOWN", 4500);
+    ack("ack scheduled", id, true, nullptr, 0, 1760600000123ULL);
+    ack("ack both hints", id, false, "COOLDOWN", UINT32_MAX, ULLONG_MAX);
+    ack("ack null requestId", nullptr, false, "BAD_PAYLOAD");
+    ack("ack empty requestId", "", false, "BAD_PAYLOAD");
+
+    // Escapes: the ArduinoJson set, other control characters, '/', DEL and UTF-8 as-is
+    ack("ack escapes", "q\"b\\s/n\nr\rt\tb\bf\f", false, "BAD_PAYLOAD");
+    ack("ack raw bytes", "\x01\x1f\x7f \xc3\xa9\xe4\xb8\xad", false, "BAD_PAYLOAD");
+
+    status("status minimal", "gate-01", true, 0, 0, nullptr);
+    status("status full", "gate-01", true, 123456789UL, -71, "1.4.2", 3, 0, 0);
+    status("status offline", "gate-01", false, ULONG_MAX, 31, "", 0, 12, 600000);
+    status("status rssi limits", "gate-01", true, 1, INT_MIN, nullptr, LONG_MAX, LONG_MAX, LONG_MAX);
+    status("status rssi max", "gate-01", true, 1, INT_MAX, nullptr);
+    status("status escapes", "gate \"01\"\\\n", true, 42, -113, "v1\t\"rc\"");
+    status("status null deviceId", nullptr, true, 42, 0, nullptr);
+
+    // No room at all: nothing written
+    char none[1] = { (char)FILL };
+    CHECK_EQ(0, Protocol::createAck(id, true, nullptr, none, 0));
+    CHECK_EQ(FILL, (uint8_t)none[0]);
+    CHECK_EQ(0, Protocol::createStatus("gate-01", true, 1, 0, nullptr, none, 0));
+    CHECK_EQ(FILL, (uint8_t)none[0]);
+
+    return hostTestResult("protocol_json");
+}
@@ -0,0 +1,152 @@
+// Command tokenizer: field extraction, escapes, missing and wrong-typed fields,
+// the requestId kept for the BAD_PAYLOAD ACK, and malformed skipped values.
+#include "HostTest.h"
+#include "protocol/Protocol.h"
+#include <string>
+
+static std::string text(const Span& span) {
+    return std::string(span.ptr, span.len);
+}
+
+static bool tokenize(const std::string& json, CommandFields& fields) {
+    return Protocol::tokenizeCommand(json.data(), json.size(), fields);
+}
+
+// A valid command with value as an extra, unknown field
+static std::string withExtra(const std::string& value) {
+    return "{\"requestId\":\"r1\",\"extra\":" + value +
+           ",\"command\":\"open\",\"userId\":\"u1\",\"issuedAt\":1}";
+}
+
+static std::string nested(int depth) {
+    return std::string(depth, '[') + "1" + std::string(depth, ']');
+}
+
+int main() {
+    // Fields are located as spans over the payload, whitespace and order aside
+    {
+        // Spans point into the payload: keep it alive while they are read
+        std::string json = " { \"userId\" : \"u-7\" ,\n\t\"issuedAt\":1700000000123,"
+                           "\"command\":\"open\", \"requestId\":\"550e8400-e29b-41d4-a716-446655440000\" } trailing";
+        CommandFields f;
+        CHECK(tokenize(json, f));
+        CHECK_EQ(CMD_FIELD_ALL, f.found);
+        CHECK(text(f.requestId) == "550e8400-e29b-41d4-a716-446655440000");
+        CHECK(text(f.command) == "open");
+        CHECK(text(f.userId) == "u-7");
+        CHECK(f.issuedAt == 1700000000123ULL);
+
+        CommandResult r;
+        CHECK(Protocol::parseCommand("{\"requestId\":\"a\",\"command\":\"open\",\"userId\":\"b\",\"issuedAt\":1.7e12}", r));
+        CHECK(r.valid);
+        CHECK(std::string(r.command) == "open");
+        CHECK(r.issuedAt == 1700000000000ULL);
+    }
+
+    // Escapes stay in the span and are decoded on copy
+    {
+        std::string json = "{\"requestId\":\"a\\\"b\\\\c\\/d\\n\\u0041\\u00e9\\u20ac\"}";
+        CommandFields f;
+        CHECK(tokenize(json, f));
+        CHECK(text(f.requestId) == "a\\\"b\\\\c\\/d\\n\\u0041\\u00e9\\u20ac");
+        CommandResult r;
+        CHECK(!Protocol::parseCommand(json.c_str(), r));
+        CHECK(std::string(r.requestId) == "a\"b\\c/d\nA\xc3\xa9\xe2\x82\xac");
+
+        // Invalid escapes, raw control characters and short \u sequences do not tokenize
+        CHECK(!tokenize("{\"requestId\":\"a\\x\"}", f));
+        CHECK(!tokenize("{\"requestId\":\"a\\u12G4\"}", f));
+        CHECK(!tokenize("{\"requestId\":\"a\\u12\"}", f));
+        CHECK(!tokenize("{\"requestId\":\"a\tb\"}", f));
+        CHECK(!tokenize("{\"requestId\":\"abc", f));
+    }
+
+    // Missing and wrong-typed fields: well formed, but their bit is not set
+    {
+        CommandFields f;
+        CHECK(tokenize("{\"requestId\":\"r\",\"command\":\"open\",\"issuedAt\":5}", f));
+        CHECK_EQ(CMD_FIELD_REQUEST_ID | CMD_FIELD_COMMAND | CMD_FIELD_ISSUED_AT, f.found);
+
+        CHECK(tokenize("{\"requestId\":7,\"command\":[\"open\"],\"userId\":null,\"issuedAt\":\"5\"}", f));
+        CHECK_EQ(0, f.found);
+
+        // A later duplicate wins, including one of the wrong type
+        std::string json = "{\"command\":\"open\",\"command\":false,\"userId\":1,\"userId\":\"u\"}";
+        CHECK(tokenize(json, f));
+        CHECK_EQ(CMD_FIELD_USER_ID, f.found);
+        CHECK(text(f.userId) == "u");
+
+        CHECK(tokenize("{}", f));
+        CHECK_EQ(0, f.found);
+    }
+
+    // The requestId survives a schema error or a malformed payload after it
+    {
+        CommandResult r;
+        CHECK(!Protocol::parseCommand("{\"requestId\":\"keep-me\",\"command\":\"open\",\"issuedAt\":5}", r));
+        CHECK(!r.valid);
+        CHECK(std::string(r.requestId) == "keep-me");
+
+        CHECK(!Protocol::parseCommand("{\"requestId\":\"keep-me\",\"command\":\"open\",\"userId\":", r));
+        CHECK(std::string(r.requestId) == "keep-me");
+
+        CHECK(!Protocol::parseCommand("{\"requestId\":\"keep-me\",\"command\":\"open\" \"userId\":\"u\"}", r));
+        CHECK(std::string(r.requestId) == "keep-me");
+
+        // Truncated to the buffer, like the ACK topic expects
+        CHECK(!Protocol::parseCommand(("{\"requestId\":\"" + std::string(60, 'x') + "\"}").c_str(), r));
+        CHECK_EQ(sizeof(r.requestId) - 1, strlen(r.requestId));
+
+        CHECK(!Protocol::parseCommand("{\"command\":\"open\"", r));
+        CHECK(r.requestId[0] == '\0');
+    }
+
+    // Unknown values of every type are skipped, nested ones included
+    {
+        CommandFields f;
+        const char* valid[] = {
+            "\"s\"", "-1.5e-3", "0", "true", "false", "null", "[]", "{}", "[ ]", "{ }",
+            "{\"a\":[1,{\"b\":null},\"]}\"],\"c\":{\"d\":{}}}", "[[],[{}],\"\\\"\"]",
+        };
+        for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+            CHECK(tokenize(withExtra(valid[i]), f));
+            CHECK_EQ(CMD_FIELD_ALL, f.found);
+        }
+    }
+
+    // Malformed nested values are rejected, not skipped
+    {
+        CommandFields f;
+        const char* malformed[] = {
+            "{\"a\" 1}", "{\"a\":}", "{\"a\":1,}", "{,}", "{1:2}", "{\"a\":1 \"b\":2}", "{\"a\"}",
+            "[1 2]", "[1,]", "[,1]", "[1}", "{\"a\":1]", "[", "{\"a\":[}",
+            "[tru]", "[nul]", "[-]", "[1.]", "[1e]", "[01x]", "[\"\\q\"]", "[x]", "{\"a\":{\"b\":tru}}",
+        };
+        for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) {
+            if (tokenize(withExtra(malformed[i]), f)) {
+                printf("accepted malformed value %s\n", malformed[i]);
+                hostTestFailures++;
+            }
+        }
+    }
+
+    // Nesting up to PROTOCOL_MAX_NESTING (8) levels
+    {
+        CommandFields f;
+        CHECK(tokenize(withExtra(nested(8)), f));
+        CHECK(!tokenize(withExtra(nested(9)), f));
+    }
+
+    // Not an object, or junk where a value or separator belongs
+    {
+        CommandFields f;
+        CHECK(!tokenize("", f));
+        CHECK(!tokenize("[]", f));
+        CHECK(!tokenize("{\"requestId\"}", f));
+        CHECK(!tokenize("{\"requestId\":\"r\",}", f));
+        CHECK(!tokenize("{\"requestId\":\"r\"", f));
+        CHECK(!Protocol::tokenizeCommand(nullptr, 0, f));
+    }
+
+    return hostTestResult("protocol_tokenizer");
+}
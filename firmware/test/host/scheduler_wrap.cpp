@@ -0,0 +1,45 @@
+// Scheduler across the 32-bit millis() wrap (~49.7 days of uptime).
+#include "HostTest.h"
+#include "util/Scheduler.h"
+
+static int periodicRuns = 0;
+static int onceRuns = 0;
+
+static void onPeriodic(void*) { periodicRuns++; }
+static void onOnce(void*) { onceRuns++; }
+
+// millis() on the ESP32 is 32 bits wide
+static unsigned long at(uint32_t start, uint32_t elapsed) {
+    return (uint32_t)(start + elapsed);
+}
+
+int main() {
+    const uint32_t start = 0xFFFFFFFFu - 300000u;  // 5 minutes before the wrap
+    hostSetMillis(start);
+
+    Scheduler scheduler;
+    scheduler.schedulePeriodic(5000, onPeriodic, nullptr, 5000);
+    scheduler.scheduleOnce(400000, onOnce);  // due after the wrap
+
+    for (uint32_t t = 0; t <= 602000; t += 7) {
+        hostSetMillis(at(start, t));
+        scheduler.tick(millis());
+    }
+    CHECK_EQ(120, periodicRuns);
+    CHECK_EQ(1, onceRuns);
+
+    // A one-shot scheduled right at the wrap still fires after its delay
+    onceRuns = 0;
+    hostSetMillis(0xFFFFFFF0u);
+    scheduler.tick(millis());
+    scheduler.scheduleOnce(100, onOnce);
+    hostSetMillis(at(0xFFFFFFF0u, 50));
+    scheduler.tick(millis());
+    CHECK_EQ(0, onceRuns);
+    CHECK(scheduler.msUntilNextDue(millis(), 1000) <= 50);
+    hostSetMillis(at(0xFFFFFFF0u, 110));
+    scheduler.tick(millis());
+    CHECK_EQ(1, onceRuns);
+
+    return hostTestResult("scheduler_wrap");
+}
@@ -0,0 +1,101 @@
+// Status publishing policy: full birth after each connect, deltas on an RSSI
+// bucket or error count change, a bare heartbeat after STATUS_LIVENESS_MS.
+#include "HostTest.h"
+#include "mqtt/StatusSchedule.h"
+
+// Device state as publishStatus() samples it
+struct Device {
+    int rssi;
+    uint32_t errors;
+    size_t outboxDepth;
+};
+
+// One publishStatus() pass at now; a due message is published successfully
+static bool tick(StatusSchedule& schedule, const Device& dev, unsigned long now, StatusPlan& plan) {
+    if (!schedule.due(now, dev.rssi, dev.errors, dev.outboxDepth, plan)) {
+        return false;
+    }
+    schedule.sent(plan, now, dev.rssi, dev.errors, dev.outboxDepth);
+    return true;
+}
+
+int main() {
+    StatusSchedule schedule;
+    Device dev = {-71, 0, 0};
+    StatusPlan plan;
+    unsigned long now = 10000;
+
+    // First pass after connect: the full document
+    CHECK(tick(schedule, dev, now, plan));
+    CHECK(plan.full && plan.withRssi && plan.withErrors && plan.withOutbox);
+
+    // Nothing changed, RSSI moved within its bucket: nothing due
+    now += STATUS_INTERVAL_MS;
+    dev.rssi = -73;
+    CHECK(!tick(schedule, dev, now, plan));
+
+    // RSSI bucket changed: delta with the RSSI only
+    now += STATUS_INTERVAL_MS;
+    dev.rssi = -85;
+    CHECK(tick(schedule, dev, now, plan));
+    CHECK(!plan.full && plan.withRssi && !plan.withErrors && !plan.withOutbox);
+    unsigned long lastSent = now;
+
+    // Error count changed: delta with the errors only
+    now += STATUS_INTERVAL_MS;
+    dev.errors = 2;
+    CHECK(tick(schedule, dev, now, plan));
+    CHECK(!plan.full && !plan.withRssi && plan.withErrors && !plan.withOutbox);
+    lastSent = now;
+
+    // Quiet until STATUS_LIVENESS_MS after the last message, then a bare heartbeat
+    bool sent = false;
+    while (!sent) {
+        now += STATUS_INTERVAL_MS;
+        sent = tick(schedule, dev, now, plan);
+        CHECK(sent == (now - lastSent >= STATUS_LIVENESS_MS));
+    }
+    CHECK(now - lastSent < STATUS_LIVENESS_MS + STATUS_INTERVAL_MS);
+    CHECK(!plan.full && !plan.withRssi && !plan.withErrors && !plan.withOutbox);
+
+    // The heartbeat bounds how long a live device goes unseen: under the 60 s window
+    CHECK(STATUS_LIVENESS_MS + STATUS_INTERVAL_MS <= 60000);
+
+    // Outbox backlog rides along with a delta, and once more when it has drained
+    now += STATUS_INTERVAL_MS;
+    dev.outboxDepth = 3;
+    dev.errors = 3;
+    CHECK(tick(schedule, dev, now, plan));
+    CHECK(plan.withErrors && plan.withOutbox);
+    now += STATUS_INTERVAL_MS;
+    dev.outboxDepth = 0;
+    dev.errors = 4;
+    CHECK(tick(schedule, dev, now, plan));
+    CHECK(plan.withErrors && plan.withOutbox);
+    now += STATUS_INTERVAL_MS;
+    dev.errors = 5;
+    CHECK(tick(schedule, dev, now, plan));
+    CHECK(plan.withErrors && !plan.withOutbox);
+
+    // Reconnect: the full birth again, although nothing changed
+    schedule.requestFull();
+    now += 1000;
+    CHECK(schedule.due(now, dev.rssi, dev.errors, dev.outboxDepth, plan));
+    CHECK(plan.full && plan.withRssi && plan.withErrors && plan.withOutbox);
+    // Birth publish failed (not recorded as sent): the next pass retries it
+    now += STATUS_INTERVAL_MS;
+    CHECK(tick(schedule, dev, now, plan));
+    CHECK(plan.full);
+    now += STATUS_INTERVAL_MS;
+    CHECK(!tick(schedule, dev, now, plan));
+
+    // Unknown RSSI has its own bucket: losing the signal is reported
+    now += STATUS_INTERVAL_MS;
+    dev.rssi = 0;
+    CHECK(tick(schedule, dev, now, plan));
+    CHECK(plan.withRssi && !plan.withErrors);
+    CHECK_EQ(0, StatusSchedule::rssiBucket(0));
+    CHECK(StatusSchedule::rssiBucket(-113) != 0);
+
+    return hostTestResult("status_schedule");
+}
@@ -0,0 +1,155 @@
+// Minimal Arduino core for host tests: only what the modules under test use.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define DEC 10
+#define HEX 16
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define SERIAL_8N1 0x800001c
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            write(buffer[i]);
+        }
+        return size;
+    }
+    size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    virtual void flush() {}
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(long v, int base = DEC) { return printNumber(base == HEX ? "%lx" : "%ld", v); }
+    size_t print(unsigned long v, int base = DEC) { return printNumber(base == HEX ? "%lx" : "%lu", v); }
+    size_t print(double v, int digits = 2) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", digits, v);
+        return write(buf);
+    }
+    template <typename T> size_t println(T v) { return print(v) + println(); }
+    template <typename T> size_t println(T v, int base) { return print(v, base) + println(); }
+    size_t println() { return write("\r\n"); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+    template <typename T> size_t printNumber(const char* fmt, T v) {
+        char buf[24];
+        snprintf(buf, sizeof(buf), fmt, v);
+        return write(buf);
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    void setTimeout(unsigned long) {}
+};
+
+enum hardwareSerial_error_t {
+    UART_NO_ERROR,
+    UART_BREAK_ERROR,
+    UART_BUFFER_FULL_ERROR,
+    UART_FIFO_OVF_ERROR,
+    UART_FRAME_ERROR,
+    UART_PARITY_ERROR
+};
+
+/**
+ * Far end of a UART owned by the module under test (see hostAttachUart()).
+ */
+class HostUartPeer {
+public:
+    virtual ~HostUartPeer() {}
+    virtual int pending() = 0;          // bytes waiting for the ESP32
+    virtual int receive() = 0;          // next of them, -1 if none
+    virtual int peekNext() = 0;
+    virtual void transmit(uint8_t c) = 0;
+};
+
+// Route UART uart to peer (nullptr: back to no input, output discarded)
+void hostAttachUart(int uart, HostUartPeer* peer);
+HostUartPeer* hostUartPeer(int uart);
+
+/**
+ * Talks to the peer attached to its UART number; without one it discards output
+ * and never has input. Tests also derive from it to script a peer directly.
+ */
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int uart) : uart(uart) {}
+    void begin(unsigned long, uint32_t = SERIAL_8N1, int = -1, int = -1) {}
+    void end() {}
+    void updateBaudRate(unsigned long) {}
+    void onReceiveError(void (*)(hardwareSerial_error_t)) {}
+    int available() override {
+        HostUartPeer* peer = hostUartPeer(uart);
+        return peer != nullptr ? peer->pending() : 0;
+    }
+    int read() override {
+        HostUartPeer* peer = hostUartPeer(uart);
+        return peer != nullptr ? peer->receive() : -1;
+    }
+    int peek() override {
+        HostUartPeer* peer = hostUartPeer(uart);
+        return peer != nullptr ? peer->peekNext() : -1;
+    }
+    virtual size_t read(uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        int c;
+        while (n < size && (c = read()) >= 0) {
+            buffer[n++] = (uint8_t)c;
+        }
+        return n;
+    }
+    size_t write(uint8_t c) override {
+        HostUartPeer* peer = hostUartPeer(uart);
+        if (peer != nullptr) {
+            peer->transmit(c);
+        }
+        return 1;
+    }
+    using Print::write;
+    operator bool() const { return true; }
+
+private:
+    int uart;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+
+// Host clock for tests: millis() returns this value (micros() follows it)
+void hostSetMillis(unsigned long ms);
+
+// Called on every digitalWrite() (nullptr: none)
+void hostOnDigitalWrite(void (*hook)(int pin, int value));
+
+#endif // HOST_ARDUINO_H
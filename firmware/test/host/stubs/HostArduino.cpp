@@ -0,0 +1,55 @@
+#include "Arduino.h"
+#include <stdarg.h>
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+
+static unsigned long hostMillis = 0;
+static void (*pinHook)(int pin, int value) = nullptr;
+static HostUartPeer* uartPeers[3] = { nullptr, nullptr, nullptr };
+
+void hostAttachUart(int uart, HostUartPeer* peer) {
+    if (uart >= 0 && uart < 3) {
+        uartPeers[uart] = peer;
+    }
+}
+
+HostUartPeer* hostUartPeer(int uart) {
+    return (uart >= 0 && uart < 3) ? uartPeers[uart] : nullptr;
+}
+
+size_t Print::printf(const char* fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n < 0) {
+        return 0;
+    }
+    return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+void hostSetMillis(unsigned long ms) { hostMillis = ms; }
+unsigned long millis() { return hostMillis; }
+unsigned long micros() { return hostMillis * 1000UL; }
+void delay(unsigned long ms) { hostMillis += ms; }
+void yield() {}
+void pinMode(int, int) {}
+void hostOnDigitalWrite(void (*hook)(int pin, int value)) { pinHook = hook; }
+void digitalWrite(int pin, int value) {
+    if (pinHook != nullptr) {
+        pinHook(pin, value);
+    }
+}
+int digitalRead(int) { return 0; }
+
+BaseType_t xTaskCreatePinnedToCore(void (*)(void*), const char*, uint32_t, void*, UBaseType_t,
+                                   TaskHandle_t*, BaseType_t) {
+    return pdFAIL;  // Log falls back to draining synchronously
+}
+void vTaskDelay(TickType_t) {}
+void vTaskDelete(TaskHandle_t) {}
+void xTaskNotifyGive(TaskHandle_t) {}
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+TickType_t xTaskGetTickCount() { return (TickType_t)hostMillis; }
@@ -0,0 +1,104 @@
+#include "Preferences.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <string.h>
+
+typedef std::map<std::string, std::vector<uint8_t> > Store;
+
+static Store& store() {
+    static Store s;
+    return s;
+}
+
+static std::string fullKey(const char* ns, const char* key) {
+    return std::string(ns) + "/" + key;
+}
+
+Preferences::Preferences() : open(false), readOnly(false) {
+    ns[0] = '\0';
+}
+
+bool Preferences::begin(const char* name, bool ro) {
+    strncpy(ns, name, sizeof(ns) - 1);
+    ns[sizeof(ns) - 1] = '\0';
+    open = true;
+    readOnly = ro;
+    return true;
+}
+
+void Preferences::end() {
+    open = false;
+}
+
+uint8_t Preferences::getUChar(const char* key, uint8_t defaultValue) {
+    uint8_t v;
+    return getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : defaultValue;
+}
+
+size_t Preferences::putUChar(const char* key, uint8_t value) {
+    return putBytes(key, &value, sizeof(value));
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    uint32_t v;
+    return getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : defaultValue;
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return putBytes(key, &value, sizeof(value));
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    Store::const_iterator it = store().find(fullKey(ns, key));
+    return (open && it != store().end()) ? it->second.size() : 0;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t maxLen) {
+    Store::const_iterator it = store().find(fullKey(ns, key));
+    if (!open || it == store().end() || it->second.size() > maxLen) {
+        return 0;
+    }
+    memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (!open || readOnly) {
+        return 0;
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(value);
+    store()[fullKey(ns, key)] = std::vector<uint8_t>(p, p + len);
+    return len;
+}
+
+bool Preferences::isKey(const char* key) {
+    return open && store().count(fullKey(ns, key)) > 0;
+}
+
+bool Preferences::remove(const char* key) {
+    return open && !readOnly && store().erase(fullKey(ns, key)) > 0;
+}
+
+bool Preferences::clear() {
+    if (!open || readOnly) {
+        return false;
+    }
+    std::string prefix = std::string(ns) + "/";
+    for (Store::iterator it = store().begin(); it != store().end();) {
+        if (it->first.compare(0, prefix.size(), prefix) == 0) {
+            store().erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    return true;
+}
+
+size_t Preferences::hostKeyCount() {
+    return store().size();
+}
+
+void Preferences::hostErase() {
+    store().clear();
+}
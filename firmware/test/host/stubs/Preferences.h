@@ -0,0 +1,36 @@
+// In-memory NVS for host tests. Contents survive across Preferences objects
+// (a "reboot" in a test is a fresh instance of the module under test).
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Preferences {
+public:
+    Preferences();
+    bool begin(const char* name, bool readOnly = false);
+    void end();
+
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+    size_t putUChar(const char* key, uint8_t value);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buffer, size_t maxLen);
+    size_t putBytes(const char* key, const void* value, size_t len);
+    bool isKey(const char* key);
+    bool remove(const char* key);
+    bool clear();
+
+    // Test helpers: number of stored keys, and wipe everything
+    static size_t hostKeyCount();
+    static void hostErase();
+
+private:
+    char ns[16];
+    bool open;
+    bool readOnly;
+};
+
+#endif // HOST_PREFERENCES_H
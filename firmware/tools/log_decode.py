@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Decode the firmware's binary log frames (src/util/Log.h) back into text.
+
+Plain Serial text (boot banner, modules not using LOG) is passed through as is.
+
+Usage:
+  python3 tools/log_decode.py capture.bin          # decode a raw capture
+  python3 tools/log_decode.py --port /dev/ttyUSB0  # live (needs pyserial)
+  cat /dev/ttyUSB0 | python3 tools/log_decode.py   # live from stdin
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_FORMATS = os.path.join(HERE, '..', 'src', 'util', 'LogFormats.h')
+
+FRAME_SYNC = 0xFE
+HEADER_LEN = 9  # sync, len, flags, timestamp (4), id (2)
+FLAG_TRUNCATED = 0x01
+
+ARG_I32, ARG_U32, ARG_I64, ARG_U64, ARG_STR = 1, 2, 3, 4, 5
+ARG_STRUCTS = {
+    ARG_I32: struct.Struct('<i'),
+    ARG_U32: struct.Struct('<I'),
+    ARG_I64: struct.Struct('<q'),
+    ARG_U64: struct.Struct('<Q'),
+}
+
+ENTRY_RE = re.compile(r'^\s*X\((\w+),\s*(\w+),\s*"((?:[^"\\]|\\.)*)"\)')
+# printf conversion -> Python %-format (length modifiers dropped)
+SPEC_RE = re.compile(r'%([-+ 0#]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z)?([diuxXsc%])')
+
+
+def load_formats(path):
+    formats = []
+    with open(path, encoding='utf-8') as f:
+        for line in f:
+            match = ENTRY_RE.match(line)
+            if match:
+                name, level, fmt = match.groups()
+                fmt = fmt.encode('utf-8').decode('unicode_escape')
+                formats.append((name, level.replace('LOG_LEVEL_', ''), fmt))
+    return formats
+
+
+def parse_args(payload):
+    args = []
+    pos = 0
+    while pos < len(payload):
+        tag = payload[pos]
+        pos += 1
+        if tag == ARG_STR:
+            n = payload[pos]
+            args.append(payload[pos + 1:pos + 1 + n].decode('utf-8', 'replace'))
+            pos += 1 + n
+        elif tag in ARG_STRUCTS:
+            s = ARG_STRUCTS[tag]
+            args.append(s.unpack_from(payload, pos)[0])
+            pos += s.size
+        else:
+            args.append('<bad tag %d>' % tag)
+            break
+    return args
+
+
+def format_entry(fmt, args, truncated):
+    values = iter(args)
+
+    def convert(match):
+        flags, conv = match.groups()
+        if conv == '%':
+            return '%'
+        try:
+            value = next(values)
+        except StopIteration:
+            return '?'
+        if conv in 'diu':
+            conv = 'd'
+        if conv == 'c' and isinstance(value, int):
+            value = chr(value & 0xFF)
+        if conv in 'xXdc' and isinstance(value, str):
+            conv = 's'
+        return ('%' + flags + conv) % value
+
+    text = SPEC_RE.sub(convert, fmt)
+    return text + (' [truncated]' if truncated else '')
+
+
+class Decoder:
+    def __init__(self, formats, out):
+        self.formats = formats
+        self.out = out
+        self.buf = bytearray()
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            sync = self.buf.find(bytes([FRAME_SYNC]))
+            if sync < 0:
+                self.text(self.buf)
+                self.buf.clear()
+                return
+            if sync > 0:
+                self.text(self.buf[:sync])
+                del self.buf[:sync]
+            if len(self.buf) < 2 or len(self.buf) < HEADER_LEN + self.buf[1]:
+                return  # wait for the rest of the frame
+            length, flags, timestamp, log_id = struct.unpack_from('<BBIH', self.buf, 1)
+            payload = bytes(self.buf[HEADER_LEN:HEADER_LEN + length])
+            del self.buf[:HEADER_LEN + length]
+            self.frame(timestamp, log_id, flags, payload)
+
+    def text(self, data):
+        if data:
+            self.out.write(data.decode('utf-8', 'replace'))
+
+    def frame(self, timestamp, log_id, flags, payload):
+        args = parse_args(payload)
+        if log_id >= len(self.formats):
+            line = '<unknown log id %d> %r' % (log_id, args)
+        else:
+            name, level, fmt = self.formats[log_id]
+            line = format_entry(fmt, args, flags & FLAG_TRUNCATED)
+            if name == 'LOG_STARTED' and args and args[0] != len(self.formats):
+                line += ' [WARNING: firmware has %d formats, %s has %d]' % (
+                    args[0], 'LogFormats.h', len(self.formats))
+            if level in ('WARN', 'ERROR'):
+                line = '%s %s' % (level, line)
+        self.out.write('%10.3f %s\n' % (timestamp / 1000.0, line))
+        self.out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('input', nargs='?', help='raw capture file (default: stdin)')
+    parser.add_argument('--port', help='serial port to read live (requires pyserial)')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--formats', default=DEFAULT_FORMATS, help='path to LogFormats.h')
+    opts = parser.parse_args()
+
+    decoder = Decoder(load_formats(opts.formats), sys.stdout)
+
+    if opts.port:
+        import serial  # pyserial
+        source = serial.Serial(opts.port, opts.baud, timeout=0.1)
+        read = lambda: source.read(256)
+    else:
+        source = open(opts.input, 'rb') if opts.input else sys.stdin.buffer
+        read = lambda: source.read1(256) if hasattr(source, 'read1') else source.read(256)
+
+    try:
+        while True:
+            data = read()
+            if not data:
+                if opts.port:
+                    continue
+                break
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
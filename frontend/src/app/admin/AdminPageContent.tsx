@@ -409,6 +409,7 @@ export default function AdminPageContent({ defaultTab }: AdminPageContentProps)
         try {
             const data = await apiRequest<DeviceStatusResponse>("/admin/device-status");
             // Apply staleness check - device must be marked online AND seen within last 60 seconds
+            // (heartbeat is 45 s; a dropped link is also reported by the broker Last Will)
             const now = Date.now();
             const STALE_THRESHOLD_MS = 60000; // 60 seconds
             const processedData: DeviceStatusResponse = {
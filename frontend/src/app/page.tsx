@@ -40,7 +40,8 @@ export default function HomePage() {
             try {
                 const data = await apiRequest<DeviceStatusResponse>("/admin/device-status");
                 // Check if any device is truly online
-                // Device must be marked online AND seen within last 60 seconds
+                // Device must be marked online AND seen within last 60 seconds (heartbeat is 45 s;
+                // a dropped link is also reported by the broker Last Will, online:false)
                 const now = Date.now();
                 const STALE_THRESHOLD_MS = 60000; // 60 seconds
                 const anyOnline = data.items.some(device => {
@@ -97,6 +97,13 @@ async function main() {
         clientId: `mcu-sim-${MCU_DEVICE_ID}-${Date.now()}`,
         reconnectPeriod: 5000,
         connectTimeout: 10000,
+        // Like the firmware: the broker reports us offline if the link drops
+        will: {
+            topic: MQTT_STATUS_TOPIC,
+            payload: JSON.stringify({ deviceId: MCU_DEVICE_ID, online: false, updatedAt: Date.now() }),
+            qos: 1,
+            retain: false,
+        },
     });
 
     let statusInterval = null;